@@ -7,11 +7,13 @@ import etl_pb2_grpc
 
 SERVER_ADDRESS = "192.168.0.14:50051"
 
+# Linhas por mensagem no envio em stream
+TAMANHO_LOTE = 1000
+
 cep_ilhas = list(range(11, 31))
 cep_regioes = [int(f"{ilha:02d}{r:03d}") for ilha in cep_ilhas for r in range(1, 6)]
 
-def gerar_dados_oms(rows=1000):
-    linhas = []
+def gerar_linhas_oms(rows=1000):
     base_data = datetime.today()
     for _ in range(rows):
         linha = etl_pb2.Linha(
@@ -24,11 +26,9 @@ def gerar_dados_oms(rows=1000):
                 data=(base_data - timedelta(days=random.randint(0, 6))).strftime("%d-%m-%Y")
             )
         )
-        linhas.append(linha)
-    return linhas
+        yield linha
 
-def gerar_dados_hospital(rows=500):
-    linhas = []
+def gerar_linhas_hospital(rows=500):
     base_data = datetime.today()
     for _ in range(rows):
         linha = etl_pb2.Linha(
@@ -45,11 +45,9 @@ def gerar_dados_hospital(rows=500):
                 sintoma4=random.choice([1, 0]),
             )
         )
-        linhas.append(linha)
-    return linhas
+        yield linha
 
-def gerar_dados_secretaria(rows=1000):
-    linhas = []
+def gerar_linhas_secretaria(rows=1000):
     base_data = datetime.today()
     for _ in range(rows):
         linha = etl_pb2.Linha(
@@ -62,8 +60,45 @@ def gerar_dados_secretaria(rows=1000):
                 data=(base_data - timedelta(days=random.randint(0, 6))).strftime("%d-%m-%Y"),
             )
         )
-        linhas.append(linha)
-    return linhas
+        yield linha
+
+# Versões em lista, usadas pelo envio unário (o arquivo inteiro em uma mensagem)
+def gerar_dados_oms(rows=1000):
+    return list(gerar_linhas_oms(rows))
+
+def gerar_dados_hospital(rows=500):
+    return list(gerar_linhas_hospital(rows))
+
+def gerar_dados_secretaria(rows=1000):
+    return list(gerar_linhas_secretaria(rows))
+
+# Gera as mensagens do stream sob demanda: só um lote fica em memória por vez
+def gerar_lotes(origem, nome_arquivo, linhas, tamanho_lote=TAMANHO_LOTE):
+    lote = []
+    for linha in linhas:
+        lote.append(linha)
+        if len(lote) == tamanho_lote:
+            yield etl_pb2.DadosRequest(origem=origem, nome_arquivo=nome_arquivo, dados=lote)
+            lote = []
+    if lote:
+        yield etl_pb2.DadosRequest(origem=origem, nome_arquivo=nome_arquivo, dados=lote)
+
+def main_stream():
+    channel = grpc.insecure_channel(SERVER_ADDRESS)
+    stub = etl_pb2_grpc.ETLServiceStub(channel)
+
+    try:
+        response = stub.EnviarDadosStream(gerar_lotes("oms", "oms_virtual.txt", gerar_linhas_oms(10000)))
+        print(f"Resposta OMS: {response.mensagem}")
+
+        response = stub.EnviarDadosStream(gerar_lotes("hospital", "hospital_virtual.csv", gerar_linhas_hospital(random.randint(5000, 8000))))
+        print(f"Resposta Hospital: {response.mensagem}")
+
+        response = stub.EnviarDadosStream(gerar_lotes("secretaria", "secretaria_virtual.db", gerar_linhas_secretaria(20000)))
+        print(f"Resposta Secretaria: {response.mensagem}")
+
+    except grpc.RpcError as e:
+        print(f"Erro gRPC: {e}")
 
 def main():
     channel = grpc.insecure_channel(SERVER_ADDRESS)
@@ -91,4 +126,8 @@ def main():
 
 
 if __name__ == "__main__":
-    main()
\ No newline at end of file
+    import sys
+    if "--stream" in sys.argv:
+        main_stream()
+    else:
+        main()
\ No newline at end of file
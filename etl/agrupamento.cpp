@@ -0,0 +1,502 @@
+#include "agrupamento.hpp"
+#include "executor.hpp"
+#include "trace.hpp"
+#include "tabela_hash.hpp"
+#include "ordenacao.hpp"
+#include "topologia.hpp"
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// células string vazias ou "null"/"NaN" contam como ausentes
+static bool celulaNula(const Cell& valor)
+{
+    if (!holds_alternative<string>(valor)) return false;
+    const string& s = get<string>(valor);
+    return s.empty() || s == "null" || s == "NULL" || s == "NaN";
+}
+
+void EstadoAgregado::adicionar(const Cell& valor, size_t linha)
+{
+    if (linha < linhaPrimeiro)
+    {
+        linhaPrimeiro = linha;
+        primeiro = valor;
+    }
+    if (linha >= linhaUltimo)
+    {
+        linhaUltimo = linha;
+        ultimo = valor;
+    }
+
+    if (celulaNula(valor)) return;
+    ++contagem;
+
+    if (holds_alternative<string>(valor)) return;
+    const double x = holds_alternative<int>(valor) ? get<int>(valor) : get<double>(valor);
+
+    // Welford: média e m2 numa passada, estável para valores grandes
+    ++n;
+    soma += x;
+    const double delta = x - media;
+    media += delta / n;
+    m2 += delta * (x - media);
+    minimo = min(minimo, x);
+    maximo = max(maximo, x);
+}
+
+void EstadoAgregado::combinar(const EstadoAgregado& outro)
+{
+    if (outro.linhaPrimeiro < linhaPrimeiro)
+    {
+        linhaPrimeiro = outro.linhaPrimeiro;
+        primeiro = outro.primeiro;
+    }
+    if (outro.linhaPrimeiro != numeric_limits<size_t>::max() && outro.linhaUltimo >= linhaUltimo)
+    {
+        linhaUltimo = outro.linhaUltimo;
+        ultimo = outro.ultimo;
+    }
+
+    contagem += outro.contagem;
+    if (outro.n == 0) return;
+
+    // combinação de Chan et al. das médias e somas de quadrados de dois blocos
+    const uint64_t total = n + outro.n;
+    const double delta = outro.media - media;
+    media += delta * outro.n / total;
+    m2 += outro.m2 + delta * delta * (static_cast<double>(n) * outro.n / total);
+    n = total;
+    soma += outro.soma;
+    minimo = min(minimo, outro.minimo);
+    maximo = max(maximo, outro.maximo);
+}
+
+string nomeAgregacao(const Agregacao& agregacao)
+{
+    if (!agregacao.nomeSaida.empty()) return agregacao.nomeSaida;
+
+    const string& col = agregacao.coluna;
+    switch (agregacao.tipo)
+    {
+        case TipoAgregacao::SOMA:          return "Total_" + col;
+        case TipoAgregacao::CONTAGEM:      return col == "*" ? "Contagem" : "Contagem_" + col;
+        case TipoAgregacao::MEDIA:         return "Media_" + col;
+        case TipoAgregacao::MINIMO:        return "Min_" + col;
+        case TipoAgregacao::MAXIMO:        return "Max_" + col;
+        case TipoAgregacao::VARIANCIA:     return "Variancia_" + col;
+        case TipoAgregacao::DESVIO_PADRAO: return "Desvio_" + col;
+        case TipoAgregacao::PRIMEIRO:      return "Primeiro_" + col;
+        case TipoAgregacao::ULTIMO:        return "Ultimo_" + col;
+    }
+    return col;
+}
+
+void somarVetores(double* destino, const double* origem, size_t n)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(destino + i, _mm_add_pd(_mm_loadu_pd(destino + i), _mm_loadu_pd(origem + i)));
+#endif
+    for (; i < n; ++i) destino[i] += origem[i];
+}
+
+bool SomaDensa::cobrir(int chaveMin, int chaveMax)
+{
+    if (contagens.empty())
+    {
+        if (static_cast<int64_t>(chaveMax) - chaveMin >= LIMITE) return false;
+        minimo = chaveMin;
+        const size_t tamanho = static_cast<size_t>(chaveMax - chaveMin) + 1;
+        somas.assign(tamanho, 0.0);
+        contagens.assign(tamanho, 0);
+        if (comDispersao) m2s.assign(tamanho, 0.0);
+        return true;
+    }
+
+    const int64_t maximoAtual = minimo + static_cast<int64_t>(contagens.size()) - 1;
+    const int64_t novoMin = min<int64_t>(chaveMin, minimo);
+    const int64_t novoMax = max<int64_t>(chaveMax, maximoAtual);
+    if (novoMin == minimo && novoMax == maximoAtual) return true;
+    if (novoMax - novoMin >= LIMITE) return false;
+
+    // cresce para os dois lados; a parte antiga é deslocada por (minimo - novoMin)
+    const size_t antes = static_cast<size_t>(minimo - novoMin);
+    const size_t tamanho = static_cast<size_t>(novoMax - novoMin) + 1;
+    auto crescer = [&](auto& v) {
+        using T = typename decay_t<decltype(v)>::value_type;
+        v.insert(v.begin(), antes, T());
+        v.resize(tamanho, T());
+    };
+    crescer(somas);
+    crescer(contagens);
+    if (comDispersao) crescer(m2s);
+    minimo = static_cast<int>(novoMin);
+    return true;
+}
+
+bool SomaDensa::adicionar(int chave, double valor)
+{
+    if (!cobrir(chave, chave)) return false;
+
+    const size_t i = static_cast<size_t>(chave - minimo);
+    if (comDispersao)
+    {
+        // Welford com a média tirada das somas: desvio da média antiga vezes o da nova
+        const double mediaAntiga = contagens[i] ? somas[i] / contagens[i] : 0.0;
+        const double mediaNova = (somas[i] + valor) / (contagens[i] + 1);
+        m2s[i] += (valor - mediaAntiga) * (valor - mediaNova);
+    }
+    somas[i] += valor;
+    ++contagens[i];
+    return true;
+}
+
+bool SomaDensa::acumular(const SomaDensa& outro)
+{
+    if (outro.contagens.empty()) return true;
+    if (!cobrir(outro.minimo, outro.minimo + static_cast<int>(outro.contagens.size()) - 1)) return false;
+
+    const size_t deslocamento = static_cast<size_t>(outro.minimo - minimo);
+    const size_t n = outro.contagens.size();
+    if (comDispersao && outro.comDispersao)
+    {
+        // Chan: m2 = m2a + m2b + delta² * na * nb / (na + nb), antes de somar contagens e somas
+        for (size_t i = 0; i < n; ++i)
+        {
+            const size_t j = deslocamento + i;
+            const double nb = static_cast<double>(outro.contagens[i]);
+            if (nb == 0) continue;
+            const double na = static_cast<double>(contagens[j]);
+            const double delta = na == 0 ? 0.0 : outro.somas[i] / nb - somas[j] / na;
+            m2s[j] += outro.m2s[i] + delta * delta * na * nb / (na + nb);
+        }
+    }
+    somarVetores(somas.data() + deslocamento, outro.somas.data(), n);
+    for (size_t i = 0; i < n; ++i) contagens[deslocamento + i] += outro.contagens[i];
+    return true;
+}
+
+size_t estimarNumGrupos(size_t numLinhas, const function<size_t(size_t)>& hashDaLinha)
+{
+    constexpr size_t AMOSTRA_MAXIMA = 4096;
+    if (numLinhas == 0) return 0;
+
+    const size_t passo = max<size_t>(numLinhas / AMOSTRA_MAXIMA, 1);
+    TabelaHash<size_t, uint32_t> vistas;
+    size_t amostradas = 0;
+    for (size_t i = 0; i < numLinhas; i += passo)
+    {
+        try {
+            ++vistas[hashDaLinha(i)];
+            ++amostradas;
+        } catch (const exception&) {
+            // linha inválida: fica de fora da amostra (o agregador reporta o erro)
+        }
+    }
+    if (amostradas == 0) return 0;
+
+    // Chao1 com correção de viés: grupos vistos + f1(f1 - 1) / 2(f2 + 1), limitado ao número de linhas
+    double f1 = 0, f2 = 0;
+    vistas.paraCada([&](size_t, uint32_t vezes) {
+        f1 += vezes == 1;
+        f2 += vezes == 2;
+    });
+    const double estimativa = vistas.size() + f1 * (f1 - 1) / (2 * (f2 + 1));
+    return static_cast<size_t>(min(estimativa, static_cast<double>(numLinhas)));
+}
+
+size_t particoesRadix(size_t gruposEstimados, size_t bytesPorGrupo, int numThreads)
+{
+    constexpr size_t MAXIMO_PARTICOES = 1024;
+
+    // a TabelaHash fica até 7/8 cheia: conta o espaço dos slots vazios
+    const size_t bytesTabela = gruposEstimados * bytesPorGrupo * 8 / 7;
+    const size_t cache = Topologia::sistema().bytesCacheL2();
+    if (bytesTabela <= cache) return 0;
+
+    const size_t necessarias = (bytesTabela + cache - 1) / cache;
+    return min(max(necessarias, static_cast<size_t>(max(numThreads, 1))), MAXIMO_PARTICOES);
+}
+
+namespace
+{
+    using Chave = vector<Cell>;
+
+    struct HashChave
+    {
+        size_t operator()(const Chave& chave) const
+        {
+            size_t seed = chave.size();
+            for (const Cell& c : chave)
+                seed ^= hash<Cell>()(c) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+            return misturarHash(seed);
+        }
+    };
+
+    struct Grupo
+    {
+        size_t primeiraLinha;
+        vector<EstadoAgregado> estados;
+    };
+
+    using Mapa = TabelaHash<Chave, Grupo, HashChave>;
+
+    // valor final de uma agregação; grupos sem valores numéricos ficam com NaN
+    Cell finalizar(TipoAgregacao tipo, const EstadoAgregado& e)
+    {
+        const double nan = numeric_limits<double>::quiet_NaN();
+        switch (tipo)
+        {
+            case TipoAgregacao::SOMA:          return e.soma;
+            case TipoAgregacao::CONTAGEM:      return static_cast<int>(e.contagem);
+            case TipoAgregacao::MEDIA:         return e.n ? e.media : nan;
+            case TipoAgregacao::MINIMO:        return e.n ? e.minimo : nan;
+            case TipoAgregacao::MAXIMO:        return e.n ? e.maximo : nan;
+            // variância populacional, como nas análises do dashboard
+            case TipoAgregacao::VARIANCIA:     return e.n ? e.m2 / e.n : nan;
+            case TipoAgregacao::DESVIO_PADRAO: return e.n ? sqrt(e.m2 / e.n) : nan;
+            case TipoAgregacao::PRIMEIRO:      return e.primeiro;
+            case TipoAgregacao::ULTIMO:        return e.ultimo;
+        }
+        return nan;
+    }
+
+    // grupos já na ordem de saída (chave, estados) -> DataFrame com as chaves e uma coluna por agregação
+    DataFrame montarSaida(const vector<pair<const Chave*, const vector<EstadoAgregado>*>>& grupos,
+        const vector<string>& chaves, const vector<Agregacao>& agregacoes)
+    {
+        // linhas de saída; chaves e primeiro/último mantêm o tipo das células
+        vector<vector<Cell>> linhas;
+        linhas.reserve(grupos.size());
+        for (const auto& [chave, estados] : grupos)
+        {
+            vector<Cell> linha = *chave;
+            for (size_t a = 0; a < agregacoes.size(); ++a)
+                linha.push_back(finalizar(agregacoes[a].tipo, (*estados)[a]));
+            linhas.push_back(move(linha));
+        }
+
+        vector<string> nomes = chaves;
+        for (const auto& agregacao : agregacoes) nomes.push_back(nomeAgregacao(agregacao));
+
+        // tipo de cada coluna pelos valores; colunas com tipos misturados viram texto
+        vector<ColumnType> tipos(nomes.size(), ColumnType::STRING);
+        for (size_t c = 0; c < nomes.size(); ++c)
+        {
+            size_t alternativa = linhas.empty() ? 2 : linhas[0][c].index();
+            bool misturada = false;
+            for (const auto& linha : linhas) misturada |= linha[c].index() != alternativa;
+
+            if (misturada)
+                for (auto& linha : linhas) linha[c] = toString(linha[c]);
+            else
+                tipos[c] = alternativa == 0 ? ColumnType::INTEGER : alternativa == 1 ? ColumnType::DOUBLE : ColumnType::STRING;
+        }
+
+        DataFrame output(nomes, tipos);
+        for (const auto& linha : linhas) output.addRow(linha);
+        return output;
+    }
+}
+
+DataFrame agruparPor(const DataFrame& input, const vector<string>& chaves,
+    const vector<Agregacao>& agregacoes, int numThreads)
+{
+    TRACE_ESCOPO("agruparPor", "handler");
+
+    if (numThreads <= 0)
+        throw invalid_argument("Número de threads deve ser maior que zero.");
+    if (chaves.empty())
+        throw invalid_argument("Group-by sem colunas de agrupamento.");
+
+    const size_t ausente = static_cast<size_t>(-1);
+
+    vector<size_t> idxChaves;
+    for (const auto& nome : chaves)
+    {
+        size_t idx = input.colIdx(nome);
+        if (idx == ausente)
+            throw invalid_argument("Coluna de agrupamento não encontrada no DataFrame: " + nome);
+        idxChaves.push_back(idx);
+    }
+
+    // coluna "*" (só para contagem) usa a primeira chave, que existe em toda linha
+    vector<size_t> idxAgregacoes;
+    for (const auto& agregacao : agregacoes)
+    {
+        size_t idx = agregacao.coluna == "*" && agregacao.tipo == TipoAgregacao::CONTAGEM
+            ? idxChaves[0] : input.colIdx(agregacao.coluna);
+        if (idx == ausente)
+            throw invalid_argument("Coluna de agregação não encontrada no DataFrame: " + agregacao.coluna);
+        idxAgregacoes.push_back(idx);
+    }
+
+    const size_t numLinhas = static_cast<size_t>(input.size());
+    const size_t grao = Executor::grao(numLinhas, numThreads);
+    const size_t numBlocos = max<size_t>((numLinhas + grao - 1) / grao, 1);
+
+    auto montarChave = [&](size_t i, Chave& chave) {
+        const auto& row = input.getRow(i);
+        for (size_t k = 0; k < idxChaves.size(); ++k) chave[k] = row[idxChaves[k]];
+    };
+    auto agregarLinha = [&](Mapa& mapa, const Chave& chave, size_t i) {
+        const auto& row = input.getRow(i);
+        Grupo* grupo = mapa.encontrar(chave);
+        if (!grupo)
+            grupo = mapa.inserir(chave, Grupo{i, vector<EstadoAgregado>(agregacoes.size())}).first;
+        for (size_t a = 0; a < agregacoes.size(); ++a)
+            grupo->estados[a].adicionar(row[idxAgregacoes[a]], i);
+    };
+
+    // entrada ordenada pelas chaves: cada grupo é um trecho contíguo, agregado sem tabela hash. Cada bloco
+    // fecha os trechos que vê; um trecho que atravessa blocos é combinado na emenda
+    if (agrupadoPor(input, chaves))
+    {
+        struct Trecho
+        {
+            Chave chave;
+            vector<EstadoAgregado> estados;
+        };
+        vector<vector<Trecho>> trechos(numBlocos);
+        Executor::global().parallel_for(0, numLinhas, grao, [&](size_t ini, size_t fim)
+        {
+            vector<Trecho>& locais = trechos[ini / grao];
+            Chave chave(idxChaves.size());
+            for (size_t i = ini; i < fim; ++i)
+            {
+                montarChave(i, chave);
+                if (locais.empty() || locais.back().chave != chave)
+                    locais.push_back({chave, vector<EstadoAgregado>(agregacoes.size())});
+                const auto& row = input.getRow(i);
+                for (size_t a = 0; a < agregacoes.size(); ++a)
+                    locais.back().estados[a].adicionar(row[idxAgregacoes[a]], i);
+            }
+        });
+
+        vector<pair<const Chave*, const vector<EstadoAgregado>*>> grupos;
+        vector<EstadoAgregado>* anterior = nullptr;
+        for (auto& locais : trechos)
+        {
+            for (Trecho& trecho : locais)
+            {
+                if (anterior && *grupos.back().first == trecho.chave)
+                {
+                    for (size_t a = 0; a < agregacoes.size(); ++a) (*anterior)[a].combinar(trecho.estados[a]);
+                    continue;
+                }
+                grupos.push_back({&trecho.chave, &trecho.estados});
+                anterior = &trecho.estados;
+            }
+        }
+
+        DataFrame output = montarSaida(grupos, chaves, agregacoes);
+        output.setSortedBy(vector<string>(input.getSortedBy().begin(), input.getSortedBy().begin() + chaves.size()));
+        return output;
+    }
+
+    // muitos grupos: tabela por bloco não caberia na cache, então particiona as linhas por radix
+    const size_t bytesPorGrupo = sizeof(pair<Chave, Grupo>) + idxChaves.size() * sizeof(Cell)
+        + agregacoes.size() * sizeof(EstadoAgregado);
+    HashChave hasher;
+    const size_t gruposEstimados = estimarNumGrupos(numLinhas, [&](size_t i) {
+        Chave chave(idxChaves.size());
+        montarChave(i, chave);
+        return hasher(chave);
+    });
+    const size_t numRadix = particoesRadix(gruposEstimados, bytesPorGrupo, numThreads);
+    const size_t numParticoes = numRadix ? numRadix : static_cast<size_t>(numThreads);
+    vector<Mapa> particoes(numParticoes);
+
+    if (numRadix)
+    {
+        // fase 1: cada bloco só espalha os índices das linhas pelas partições
+        vector<vector<vector<size_t>>> espalhadas(numBlocos, vector<vector<size_t>>(numParticoes));
+        Executor::global().parallel_for(0, numLinhas, grao, [&](size_t ini, size_t fim)
+        {
+            vector<vector<size_t>>& destino = espalhadas[ini / grao];
+            Chave chave(idxChaves.size());
+            for (size_t i = ini; i < fim; ++i)
+            {
+                montarChave(i, chave);
+                destino[particaoHash(hasher(chave), numParticoes)].push_back(i);
+            }
+        });
+
+        // fase 2: cada partição é agregada por uma única tarefa, na ordem das linhas
+        Executor::global().parallel_for(0, numParticoes, 1, [&](size_t ini, size_t fim)
+        {
+            Chave chave(idxChaves.size());
+            for (size_t p = ini; p < fim; ++p)
+            {
+                for (auto& blocos : espalhadas)
+                {
+                    for (size_t i : blocos[p])
+                    {
+                        montarChave(i, chave);
+                        agregarLinha(particoes[p], chave, i);
+                    }
+                    vector<size_t>().swap(blocos[p]);
+                }
+            }
+        });
+    }
+    else
+    {
+        // fase 1: cada bloco agrega em mapas locais, um por partição do hash da chave
+        vector<vector<Mapa>> parciais(numBlocos, vector<Mapa>(numParticoes));
+        Executor::global().parallel_for(0, numLinhas, grao, [&](size_t ini, size_t fim)
+        {
+            vector<Mapa>& locais = parciais[ini / grao];
+            Chave chave(idxChaves.size());
+            for (size_t i = ini; i < fim; ++i)
+            {
+                montarChave(i, chave);
+                agregarLinha(locais[particaoHash(hasher(chave), numParticoes)], chave, i);
+            }
+        });
+
+        // fase 2: cada partição junta os mapas de todos os blocos (partições diferentes, chaves disjuntas)
+        Executor::global().parallel_for(0, numParticoes, 1, [&](size_t ini, size_t fim)
+        {
+            for (size_t p = ini; p < fim; ++p)
+            {
+                Mapa& destino = particoes[p];
+                for (auto& blocos : parciais)
+                {
+                    blocos[p].paraCada([&](const Chave& chave, Grupo& grupo)
+                    {
+                        Grupo* existente = destino.encontrar(chave);
+                        if (!existente)
+                        {
+                            destino.inserir(chave, move(grupo));
+                            return;
+                        }
+                        existente->primeiraLinha = min(existente->primeiraLinha, grupo.primeiraLinha);
+                        for (size_t a = 0; a < agregacoes.size(); ++a)
+                            existente->estados[a].combinar(grupo.estados[a]);
+                    });
+                    blocos[p] = Mapa();
+                }
+            }
+        });
+    }
+
+    // saída na ordem da primeira aparição de cada grupo
+    vector<pair<const Chave*, const Grupo*>> grupos;
+    for (const auto& mapa : particoes)
+        mapa.paraCada([&](const Chave& chave, const Grupo& grupo) { grupos.push_back({&chave, &grupo}); });
+    sort(grupos.begin(), grupos.end(), [](const auto& a, const auto& b) {
+        return a.second->primeiraLinha < b.second->primeiraLinha;
+    });
+
+    vector<pair<const Chave*, const vector<EstadoAgregado>*>> saida;
+    saida.reserve(grupos.size());
+    for (const auto& [chave, grupo] : grupos) saida.push_back({chave, &grupo->estados});
+    return montarSaida(saida, chaves, agregacoes);
+}
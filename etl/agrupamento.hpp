@@ -0,0 +1,114 @@
+#ifndef AGRUPAMENTO_HPP
+#define AGRUPAMENTO_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <functional>
+#include "dataframe.hpp"
+
+using namespace std;
+
+// Group-by genérico por hash: qualquer lista de colunas-chave (de qualquer tipo, comparadas pelo valor
+// tipado da célula) e várias agregações por chamada. Cada bloco de linhas agrega num mapa local, já
+// separado em partições pelo hash da chave; depois cada partição é combinada em paralelo, sem locks.
+// Os grupos saem na ordem em que aparecem pela primeira vez na entrada.
+//
+// Com muitos grupos (tabela estimada maior que a L2) a agregação passa a ser particionada por radix:
+// os blocos só espalham as linhas pelas partições do hash e cada partição é agregada e finalizada
+// por uma única tarefa, sem tabelas parciais por bloco nem etapa de combinação.
+//
+// No outro extremo, chaves inteiras num intervalo pequeno (ilhas 11-30, hospitais 1-5, flags 0/1) não
+// precisam de hash: SomaDensa acumula em vetores indexados pela chave.
+
+enum class TipoAgregacao { SOMA, CONTAGEM, MEDIA, MINIMO, MAXIMO, VARIANCIA, DESVIO_PADRAO, PRIMEIRO, ULTIMO };
+
+// Uma agregação do group-by. Soma, média, mínimo, máximo, variância e desvio usam só as células
+// numéricas; contagem conta as células não nulas (coluna "*" conta as linhas); primeiro/último
+// pegam o valor da primeira/última linha do grupo na ordem da entrada.
+struct Agregacao
+{
+    TipoAgregacao tipo;
+    string coluna;
+    string nomeSaida;   // vazio = nome padrão (ex.: "Total_internado", "Media_idade")
+};
+
+// Estado de uma agregação num grupo; combinável entre blocos (variância pelo método de Chan)
+struct EstadoAgregado
+{
+    uint64_t n = 0;            // valores numéricos vistos
+    uint64_t contagem = 0;     // células não nulas
+    double soma = 0;
+    double media = 0;
+    double m2 = 0;             // soma dos quadrados dos desvios (Welford)
+    double minimo = numeric_limits<double>::infinity();
+    double maximo = -numeric_limits<double>::infinity();
+    size_t linhaPrimeiro = numeric_limits<size_t>::max();
+    size_t linhaUltimo = 0;
+    Cell primeiro;
+    Cell ultimo;
+
+    void adicionar(const Cell& valor, size_t linha);
+    void combinar(const EstadoAgregado& outro);
+};
+
+// nome padrão da coluna de saída de uma agregação
+string nomeAgregacao(const Agregacao& agregacao);
+
+// estimativa de grupos distintos por uma amostra espaçada de até 4096 linhas (estimador Chao1, pelas
+// chaves vistas uma e duas vezes); linhas em que hashDaLinha lança são ignoradas
+size_t estimarNumGrupos(size_t numLinhas, const function<size_t(size_t)>& hashDaLinha);
+
+// partições da agregação por radix para gruposEstimados grupos de bytesPorGrupo bytes: 0 quando a tabela
+// cabe na L2 (agregação local por bloco); senão o bastante para cada partição caber nela (mínimo numThreads)
+size_t particoesRadix(size_t gruposEstimados, size_t bytesPorGrupo, int numThreads);
+
+// partição de um hash: bits altos (os baixos escolhem o grupo dentro da TabelaHash)
+inline size_t particaoHash(size_t h, size_t numParticoes) { return (h >> 32) % numParticoes; }
+
+// Somas por chave inteira num intervalo pequeno: vetores indexados por (chave - mínimo), que crescem
+// conforme as chaves aparecem. Uma chave que levaria o intervalo além de LIMITE é recusada (adicionar
+// devolve false e nada muda); quem chama decide se volta para a tabela hash.
+class SomaDensa
+{
+public:
+    static constexpr int LIMITE = 1 << 12;
+
+    // comDispersao: também acumula m2, a soma dos quadrados dos desvios (Welford por chave, Chan ao acumular)
+    explicit SomaDensa(bool comDispersao = false) : comDispersao(comDispersao) {}
+
+    bool adicionar(int chave, double valor);
+
+    // soma outro acumulador neste com somas vetorizadas (m2 pela combinação de Chan); false (e nada
+    // muda) se a união dos intervalos passar do LIMITE
+    bool acumular(const SomaDensa& outro);
+
+    // visita f(chave, contagem, soma, m2) das chaves vistas, em ordem crescente
+    template <typename F>
+    void paraCada(F&& f) const
+    {
+        for (size_t i = 0; i < contagens.size(); ++i)
+            if (contagens[i]) f(minimo + static_cast<int>(i), contagens[i], somas[i], comDispersao ? m2s[i] : 0.0);
+    }
+
+private:
+    // garante que [chaveMin, chaveMax] cabe nos vetores; false se passar do LIMITE
+    bool cobrir(int chaveMin, int chaveMax);
+
+    bool comDispersao;
+    int minimo = 0;
+    vector<double> somas;
+    vector<double> m2s;
+    vector<uint64_t> contagens;
+};
+
+// soma origem em destino elemento a elemento (SSE2, dois doubles por instrução)
+void somarVetores(double* destino, const double* origem, size_t n);
+
+// agrupa input pelas colunas `chaves` e calcula as agregações; colunas de saída: as chaves, depois uma
+// por agregação. Lança invalid_argument para colunas inexistentes ou numThreads <= 0.
+DataFrame agruparPor(const DataFrame& input, const vector<string>& chaves,
+    const vector<Agregacao>& agregacoes, int numThreads);
+
+#endif // AGRUPAMENTO_HPP
@@ -1,6 +1,7 @@
 #include "dashboard.hpp"
 #include "dataframe.hpp"  //Para Cell, toDouble, toString
 #include "extrator.hpp"  //Para Extrator
+#include "agrupamento.hpp"  //Para SomaDensa, EstadoAgregado
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -18,7 +19,10 @@ using namespace std;
 namespace fs = filesystem;
 
 mutex mtx;
-map<int, vector<double>> dadosPorHospital;
+// totais (contagem, soma e m2 para a variância) por ID de hospital: vetores indexados pelo ID e, para
+// IDs fora do intervalo denso, um mapa
+SomaDensa totaisPorHospital(true);
+map<int, EstadoAgregado> totaisDispersosPorHospital;
 vector<double> todosInternados;
 
 ////////////////// ANÁLISE 1 ////////////
@@ -148,6 +152,16 @@ void calcularEstatisticasHospitalares() {
 
 ///////////////////////////////////////// ANÁLISE 3 //////////////////////////////////////////////
 
+// estado de agregação de um ID a partir dos totais densos (contagem, soma, m2)
+static EstadoAgregado estadoDasSomas(uint64_t n, double soma, double m2) {
+    EstadoAgregado estado;
+    estado.n = estado.contagem = n;
+    estado.soma = soma;
+    estado.media = soma / n;
+    estado.m2 = m2;
+    return estado;
+}
+
 // Função que processa um arquivo individual e armazena os dados por hospital
 void processarArquivoPorHospital(const string& caminhoArquivo) {
     ifstream file(caminhoArquivo);
@@ -159,6 +173,10 @@ void processarArquivoPorHospital(const string& caminhoArquivo) {
     string linha;
     getline(file, linha); // Ignora o cabeçalho
 
+    // acumula localmente e combina com os totais globais uma vez por arquivo
+    SomaDensa totaisLocais(true);
+    map<int, EstadoAgregado> dispersosLocais;
+
     while (getline(file, linha)) {
         istringstream ss(linha);
         string idStr, valorStr;
@@ -169,8 +187,7 @@ void processarArquivoPorHospital(const string& caminhoArquivo) {
             int id = stoi(idStr);
             double valor = stod(valorStr);
 
-            lock_guard<mutex> lock(mtx);
-            dadosPorHospital[id].push_back(valor);
+            if (!totaisLocais.adicionar(id, valor)) dispersosLocais[id].adicionar(valor, 0);
         } catch (...) {
             cerr << "[AVISO] Erro ao processar linha em: " << caminhoArquivo << endl;
             continue;
@@ -178,6 +195,14 @@ void processarArquivoPorHospital(const string& caminhoArquivo) {
     }
 
     file.close();
+
+    lock_guard<mutex> lock(mtx);
+    if (!totaisPorHospital.acumular(totaisLocais)) {
+        totaisLocais.paraCada([&](int id, uint64_t n, double soma, double m2) {
+            dispersosLocais[id].combinar(estadoDasSomas(n, soma, m2));
+        });
+    }
+    for (const auto& [id, estado] : dispersosLocais) totaisDispersosPorHospital[id].combinar(estado);
 }
 
 // Função principal para calcular estatísticas por hospital
@@ -194,23 +219,26 @@ void calcularEstatisticasPorHospital() {
         t.join();
     }
 
-    if (dadosPorHospital.empty()) {
+    // junta as duas fontes, ordenadas por ID
+    map<int, EstadoAgregado> totais = totaisDispersosPorHospital;
+    totaisPorHospital.paraCada([&](int id, uint64_t n, double soma, double m2) {
+        totais[id].combinar(estadoDasSomas(n, soma, m2));
+    });
+
+    if (totais.empty()) {
         cerr << "[ERRO] Nenhum dado carregado para estatísticas por hospital.\n";
         return;
     }
 
     cout << "\n=== Estatísticas por Hospital ===\n";
 
-    for (const auto& [id, valores] : dadosPorHospital) {
-        if (valores.empty()) continue;
+    for (const auto& [id, estado] : totais) {
+        if (estado.n == 0) continue;
 
-        double soma = 0.0;
-        for (double v : valores) soma += v;
-        double media = soma / valores.size();
+        double media = estado.media;
 
-        double variancia = 0.0;
-        for (double v : valores) variancia += pow(v - media, 2);
-        variancia /= valores.size();
+        // variância populacional pela soma dos quadrados dos desvios (sem cancelamento)
+        double variancia = estado.m2 / estado.n;
         double desvioPadrao = sqrt(variancia);
 
         cout << "Hospital ID: " << id << "\n";
@@ -3,7 +3,8 @@
 #include <variant>
 #include <tuple>
 #include <iomanip> //Para formatação
-#include <thread>
+#include <iterator>
+#include "executor.hpp"
 using namespace std;
 
 // Construtor da classe DataFrame: inicializa nomes e tipos das colunas
@@ -58,6 +59,7 @@ void DataFrame::addRow(const vector<Cell>& row)
     }
 
     data.push_back(row);
+    sortedBy.clear();
 }
 
 // Remove uma linha com base no índice
@@ -71,6 +73,81 @@ void DataFrame::removeRow(int index)
     }
 }
 
+// Compacta o DataFrame nas linhas indicadas (índices crescentes)
+void DataFrame::keepRows(const vector<size_t>& indices)
+{
+    size_t destino = 0;
+    for (size_t indice : indices)
+    {
+        if (indice >= data.size()) break;
+        if (indice != destino) data[destino] = std::move(data[indice]);
+        ++destino;
+    }
+    data.resize(destino);
+}
+
+// Acrescenta linhas prontas, movendo-as (sem a checagem de tipos do addRow)
+void DataFrame::addRows(vector<vector<Cell>>&& rows)
+{
+    if (data.empty()) data = std::move(rows);
+    else data.insert(data.end(), make_move_iterator(rows.begin()), make_move_iterator(rows.end()));
+    rows.clear();
+    sortedBy.clear();
+}
+
+// Aplica a permutação movendo as linhas para um novo vetor
+void DataFrame::reorderRows(const vector<size_t>& ordem)
+{
+    if (ordem.size() != data.size())
+        throw invalid_argument("A permutação das linhas não tem o tamanho do DataFrame.");
+
+    vector<vector<Cell>> reordenadas(data.size());
+    for (size_t i = 0; i < ordem.size(); ++i) reordenadas[i] = std::move(data[ordem[i]]);
+    data = std::move(reordenadas);
+    sortedBy.clear();
+}
+
+// a ordem vale só pelo prefixo de colunas que ainda existem
+static void truncarOrdem(vector<string>& sortedBy, const vector<string>& columnNames)
+{
+    size_t k = 0;
+    while (k < sortedBy.size() && find(columnNames.begin(), columnNames.end(), sortedBy[k]) != columnNames.end()) ++k;
+    sortedBy.resize(k);
+}
+
+// Compacta cada linha nas colunas indicadas (índices crescentes), em paralelo por blocos de linhas
+void DataFrame::keepColumns(const vector<size_t>& indices, int numThreads)
+{
+    const size_t numColunas = columnNames.size();
+    vector<size_t> validos;
+    for (size_t indice : indices)
+        if (indice < numColunas) validos.push_back(indice);
+    if (validos.size() == numColunas) return;
+
+    vector<string> nomes;
+    vector<ColumnType> tipos;
+    for (size_t indice : validos)
+    {
+        nomes.push_back(std::move(columnNames[indice]));
+        tipos.push_back(columnTypes[indice]);
+    }
+    columnNames = std::move(nomes);
+    columnTypes = std::move(tipos);
+    truncarOrdem(sortedBy, columnNames);
+
+    const size_t n = data.size();
+    Executor::global().parallel_for(0, n, Executor::grao(n, numThreads), [this, &validos](size_t start, size_t end)
+    {
+        for (size_t i = start; i < end; ++i)
+        {
+            vector<Cell>& linha = data[i];
+            for (size_t k = 0; k < validos.size(); ++k)
+                if (validos[k] != k) linha[k] = std::move(linha[validos[k]]);
+            linha.resize(validos.size());
+        }
+    });
+}
+
 void DataFrame::addColumn(const string& name, ColumnType type, const vector<Cell>& values, int numThreads) 
 {
     // Verifica se o tamanho da nova coluna corresponde ao número de linhas já existentes
@@ -90,29 +167,19 @@ void DataFrame::addColumn(const string& name, ColumnType type, const vector<Cell
         for (const auto& val : values) {
             data.push_back({val});
         }
+        sortedBy.clear();
     } 
     else 
     {
         // Paraleliza a adição do novo valor à última coluna em cada linha existente
         size_t n = data.size();
-        int chunkSize = max(static_cast<int>(n / numThreads), 1);
-        vector<thread> threads;
-
-        for (int t = 0; t < numThreads; ++t)
+        Executor::global().parallel_for(0, n, Executor::grao(n, numThreads), [this, &values](size_t start, size_t end)
         {
-            int start = t * chunkSize;
-            int end = (t == numThreads - 1) ? n : start + chunkSize;
-
-            threads.emplace_back([this, &values, start, end]()
+            for (size_t i = start; i < end; ++i)
             {
-                for (int i = start; i < end; ++i)
-                {
-                    data[i].push_back(values[i]);
-                }
-            });
-        }
-
-        for (auto& t : threads) t.join();
+                data[i].push_back(values[i]);
+            }
+        });
     }
 }
 
@@ -131,6 +198,7 @@ void DataFrame::removeColumn(const string& name)
 
         // Remove o valor correspondente em todas as linhas
         for (auto& row : data)  row.erase(row.begin() + idx);
+        truncarOrdem(sortedBy, columnNames);
     }
 }
 
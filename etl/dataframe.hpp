@@ -100,6 +100,10 @@ private:
     // Matriz com os dados (usando variant para identificar seus tipos)
     vector<vector<Cell>> data;            
 
+    // Colunas pelas quais as linhas estão em ordem crescente (vazio = sem ordem conhecida); quem ordena
+    // marca, as operações que podem desfazer a ordem desmarcam
+    vector<string> sortedBy;
+
     // Função auxiliar para verificar se um valor é considerado nulo
     bool isNull(const string& val) const {
         return val.empty() || val == "null" || val == "NULL" || val == "NaN";
@@ -116,6 +120,19 @@ public:
     // Remove a linha no índice especificado
     void removeRow(int index);
 
+    // Mantém só as linhas dos índices dados (crescentes), na mesma ordem; as linhas são movidas, não copiadas
+    void keepRows(const vector<size_t>& indices);
+
+    // Mantém só as colunas dos índices dados (crescentes), movendo as células de cada linha no lugar
+    void keepColumns(const vector<size_t>& indices, int numThreads);
+
+    // Acrescenta linhas já montadas no esquema do DataFrame (quem monta garante os tipos), movidas sem
+    // checar célula a célula; usado pelos operadores que materializam a saída em paralelo
+    void addRows(vector<vector<Cell>>&& rows);
+
+    // Reordena as linhas: a i-ésima passa a ser a antiga ordem[i] (ordem é uma permutação); movidas, não copiadas
+    void reorderRows(const vector<size_t>& ordem);
+
     // Adiciona uma nova coluna com nome, tipo e valores
     void addColumn(const string&, ColumnType, const vector<Cell>&, int);
 
@@ -148,6 +165,10 @@ public:
 
     // Retorna as linhas do Dataframe
     const vector<vector<Cell>>& getLinhas() const;
+
+    // Propriedade "ordenado por": colunas pelas quais as linhas estão em ordem crescente (vazio = nenhuma)
+    const vector<string>& getSortedBy() const { return sortedBy; }
+    void setSortedBy(const vector<string>& colunas) { sortedBy = colunas; }
 };
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "deduplicacao.hpp"
+#include "agrupamento.hpp"
+#include "executor.hpp"
+#include "trace.hpp"
+#include "tabela_hash.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+vector<size_t> colunasDeduplicacao(const DataFrame& input, const vector<string>& colunas)
+{
+    vector<size_t> idxColunas;
+    for (const auto& nome : colunas)
+    {
+        size_t idx = input.colIdx(nome);
+        if (idx == static_cast<size_t>(-1))
+            throw invalid_argument("Coluna de deduplicação não encontrada no DataFrame: " + nome);
+        idxColunas.push_back(idx);
+    }
+    if (idxColunas.empty())
+        for (int c = 0; c < input.numCols(); ++c) idxColunas.push_back(static_cast<size_t>(c));
+    return idxColunas;
+}
+
+size_t hashChaveLinha(const vector<Cell>& linha, const vector<size_t>& idxColunas)
+{
+    size_t seed = idxColunas.size();
+    for (size_t c : idxColunas)
+    {
+        const size_t h = c < linha.size() ? hash<Cell>()(linha[c]) : 0;
+        seed ^= h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    }
+    return misturarHash(seed);
+}
+
+vector<char> marcarUnicas(const DataFrame& input, const vector<size_t>& idxColunas, int numThreads,
+    const function<bool(size_t, const vector<Cell>&)>& visitar)
+{
+    TRACE_ESCOPO("marcarUnicas", "handler");
+
+    if (numThreads <= 0)
+        throw invalid_argument("Número de threads deve ser maior que zero.");
+
+    const size_t numLinhas = static_cast<size_t>(input.size());
+    vector<char> manter(numLinhas, 0);
+    if (numLinhas == 0) return manter;
+
+    // linhas com menos colunas que o esperado comparam só as células que têm
+    auto mesmaChave = [&](size_t a, size_t b)
+    {
+        const auto& linhaA = input.getRow(a);
+        const auto& linhaB = input.getRow(b);
+        for (size_t c : idxColunas)
+        {
+            const bool temA = c < linhaA.size(), temB = c < linhaB.size();
+            if (temA != temB || (temA && !(linhaA[c] == linhaB[c]))) return false;
+        }
+        return true;
+    };
+
+    const size_t grao = Executor::grao(numLinhas, numThreads);
+    const size_t numBlocos = (numLinhas + grao - 1) / grao;
+
+    // fase 1: hash da chave de cada linha (e o passo extra de quem chama), espalhando os índices pelas
+    // partições do hash
+    const size_t numParticoes = max<size_t>(
+        particoesRadix(numLinhas, sizeof(pair<size_t, size_t>) + 1, numThreads), numThreads);
+    vector<size_t> hashes(numLinhas);
+    vector<vector<vector<size_t>>> espalhados(numBlocos, vector<vector<size_t>>(numParticoes));
+    Executor::global().parallel_for(0, numLinhas, grao, [&](size_t inicio, size_t fim)
+    {
+        auto& destino = espalhados[inicio / grao];
+        for (size_t i = inicio; i < fim; ++i)
+        {
+            const auto& linha = input.getRow(i);
+            if (visitar && !visitar(i, linha)) continue;
+            hashes[i] = hashChaveLinha(linha, idxColunas);
+            destino[particaoHash(hashes[i], numParticoes)].push_back(i);
+        }
+    });
+
+    // fase 2: cada partição percorre suas linhas em ordem crescente; a primeira de cada chave fica
+    Executor::global().parallel_for(0, numParticoes, 1, [&](size_t ini, size_t fim)
+    {
+        for (size_t p = ini; p < fim; ++p)
+        {
+            TabelaHash<size_t, size_t> primeiraPorHash;   // hash -> primeira linha com esse hash
+            TabelaHash<size_t, vector<size_t>> colisoes;  // hash -> outras linhas distintas com o mesmo hash
+
+            for (auto& blocos : espalhados)
+            {
+                for (size_t i : blocos[p])
+                {
+                    auto [primeira, nova] = primeiraPorHash.inserir(hashes[i], i);
+                    if (nova)
+                    {
+                        manter[i] = 1;
+                        continue;
+                    }
+                    if (mesmaChave(*primeira, i)) continue;
+
+                    // colisão de hash: compara com as outras linhas distintas já vistas com esse hash
+                    vector<size_t>& outras = colisoes[hashes[i]];
+                    if (none_of(outras.begin(), outras.end(), [&](size_t j) { return mesmaChave(j, i); }))
+                    {
+                        outras.push_back(i);
+                        manter[i] = 1;
+                    }
+                }
+                vector<size_t>().swap(blocos[p]);
+            }
+        }
+    });
+
+    return manter;
+}
+
+vector<size_t> linhasUnicas(const DataFrame& input, const vector<string>& colunas, int numThreads)
+{
+    const vector<char> manter = marcarUnicas(input, colunasDeduplicacao(input, colunas), numThreads);
+
+    vector<size_t> indices;
+    indices.reserve(manter.size());
+    for (size_t i = 0; i < manter.size(); ++i)
+        if (manter[i]) indices.push_back(i);
+    return indices;
+}
+
+size_t removerDuplicatas(DataFrame& input, const vector<string>& colunas, int numThreads)
+{
+    const size_t antes = static_cast<size_t>(input.size());
+    input.keepRows(linhasUnicas(input, colunas, numThreads));
+    return antes - static_cast<size_t>(input.size());
+}
+
+DeduplicacaoEntreLotes::DeduplicacaoEntreLotes(vector<string> colunas)
+    : colunas(move(colunas)), linhaInteira(this->colunas.empty())
+{
+    for (size_t p = 0; p < NUM_PARTICOES; ++p) particoes.push_back(make_unique<Particao>());
+}
+
+vector<size_t> DeduplicacaoEntreLotes::colunasDoLote(const DataFrame& lote)
+{
+    lock_guard<mutex> lock(colunasMtx);
+
+    // linha inteira: as colunas do primeiro lote viram a chave de todos
+    if (linhaInteira && colunas.empty())
+        colunas = lote.getColumnNames();
+
+    if (linhaInteira && static_cast<size_t>(lote.numCols()) != colunas.size())
+        throw invalid_argument("Lote com colunas diferentes dos anteriores da fonte.");
+
+    // pelo nome: a mesma chave mesmo que a ordem das colunas mude entre lotes
+    vector<size_t> idxColunas;
+    for (const auto& nome : colunas)
+    {
+        const size_t idx = lote.colIdx(nome);
+        if (idx == static_cast<size_t>(-1))
+            throw invalid_argument("Coluna de deduplicação não encontrada no lote: " + nome);
+        idxColunas.push_back(idx);
+    }
+    return idxColunas;
+}
+
+size_t DeduplicacaoEntreLotes::removerRepetidas(DataFrame& lote, int numThreads)
+{
+    TRACE_ESCOPO("removerRepetidas", "handler");
+
+    if (numThreads <= 0)
+        throw invalid_argument("Número de threads deve ser maior que zero.");
+
+    const size_t numLinhas = static_cast<size_t>(lote.size());
+    if (numLinhas == 0) return 0;
+    const vector<size_t> idxColunas = colunasDoLote(lote);
+
+    // células que faltam em linhas curtas valem como Cell() (como na cópia guardada)
+    const Cell vazia;
+    auto celula = [&](const vector<Cell>& linha, size_t c) -> const Cell& { return c < linha.size() ? linha[c] : vazia; };
+    auto mesmaChave = [&](const vector<Cell>& chave, const vector<Cell>& linha)
+    {
+        for (size_t k = 0; k < idxColunas.size(); ++k)
+            if (!(chave[k] == celula(linha, idxColunas[k]))) return false;
+        return true;
+    };
+
+    // hash da chave de cada linha em paralelo e índices espalhados pelas partições (em ordem)
+    vector<size_t> hashes(numLinhas);
+    const size_t grao = Executor::grao(numLinhas, numThreads);
+    Executor::global().parallel_for(0, numLinhas, grao, [&](size_t inicio, size_t fim)
+    {
+        for (size_t i = inicio; i < fim; ++i) hashes[i] = hashChaveLinha(lote.getRow(i), idxColunas);
+    });
+    vector<vector<size_t>> porParticao(NUM_PARTICOES);
+    for (size_t i = 0; i < numLinhas; ++i) porParticao[particaoHash(hashes[i], NUM_PARTICOES)].push_back(i);
+
+    // cada partição confere e registra as chaves do lote sob o seu mutex; a primeira ocorrência fica
+    vector<char> manter(numLinhas, 0);
+    Executor::global().parallel_for(0, NUM_PARTICOES, 1, [&](size_t ini, size_t fim)
+    {
+        for (size_t p = ini; p < fim; ++p)
+        {
+            if (porParticao[p].empty()) continue;
+            Particao& particao = *particoes[p];
+            lock_guard<mutex> lock(particao.mtx);
+
+            for (size_t i : porParticao[p])
+            {
+                const auto& linha = lote.getRow(i);
+                vector<vector<Cell>>& vistas = particao.chaves[hashes[i]];
+                if (any_of(vistas.begin(), vistas.end(), [&](const vector<Cell>& chave) { return mesmaChave(chave, linha); }))
+                    continue;
+
+                vector<Cell> chave;
+                chave.reserve(idxColunas.size());
+                for (size_t c : idxColunas) chave.push_back(celula(linha, c));
+                vistas.push_back(move(chave));
+                manter[i] = 1;
+            }
+        }
+    });
+
+    vector<size_t> linhas;
+    linhas.reserve(numLinhas);
+    for (size_t i = 0; i < numLinhas; ++i)
+        if (manter[i]) linhas.push_back(i);
+
+    const size_t removidas = numLinhas - linhas.size();
+    if (removidas > 0) lote.keepRows(linhas);
+    numRepetidas.fetch_add(removidas, memory_order_relaxed);
+    return removidas;
+}
@@ -0,0 +1,74 @@
+#ifndef DEDUPLICACAO_HPP
+#define DEDUPLICACAO_HPP
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include "dataframe.hpp"
+#include "tabela_hash.hpp"
+
+using namespace std;
+
+// Deduplicação exata e paralela: o hash da chave de cada linha é calculado em blocos, as linhas são
+// espalhadas pelas partições do hash e cada partição é varrida por uma única tarefa, na ordem da
+// entrada. Hashes iguais são confirmados comparando as células, então uma colisão nunca descarta
+// uma linha diferente; a primeira ocorrência de cada chave é a que fica.
+
+// índices das colunas de deduplicação (todas quando `colunas` é vazio); lança invalid_argument se faltar uma
+vector<size_t> colunasDeduplicacao(const DataFrame& input, const vector<string>& colunas);
+
+// hash das células idxColunas de uma linha
+size_t hashChaveLinha(const vector<Cell>& linha, const vector<size_t>& idxColunas);
+
+// marca com 1 a primeira ocorrência de cada chave. `visitar(i, linha)`, se dado, roda na mesma varredura
+// que calcula os hashes (para quem precisa olhar as células uma vez só) e devolve false para descartar a
+// linha antes da deduplicação
+vector<char> marcarUnicas(const DataFrame& input, const vector<size_t>& idxColunas, int numThreads,
+    const function<bool(size_t, const vector<Cell>&)>& visitar = nullptr);
+
+// índices (crescentes) das linhas que ficam ao remover duplicatas pelas colunas `colunas` (todas quando
+// vazio). Lança invalid_argument para colunas inexistentes ou numThreads <= 0.
+vector<size_t> linhasUnicas(const DataFrame& input, const vector<string>& colunas, int numThreads);
+
+// remove de input as linhas repetidas nas colunas `colunas` (todas quando vazio); devolve quantas saíram
+size_t removerDuplicatas(DataFrame& input, const vector<string>& colunas, int numThreads);
+
+// Deduplicação entre lotes de uma mesma fonte (modos por lotes): guarda as chaves já vistas, separadas em
+// partições pelo hash, cada uma com seu mutex, para que tratadores diferentes filtrem lotes ao mesmo tempo.
+// Hashes iguais também são confirmados pelas células. Guarda uma cópia de cada chave distinta, então a
+// memória cresce com o número de chaves distintas do stream.
+class DeduplicacaoEntreLotes
+{
+public:
+    static constexpr size_t NUM_PARTICOES = 64;
+
+    // colunas da chave pelo nome (vazio = todas as colunas do primeiro lote)
+    explicit DeduplicacaoEntreLotes(vector<string> colunas = {});
+
+    // remove do lote as linhas cuja chave já apareceu, neste lote ou num anterior; devolve quantas saíram.
+    // Lança invalid_argument se faltar uma coluna da chave (ou, com a linha inteira, as colunas mudarem)
+    size_t removerRepetidas(DataFrame& lote, int numThreads);
+
+    // linhas removidas até agora
+    size_t repetidas() const { return numRepetidas.load(memory_order_relaxed); }
+
+private:
+    struct Particao
+    {
+        mutex mtx;
+        TabelaHash<size_t, vector<vector<Cell>>> chaves;   // hash -> chaves distintas com esse hash
+    };
+
+    vector<size_t> colunasDoLote(const DataFrame& lote);
+
+    vector<string> colunas;
+    bool linhaInteira;
+    mutex colunasMtx;
+    vector<unique_ptr<Particao>> particoes;
+    atomic<size_t> numRepetidas{0};
+};
+
+#endif // DEDUPLICACAO_HPP
@@ -0,0 +1,231 @@
+#include "executor.hpp"
+#include "trace.hpp"
+#include <iostream>
+#include <chrono>
+#include <exception>
+#include <pthread.h>
+
+using namespace std;
+
+// worker (e pool) da thread atual; -1 para threads de fora do pool
+thread_local Executor* executorAtual = nullptr;
+thread_local int indiceAtual = -1;
+
+// estado compartilhado de um parallel_for: blocos são distribuídos por contador atômico
+struct Trabalho
+{
+    atomic<size_t> proximo{0};
+    atomic<size_t> concluidos{0};
+    size_t total = 0;
+    const function<void(size_t)>* corpo = nullptr;
+    mutex erroMtx;
+    exception_ptr erro;
+    mutex fimMtx;                 // avisa a chamadora quando o último bloco termina
+    condition_variable fimCondVar;
+};
+
+// pega blocos até acabarem (executado pela chamadora e pelos ajudantes)
+static void processarBlocos(Trabalho& trabalho)
+{
+    size_t b;
+    while ((b = trabalho.proximo.fetch_add(1, memory_order_relaxed)) < trabalho.total)
+    {
+        TRACE_ESCOPO("bloco", "executor");
+        try {
+            (*trabalho.corpo)(b);
+        } catch (...) {
+            lock_guard<mutex> lock(trabalho.erroMtx);
+            if (!trabalho.erro) trabalho.erro = current_exception();
+        }
+        if (trabalho.concluidos.fetch_add(1, memory_order_acq_rel) + 1 == trabalho.total)
+        {
+            lock_guard<mutex> lock(trabalho.fimMtx);
+            trabalho.fimCondVar.notify_all();
+        }
+    }
+}
+
+Executor& Executor::global()
+{
+    static Executor instancia(max(1u, thread::hardware_concurrency()));
+    return instancia;
+}
+
+Executor::Executor(unsigned numThreads)
+{
+    numThreads = max(1u, numThreads);
+    for (unsigned i = 0; i < numThreads; ++i) filas.push_back(make_unique<FilaTrabalho>());
+    for (unsigned i = 0; i < numThreads; ++i) workers.emplace_back(&Executor::laco, this, i);
+}
+
+Executor::~Executor()
+{
+    {
+        lock_guard<mutex> lock(sonoMtx);
+        encerrando = true;
+    }
+    sonoCondVar.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void Executor::fixarNaTopologia(const Topologia& topologia)
+{
+    if (!topologia.valeFixar()) return;
+
+    const unsigned numSockets = static_cast<unsigned>(topologia.numSockets());
+    for (unsigned i = 0; i < workers.size(); ++i)
+    {
+        // worker i vai para o socket i % S e, dentro dele, para os domínios em rodízio
+        const vector<int>& doSocket = topologia.dominiosSocket(i % numSockets);
+        const vector<int>& cpus = topologia.cpusDominio(doSocket[(i / numSockets) % doSocket.size()]);
+
+        cpu_set_t conjunto;
+        CPU_ZERO(&conjunto);
+        for (int c : cpus) CPU_SET(c, &conjunto);
+        // os workers já existem: a afinidade é aplicada de fora, pelo handle da thread
+        if (pthread_setaffinity_np(workers[i].native_handle(), sizeof(conjunto), &conjunto) != 0)
+            cerr << "[Executor] não foi possível fixar o worker " << i << endl;
+    }
+}
+
+size_t Executor::grao(size_t n, int numPartes)
+{
+    const size_t partes = static_cast<size_t>(max(numPartes, 1));
+    return max(GRAO_MINIMO, (n + partes - 1) / partes);
+}
+
+void Executor::submeter(function<void()> tarefa)
+{
+    // dentro de um worker vai para a própria fila (LIFO, dados ainda quentes na cache);
+    // de fora do pool é distribuída entre as filas
+    const size_t alvo = (executorAtual == this && indiceAtual >= 0)
+        ? static_cast<size_t>(indiceAtual)
+        : proximaFila.fetch_add(1, memory_order_relaxed) % filas.size();
+
+    {
+        lock_guard<mutex> lock(filas[alvo]->mtx);
+        filas[alvo]->tarefas.push_back(move(tarefa));
+    }
+    pendentes.fetch_add(1, memory_order_release);
+
+    {
+        lock_guard<mutex> lock(sonoMtx);
+    }
+    sonoCondVar.notify_one();
+}
+
+bool Executor::pegarTarefa(int indice, function<void()>& tarefa)
+{
+    const int numFilas = static_cast<int>(filas.size());
+
+    // primeiro a própria fila, pelo fim
+    if (indice >= 0)
+    {
+        FilaTrabalho& propria = *filas[indice];
+        lock_guard<mutex> lock(propria.mtx);
+        if (!propria.tarefas.empty())
+        {
+            tarefa = move(propria.tarefas.back());
+            propria.tarefas.pop_back();
+            pendentes.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // depois rouba pelo início das filas vizinhas
+    const int inicio = indice >= 0 ? indice + 1 : 0;
+    for (int k = 0; k < numFilas; ++k)
+    {
+        const int vitima = (inicio + k) % numFilas;
+        if (vitima == indice) continue;
+
+        FilaTrabalho& outra = *filas[vitima];
+        lock_guard<mutex> lock(outra.mtx);
+        if (!outra.tarefas.empty())
+        {
+            tarefa = move(outra.tarefas.front());
+            outra.tarefas.pop_front();
+            pendentes.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Executor::ajudar()
+{
+    if (pendentes.load(memory_order_acquire) == 0) return false;
+
+    function<void()> tarefa;
+    const int indice = executorAtual == this ? indiceAtual : -1;
+    if (!pegarTarefa(indice, tarefa)) return false;
+
+    tarefa();
+    return true;
+}
+
+void Executor::laco(unsigned indice)
+{
+    executorAtual = this;
+    indiceAtual = static_cast<int>(indice);
+    TRACE_NOMEAR_THREAD("executor-" + to_string(indice));
+
+    while (true)
+    {
+        function<void()> tarefa;
+        if (pegarTarefa(indiceAtual, tarefa))
+        {
+            try {
+                tarefa();
+            } catch (const exception& e) {
+                cerr << "[Executor] tarefa falhou: " << e.what() << endl;
+            }
+            continue;
+        }
+
+        unique_lock<mutex> lock(sonoMtx);
+        if (encerrando && pendentes.load(memory_order_acquire) == 0) break;
+        sonoCondVar.wait_for(lock, chrono::milliseconds(10), [this] {
+            return pendentes.load(memory_order_acquire) > 0 || encerrando;
+        });
+    }
+}
+
+void Executor::executarBlocos(size_t numBlocos, const function<void(size_t)>& corpo)
+{
+    // um único bloco não compensa o despacho
+    if (numBlocos <= 1)
+    {
+        for (size_t b = 0; b < numBlocos; ++b) corpo(b);
+        return;
+    }
+
+    auto trabalho = make_shared<Trabalho>();
+    trabalho->total = numBlocos;
+    trabalho->corpo = &corpo;
+
+    // no máximo um ajudante por worker; a chamadora pega a sua parte
+    const size_t ajudantes = min<size_t>(numBlocos - 1, workers.size());
+    for (size_t i = 0; i < ajudantes; ++i)
+    {
+        submeter([trabalho] { processarBlocos(*trabalho); });
+    }
+
+    processarBlocos(*trabalho);
+
+    // blocos ainda em andamento em outras threads: ajuda com o que houver pendente e, sem nada para
+    // ajudar, dorme até o último bloco terminar (não gira ocupando um núcleo dos workers)
+    {
+        TRACE_ESCOPO("espera_blocos", "executor");
+        auto terminou = [&] { return trabalho->concluidos.load(memory_order_acquire) == numBlocos; };
+        while (!terminou())
+        {
+            if (ajudar()) continue;
+
+            unique_lock<mutex> lock(trabalho->fimMtx);
+            trabalho->fimCondVar.wait(lock, terminou);
+        }
+    }
+
+    if (trabalho->erro) rethrow_exception(trabalho->erro);
+}
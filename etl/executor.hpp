@@ -0,0 +1,115 @@
+#ifndef EXECUTOR_HPP
+#define EXECUTOR_HPP
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include "topologia.hpp"
+
+using namespace std;
+
+// Pool de threads persistente e único no processo, com roubo de tarefas (work-stealing).
+// Cada worker tem sua fila: consome do fim da própria fila e, quando ela esvazia,
+// rouba do início da fila dos outros. Quem chama parallel_for/parallel_reduce também
+// executa blocos e, enquanto espera, ajuda com outras tarefas pendentes (sem nenhuma, dorme até
+// o último bloco terminar); assim chamadas aninhadas (consumidores do pipeline -> kernels dos
+// handlers) não criam threads novas nem disputam núcleos com os workers.
+class Executor
+{
+public:
+    // pool compartilhado por todos os handlers (uma thread por núcleo)
+    static Executor& global();
+
+    explicit Executor(unsigned numThreads);
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    // número de workers do pool
+    unsigned numThreads() const { return static_cast<unsigned>(workers.size()); }
+
+    // fixa cada worker num domínio L3, alternando entre os sockets (sem efeito com um único domínio)
+    void fixarNaTopologia(const Topologia& topologia);
+
+    // agenda uma tarefa avulsa
+    void submeter(function<void()> tarefa);
+
+    // executa um bloco pendente na thread atual; devolve false se não havia nenhum
+    bool ajudar();
+
+    // divide [inicio, fim) em blocos de até `grao` elementos e chama corpo(iniBloco, fimBloco) em paralelo
+    template <typename Corpo>
+    void parallel_for(size_t inicio, size_t fim, size_t grao, Corpo&& corpo)
+    {
+        if (fim <= inicio) return;
+        grao = max<size_t>(grao, 1);
+        const size_t numBlocos = (fim - inicio + grao - 1) / grao;
+
+        executarBlocos(numBlocos, [&](size_t b)
+        {
+            const size_t ini = inicio + b * grao;
+            corpo(ini, min(ini + grao, fim));
+        });
+    }
+
+    // mapear(iniBloco, fimBloco) produz um resultado parcial por bloco; os parciais são
+    // combinados com reduzir(acumulado, parcial) na ordem dos blocos (resultado determinístico)
+    template <typename T, typename Mapear, typename Reduzir>
+    T parallel_reduce(size_t inicio, size_t fim, size_t grao, T identidade, Mapear&& mapear, Reduzir&& reduzir)
+    {
+        if (fim <= inicio) return identidade;
+        grao = max<size_t>(grao, 1);
+        const size_t numBlocos = (fim - inicio + grao - 1) / grao;
+
+        vector<T> parciais(numBlocos, identidade);
+        executarBlocos(numBlocos, [&](size_t b)
+        {
+            const size_t ini = inicio + b * grao;
+            parciais[b] = mapear(ini, min(ini + grao, fim));
+        });
+
+        T total = move(identidade);
+        for (auto& parcial : parciais) total = reduzir(move(total), move(parcial));
+        return total;
+    }
+
+    // tamanho de bloco para n elementos divididos em até numPartes partes (mínimo GRAO_MINIMO)
+    static size_t grao(size_t n, int numPartes);
+
+    // abaixo deste número de elementos por bloco o custo de despacho supera o ganho
+    static constexpr size_t GRAO_MINIMO = 1024;
+
+private:
+    struct FilaTrabalho
+    {
+        mutex mtx;
+        deque<function<void()>> tarefas;
+    };
+
+    // executa corpo(0..numBlocos-1) no pool, com a thread chamadora participando
+    void executarBlocos(size_t numBlocos, const function<void(size_t)>& corpo);
+
+    // laço principal de cada worker
+    void laco(unsigned indice);
+
+    // pega uma tarefa da própria fila ou rouba de outra
+    bool pegarTarefa(int indice, function<void()>& tarefa);
+
+    vector<unique_ptr<FilaTrabalho>> filas;
+    vector<thread> workers;
+
+    atomic<size_t> pendentes{0};
+    atomic<unsigned> proximaFila{0};
+    atomic<bool> encerrando{false};
+    mutex sonoMtx;
+    condition_variable sonoCondVar;
+};
+
+#endif // EXECUTOR_HPP
@@ -5,6 +5,7 @@
 #include <filesystem>
 #include <sqlite3.h>
 #include <cctype>
+#include <algorithm>
 #include "../json.hpp"
 
 using json = nlohmann::json;
@@ -68,6 +69,55 @@ vector<string> Extrator::dividirLinha(const string& linha, char separador) {
     return resultado;
 }
 
+Quarentena Extrator::retirarQuarentena()
+{
+    Quarentena retirada;
+    retirada.acumular(move(quarentena));
+    return retirada;
+}
+
+void Extrator::definirPoda(PodaExtracao novaPoda)
+{
+    poda = move(novaPoda);
+}
+
+size_t Extrator::retirarPodadas()
+{
+    const size_t retiradas = podadas;
+    podadas = 0;
+    return retiradas;
+}
+
+// Converte um valor pelo tipo da coluna; célula vazia numa coluna numérica não converte (como o nulo no JSON)
+static bool converterCelula(const string& val, ColumnType tipo, Cell& celula)
+{
+    if (tipo == ColumnType::STRING)
+    {
+        celula = val;
+        return true;
+    }
+    if (val.empty()) return false;
+    try {
+        size_t usados = 0;
+        if (tipo == ColumnType::INTEGER) celula = stoi(val, &usados);
+        else celula = stod(val, &usados);
+        return usados == val.size();
+    } catch (const exception&) {
+        return false;
+    }
+}
+
+// Converte os valores de uma linha pelos tipos das colunas; devolve a coluna que não converte (-1 se todas)
+static int converterLinha(const vector<string>& valores, const vector<ColumnType>& tipos, vector<Cell>& row)
+{
+    row.resize(min(valores.size(), tipos.size()));
+    for (size_t i = 0; i < row.size(); ++i)
+    {
+        if (!converterCelula(valores[i], tipos[i], row[i])) return static_cast<int>(i);
+    }
+    return -1;
+}
+
 // Carregador genérico para arquivos CSV e TXT
 DataFrame Extrator::carregarCSVouTXT(const string& caminho, char separador)
 {
@@ -88,8 +138,8 @@ DataFrame Extrator::carregarCSVouTXT(const string& caminho, char separador)
     vector<vector<string>> linhasTemporarias;
     int maxAmostras = 8;
     
-    // Lê até 8 linhas para inferência de tipo
-    while(getline(arquivo, linha) && linhasTemporarias.size() < static_cast<size_t>(maxAmostras))
+    // Lê até 8 linhas para inferência de tipo (o limite é testado antes de ler, para não perder a linha seguinte)
+    while(linhasTemporarias.size() < static_cast<size_t>(maxAmostras) && getline(arquivo, linha))
     {
         vector<string> valores = dividirLinha(linha, separador);
 
@@ -99,7 +149,7 @@ DataFrame Extrator::carregarCSVouTXT(const string& caminho, char separador)
         // Valida se a linha tem o número certo de colunas
         if (valores.size() != colunas.size()) 
         {
-            cerr << "[AVISO] Linha ignorada - esperado: " << colunas.size() << " colunas, encontrado: " << valores.size() << endl;
+            quarentena.registrar(MotivoRejeicao::TAMANHO, "", linhaEmTexto(valores));
             continue;
         }
         
@@ -131,17 +181,28 @@ DataFrame Extrator::carregarCSVouTXT(const string& caminho, char separador)
     // Cria o DataFrame com os nomes e tipos de colunas inferidos
     DataFrame df(colunas, tipos);
 
-    // Adiciona as linhas lidas anteriormente
+    // coluna da poda (se houver): só ela é convertida, no tipo inferido, antes de decidir se a linha fica
+    const auto colunaPoda = poda.aceita ? find(colunas.begin(), colunas.end(), poda.coluna) : colunas.end();
+    const size_t idxPoda = colunaPoda != colunas.end() ? static_cast<size_t>(colunaPoda - colunas.begin()) : string::npos;
+    Cell celulaPoda;
+    auto podar = [&](const vector<string>& valores)
+    {
+        if (idxPoda == string::npos || !converterCelula(valores[idxPoda], tipos[idxPoda], celulaPoda)) return false;
+        if (poda.aceita(celulaPoda)) return false;
+        ++podadas;
+        return true;
+    };
+
+    // Adiciona as linhas lidas anteriormente; uma célula vazia numa coluna numérica vai para a quarentena
+    vector<Cell> row;
     for (const auto& valores : linhasTemporarias)
     {
-        vector<Cell> row;
-        for (size_t i = 0; i < valores.size(); ++i)
+        if (podar(valores)) continue;
+        const int colunaInvalida = converterLinha(valores, tipos, row);
+        if (colunaInvalida >= 0)
         {
-            const string& val = valores[i];
-            if (val.empty()) row.push_back(string(""));
-            else if (tipos[i] == ColumnType::INTEGER) row.push_back(stoi(val));
-            else if (tipos[i] == ColumnType::DOUBLE) row.push_back(stod(val));
-            else row.push_back(val);
+            quarentena.registrar(MotivoRejeicao::TIPO, colunas[colunaInvalida], linhaEmTexto(valores));
+            continue;
         }
         df.addRow(row);
     }
@@ -151,38 +212,30 @@ DataFrame Extrator::carregarCSVouTXT(const string& caminho, char separador)
     {
         vector<string> valores = dividirLinha(linha, separador);
 
-        // Se a linha for incompleta ou maior, ajusta ao tamanho esperado
+        // Linha incompleta ou maior que o cabeçalho vai para a quarentena
         if (valores.size() != tipos.size())
         {
-            cerr << "[AVISO] Linha ignorada - tamanho inesperado: " << valores.size() << " vs " << tipos.size()  << endl;
+            quarentena.registrar(MotivoRejeicao::TAMANHO, "", linhaEmTexto(valores));
             continue;
         }
+        if (podar(valores)) continue;
 
-        vector<Cell> row;
-        
-        for (size_t i = 0; i < valores.size() && i < tipos.size(); ++i)
+        // valor que não converte no tipo inferido da coluna também
+        const int colunaInvalida = converterLinha(valores, tipos, row);
+        if (colunaInvalida >= 0)
         {
-            const string& val = valores[i];
-            if (val.empty()) row.push_back(string(""));
-            else if (tipos[i] == ColumnType::INTEGER) row.push_back(stoi(val));
-            else if (tipos[i] == ColumnType::DOUBLE) row.push_back(stod(val));
-            else row.push_back(val);
+            quarentena.registrar(MotivoRejeicao::TIPO, colunas[colunaInvalida], linhaEmTexto(valores));
+            continue;
         }
         df.addRow(row);
     }
     return df;    
 }
 
-DataFrame Extrator::carregarJSON(const string& caminhoArquivo)
+// Monta um DataFrame a partir de uma lista de objetos JSON (compartilhado por arquivo e lote); objetos
+// com valor ausente, nulo ou de outro tipo numa coluna numérica vão para a quarentena
+static DataFrame dataFrameDeJSON(const json& j, Quarentena& quarentena, const PodaExtracao& poda, size_t& podadas)
 {
-    ifstream arquivo(caminhoArquivo);
-    if (!arquivo.is_open()) {
-        throw runtime_error("Não foi possível abrir o arquivo JSON: " + caminhoArquivo);
-    }
-
-    json j;
-    arquivo >> j;
-
     if (!j.is_array()) {
         throw runtime_error("O arquivo JSON deve conter uma lista de objetos.");
     }
@@ -201,21 +254,50 @@ DataFrame Extrator::carregarJSON(const string& caminhoArquivo)
         }
     }
 
+    // texto de um valor JSON como vai para a quarentena
+    auto texto = [](const json& valor) { return valor.is_string() ? valor.get<string>() : valor.dump(); };
+
+    // campo da coluna i no tipo dela, como a conversão abaixo o guardaria; false se não converte
+    auto converterCampo = [&](const json& obj, size_t i, Cell& celula) {
+        const string& key = colunas[i];
+        const bool presente = obj.is_object() && obj.contains(key) && !obj[key].is_null();
+        if (tipos[i] == ColumnType::STRING) {
+            celula = presente ? texto(obj[key]) : string("");
+        } else if (tipos[i] == ColumnType::INTEGER && presente && obj[key].is_number_integer()) {
+            celula = obj[key].get<int>();
+        } else if (tipos[i] == ColumnType::DOUBLE && presente && obj[key].is_number()) {
+            celula = obj[key].get<double>();
+        } else {
+            return false;
+        }
+        return true;
+    };
+
+    const auto colunaPoda = poda.aceita ? find(colunas.begin(), colunas.end(), poda.coluna) : colunas.end();
+    const size_t idxPoda = static_cast<size_t>(colunaPoda - colunas.begin());
+    Cell celulaPoda;
+
     for (const auto& obj : j) {
-        vector<Cell> linha;
-        for (size_t i = 0; i < colunas.size(); ++i) {
-            const string& key = colunas[i];
-            if (!obj.contains(key) || obj[key].is_null()) {
-                linha.push_back("");
-            } else if (tipos[i] == ColumnType::INTEGER) {
-                linha.push_back(obj[key].get<int>());
-            } else if (tipos[i] == ColumnType::DOUBLE) {
-                linha.push_back(obj[key].get<double>());
-            } else {
-                linha.push_back(obj[key].is_string() ? obj[key].get<string>() : obj[key].dump());
-            }
+        // poda pelo campo já no tipo da coluna, antes de converter o resto do objeto
+        if (colunaPoda != colunas.end() && converterCampo(obj, idxPoda, celulaPoda) && !poda.aceita(celulaPoda)) {
+            ++podadas;
+            continue;
         }
-        linhas.push_back(linha);
+
+        vector<Cell> linha(colunas.size());
+        int colunaInvalida = -1;
+        for (size_t i = 0; i < colunas.size() && colunaInvalida < 0; ++i) {
+            if (!converterCampo(obj, i, linha[i])) colunaInvalida = static_cast<int>(i);
+        }
+
+        if (colunaInvalida >= 0) {
+            vector<string> valores;
+            for (const auto& key : colunas)
+                valores.push_back(obj.is_object() && obj.contains(key) ? texto(obj[key]) : string(""));
+            quarentena.registrar(MotivoRejeicao::TIPO, colunas[colunaInvalida], linhaEmTexto(valores));
+            continue;
+        }
+        linhas.push_back(move(linha));
     }
 
     DataFrame df(colunas, tipos);
@@ -225,6 +307,25 @@ DataFrame Extrator::carregarJSON(const string& caminhoArquivo)
     return df;
 }
 
+DataFrame Extrator::carregarJSON(const string& caminhoArquivo)
+{
+    ifstream arquivo(caminhoArquivo);
+    if (!arquivo.is_open()) {
+        throw runtime_error("Não foi possível abrir o arquivo JSON: " + caminhoArquivo);
+    }
+
+    json j;
+    arquivo >> j;
+
+    return dataFrameDeJSON(j, quarentena, poda, podadas);
+}
+
+// Carrega um lote de linhas recebido em memória (lista JSON de objetos, mesmo formato dos arquivos .json)
+DataFrame Extrator::carregarLote(const string& textoJson)
+{
+    return dataFrameDeJSON(json::parse(textoJson), quarentena, poda, podadas);
+}
+
 // Função auxiliar: infere os tipos de colunas com base nos valores de uma linha
 vector<ColumnType> Extrator::inferirTipos(const vector<vector<string>>& amostras) {
     if (amostras.empty() || amostras[0].empty()) {
@@ -237,12 +338,14 @@ vector<ColumnType> Extrator::inferirTipos(const vector<vector<string>>& amostras
     for (size_t col = 0; col < numColunas; ++col) {
         bool ehInteiro = true;
         bool ehDouble = true;
+        bool temValor = false;
 
         for (const auto& linha : amostras) {
             if (col >= linha.size()) continue;
 
             const string& val = linha[col];
             if (val.empty()) continue;
+            temValor = true;
 
             // Testa se é inteiro
             try {
@@ -269,7 +372,10 @@ vector<ColumnType> Extrator::inferirTipos(const vector<vector<string>>& amostras
             if (!ehInteiro && !ehDouble) break;
         }
 
-        if (ehInteiro) {
+        // coluna vazia em toda a amostra fica texto (não há tipo para exigir)
+        if (!temValor) {
+            tipos[col] = ColumnType::STRING;
+        } else if (ehInteiro) {
             tipos[col] = ColumnType::INTEGER;
         } else if (ehDouble) {
             tipos[col] = ColumnType::DOUBLE;
@@ -3,16 +3,44 @@
 
 #include <string>     
 #include <vector>
+#include <functional>
+#include <cstddef>
+#include "quarentena.hpp"
 #include "dataframe.hpp" // Inclui o cabeçalho do DataFrame, que é uma estrutura para armazenar os dados carregados
 
 using namespace std; 
 
+// Poda empurrada para a extração: a linha cujo campo `coluna` não passa em `aceita` é descartada já na
+// leitura, antes de converter as outras células (CSV, TXT e JSON; sem a coluna no arquivo nada é podado).
+// `aceita` recebe o campo já no tipo inferido da coluna, o mesmo valor que a linha teria no DataFrame; um
+// campo que não converte não é podado (a linha segue para a conversão e a quarentena)
+struct PodaExtracao
+{
+    string coluna;
+    function<bool(const Cell&)> aceita;
+};
+
 class Extrator { 
 public:
     // Função pública para carregar um arquivo, detectando o tipo automaticamente
     DataFrame carregar(const string&);
 
+    // Função pública para carregar um lote de linhas em JSON recebido por stream (sem arquivo)
+    DataFrame carregarLote(const string&);
+
+    // linhas descartadas desde a última retirada (tamanho errado ou valor que não converte no tipo da
+    // coluna), com o motivo; quem chama entrega à quarentena da fonte
+    Quarentena retirarQuarentena();
+
+    // poda aplicada aos próximos arquivos (PodaExtracao() desliga) e linhas podadas desde a última retirada
+    void definirPoda(PodaExtracao);
+    size_t retirarPodadas();
+
 private:
+    Quarentena quarentena;
+    PodaExtracao poda;
+    size_t podadas = 0;
+
     // Função auxiliar privada para obter a extensão de um arquivo (ex: csv, txt, sqlite)
     string obterExtensao(const string&);
 
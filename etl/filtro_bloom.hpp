@@ -0,0 +1,55 @@
+#ifndef FILTRO_BLOOM_HPP
+#define FILTRO_BLOOM_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+using namespace std;
+
+// Filtro de Bloom em blocos de 64 bits: cada chave marca K bits de uma única palavra, escolhida pelos
+// bits altos do hash, e a consulta é uma leitura e um AND. Sem falsos negativos; com BITS_POR_CHAVE = 12
+// os falsos positivos ficam por volta de 1% a 2%. Os hashes já chegam misturados (hashChaveLinha).
+class FiltroBloom
+{
+public:
+    static constexpr size_t BITS_POR_CHAVE = 12;
+    static constexpr size_t K = 4;
+
+    // dimensionado para numChaves chaves (sem nenhuma inserida rejeita tudo)
+    explicit FiltroBloom(size_t numChaves = 0)
+        : palavras(max<size_t>((numChaves * BITS_POR_CHAVE + 63) / 64, 1), 0)
+    {
+    }
+
+    void inserir(size_t h) { palavras[palavra(h)] |= mascara(h); }
+
+    // false = a chave certamente não foi inserida
+    bool talvezContem(size_t h) const
+    {
+        const uint64_t m = mascara(h);
+        return (palavras[palavra(h)] & m) == m;
+    }
+
+    size_t bytes() const { return palavras.size() * sizeof(uint64_t); }
+
+private:
+    // palavra pelos 32 bits altos (redução por multiplicação, sem divisão)
+    size_t palavra(size_t h) const
+    {
+        return static_cast<size_t>(((static_cast<uint64_t>(h) >> 32) * palavras.size()) >> 32);
+    }
+
+    // K bits da palavra, 6 bits do hash para cada (os baixos)
+    static uint64_t mascara(size_t h)
+    {
+        uint64_t m = 0;
+        for (size_t k = 0; k < K; ++k) m |= uint64_t(1) << ((h >> (6 * k)) & 63);
+        return m;
+    }
+
+    vector<uint64_t> palavras;
+};
+
+#endif // FILTRO_BLOOM_HPP
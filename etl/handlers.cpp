@@ -1,14 +1,22 @@
 #include "handlers.hpp"
 #include "dataframe.hpp"
+#include "executor.hpp"
+#include "trace.hpp"
+#include "tabela_hash.hpp"
+#include "deduplicacao.hpp"
+#include "limpeza.hpp"
+#include "validacao.hpp"
+#include "juncao.hpp"
 #include <iostream>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <vector>
 #include <variant>
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
 #include <unordered_map>
-#include <unordered_set>
 
 // Função auxiliar para extrair o código da ilha (primeiros 2 dígitos)
 string extractIslandCode(const Cell& cepCell)
@@ -101,6 +109,7 @@ mutex& mtx, vector<Cell>& colValues)
 // função de gerar alertas para registros acima da média, inplace
 void Handler::meanAlert(DataFrame& input, const string& nameCol, int numThreads) 
 {
+    TRACE_ESCOPO("meanAlert", "handler");
     // Verifica se a coluna existe
     int colIndex = input.colIdx(nameCol);
     if (colIndex == -1) {
@@ -116,24 +125,16 @@ void Handler::meanAlert(DataFrame& input, const string& nameCol, int numThreads)
     int n = input.size();
     if (n == 0) return; // DataFrame vazio, nada a fazer
     
-    // Garante chunkSize mínimo de 1
-    int chunkSize = max(n / numThreads, 1); 
+    Executor& executor = Executor::global();
+    const size_t grao = Executor::grao(n, numThreads);
     
     // Fase 1: Cálculo da média
-    double sum = 0.0;
-    mutex mtxSum;
-    vector<thread> threads;
-    
-    // Percorre pedaços da coluna somando
-    for (int i = 0; i < numThreads; ++i) 
-    {
-        int start = i * chunkSize;
-        int end = (i == numThreads - 1) ? n : start + chunkSize;
-        
-        threads.emplace_back([&input, colIndex, start, end, &sum, &mtxSum]()
+    // Percorre pedaços da coluna somando (somas parciais combinadas na ordem dos blocos)
+    double sum = executor.parallel_reduce(0, n, grao, 0.0,
+        [&input, colIndex](size_t start, size_t end)
         {
             double localSum = 0.0;
-            for (int j = start; j < end; ++j)
+            for (size_t j = start; j < end; ++j)
             {
                 const Cell& val = input.getRow(j)[colIndex]; 
                 try
@@ -146,55 +147,35 @@ void Handler::meanAlert(DataFrame& input, const string& nameCol, int numThreads)
                     // Continua sem adicionar ao somatório
                 }
             }
-            lock_guard<mutex> lock(mtxSum);
-            sum += localSum;
-        });
-    }
-    
-    for (auto& t : threads) t.join();
-    threads.clear();
+            return localSum;
+        },
+        [](double a, double b) { return a + b; });
     
     double mean = sum / n;
     
     // Fase 2: Gerar vetor de alertas ("Vermelho" se valor > média, "Verde" caso contrário)
     vector<Cell> alertas(n);
-    mutex mtxAlerts;
     
     // Percorre a coluna original identificando as linhas acima/abaixo da média
-    for (int i = 0; i < numThreads; ++i)
+    // (cada bloco escreve apenas no seu intervalo do vetor)
+    executor.parallel_for(0, n, grao, [&input, colIndex, mean, &alertas](size_t start, size_t end)
     {
-        int start = i * chunkSize;
-        int end = (i == numThreads - 1) ? n : start + chunkSize;
-        
-        threads.emplace_back([&input, colIndex, start, end, mean, &alertas, &mtxAlerts]()
+        for (size_t j = start; j < end; ++j)
         {
-            vector<Cell> localAlerts(end - start);
+            const Cell& val = input.getRow(j)[colIndex]; 
             
-            for (int j = start; j < end; ++j)
+            try
             {
-                const Cell& val = input.getRow(j)[colIndex]; 
-                
-                try
-                {
-                    double currentVal = toDouble(val);
-                    localAlerts[j - start] = (currentVal > mean) ? "Vermelho" : "Verde";
-                } 
-                catch (const exception& e)
-                {
-                    cerr << "Erro ao converter valor para double: " << e.what() << endl;
-                    localAlerts[j - start] = "Verde"; // Valor inválido considerado abaixo da média
-                }    
-            }
-
-            // Atualiza o vetor compartilhado
-            for (size_t j = 0; j < localAlerts.size(); ++j)
+                double currentVal = toDouble(val);
+                alertas[j] = (currentVal > mean) ? "Vermelho" : "Verde";
+            } 
+            catch (const exception& e)
             {
-                alertas[start + j] = localAlerts[j];
-            }
-        });
-    }
-    
-    for (auto& t : threads) t.join();
+                cerr << "Erro ao converter valor para double: " << e.what() << endl;
+                alertas[j] = "Verde"; // Valor inválido considerado abaixo da média
+            }    
+        }
+    });
 
     // Adiciona a nova coluna ao DataFrame
     input.addColumn("Alertas" , ColumnType::STRING, alertas, numThreads);
@@ -269,6 +250,7 @@ void Handler::agregarGrupoPar(const vector<Cell>& uniqueGroups,
 
 DataFrame Handler::groupedDf(const DataFrame& input, const string& groupedCol, const string& aggCol, int numThreads, bool groupIlha) 
 {
+    TRACE_ESCOPO("groupedDf", "handler");
     const int colIdxGroup = input.colIdx(groupedCol);
     const int colIdxAgg = input.colIdx(aggCol);
     const int numRows = input.size();
@@ -281,274 +263,252 @@ DataFrame Handler::groupedDf(const DataFrame& input, const string& groupedCol, c
     if (numThreads <= 0)
         throw std::invalid_argument("Número de threads deve ser maior que zero.");
 
-    const int chunkSize = (numRows + numThreads - 1) / numThreads;
+    // chave inteira de uma linha (código da ilha quando groupIlha); lança para linhas inválidas
+    auto chaveLinha = [&](const vector<Cell>& row) -> int
+    {
+        if (colIdxGroup >= int(row.size()) || colIdxAgg >= int(row.size()))
+            throw runtime_error("Índice fora do intervalo em linha do DataFrame.");
 
-    // Fase 1: Extração paralela
-    vector<int> groupKeys(numRows);
-    vector<double> aggValues(numRows);
-    vector<thread> threads;
+        const Cell& groupCell = row[colIdxGroup];
 
-    for (int t = 0; t < numThreads; ++t) {
-        threads.emplace_back([&, t]() {
+        int groupKey;
+
+        // Conversão segura do valor da coluna de agrupamento para int
+        if (holds_alternative<int>(groupCell)) {
+            groupKey = get<int>(groupCell);
+        } else if (holds_alternative<double>(groupCell)) {
+            groupKey = static_cast<int>(get<double>(groupCell));
+        } else if (holds_alternative<string>(groupCell)) {
             try {
-                const int start = t * chunkSize;
-                const int end = min(start + chunkSize, numRows);
+                groupKey = stoi(get<string>(groupCell));
+            } catch (...) {
+                throw runtime_error("Falha ao converter string para int em coluna de agrupamento.");
+            }
+        } else {
+            throw runtime_error("Tipo inválido em coluna de agrupamento.");
+        }
 
-                for (int i = start; i < end; ++i) {
-                    const auto& row = input.getRow(i);
+        if (groupIlha) {
+            string groupStr;
+            if (holds_alternative<string>(groupCell)) {
+                groupStr = get<string>(groupCell);
+            } else if (holds_alternative<int>(groupCell)) {
+                groupStr = to_string(get<int>(groupCell));
+            } else if (holds_alternative<double>(groupCell)) {
+                groupStr = to_string(static_cast<int>(get<double>(groupCell)));
+            } else {
+                throw runtime_error("Tipo inválido para extração do código da ilha.");
+            }
 
-                    if (colIdxGroup >= int(row.size()) || colIdxAgg >= int(row.size()))
-                        throw runtime_error("Índice fora do intervalo em linha do DataFrame.");
+            string islandCodeStr = extractIslandCode(groupStr);
+            try {
+                groupKey = stoi(islandCodeStr);
+            } catch (...) {
+                throw runtime_error("Falha ao converter código de ilha para inteiro.");
+            }
+        }
 
-                    const Cell& groupCell = row[colIdxGroup];
-                    const Cell& aggCell = row[colIdxAgg];
+        return groupKey;
+    };
 
-                    int groupKey;
+    DataFrame output({groupedCol, "Total_" + aggCol}, { ColumnType::STRING, ColumnType::DOUBLE });
+    const size_t grao = Executor::grao(numRows, numThreads);
+
+    // A amostra que estima os grupos também dá o intervalo das chaves
+    int menorChave = numeric_limits<int>::max(), maiorChave = numeric_limits<int>::min();
+    const size_t gruposEstimados = estimarNumGrupos(numRows, [&](size_t i) {
+        const int chave = chaveLinha(input.getRow(i));
+        menorChave = min(menorChave, chave);
+        maiorChave = max(maiorChave, chave);
+        return HashRapido<int>()(chave);
+    });
 
-                    // Conversão segura do valor da coluna de agrupamento para int
-                    if (holds_alternative<int>(groupCell)) {
-                        groupKey = get<int>(groupCell);
-                    } else if (holds_alternative<double>(groupCell)) {
-                        groupKey = static_cast<int>(get<double>(groupCell));
-                    } else if (holds_alternative<string>(groupCell)) {
-                        try {
-                            groupKey = stoi(get<string>(groupCell));
-                        } catch (...) {
-                            throw runtime_error("Falha ao converter string para int em coluna de agrupamento.");
+    // Chaves num intervalo pequeno (ilhas, hospitais, flags): soma direto em vetores indexados pela
+    // chave, sem hash; se o intervalo real passar do limite, segue para a tabela hash
+    if (menorChave <= maiorChave && static_cast<int64_t>(maiorChave) - menorChave < SomaDensa::LIMITE)
+    {
+        atomic<bool> foraDoIntervalo{false};
+        SomaDensa totais = Executor::global().parallel_reduce(
+            0, numRows, grao, SomaDensa(),
+            [&](size_t start, size_t end)
+            {
+                SomaDensa parcial;
+                try {
+                    for (size_t i = start; i < end; ++i) {
+                        const auto& row = input.getRow(i);
+                        if (foraDoIntervalo.load(memory_order_relaxed)) break;
+                        if (!parcial.adicionar(chaveLinha(row), toDouble(row[colIdxAgg]))) {
+                            foraDoIntervalo = true;
+                            break;
                         }
-                    } else {
-                        throw runtime_error("Tipo inválido em coluna de agrupamento.");
                     }
+                } catch (const std::exception& e) {
+                    cerr << "[Erro Bloco " << start << "-" << end << "] " << e.what() << endl;
+                }
+                return parcial;
+            },
+            [&](SomaDensa total, SomaDensa parcial)
+            {
+                if (!total.acumular(parcial)) foraDoIntervalo = true;
+                return total;
+            });
 
-                    if (groupIlha) {
-                        string groupStr;
-                        if (holds_alternative<string>(groupCell)) {
-                            groupStr = get<string>(groupCell);
-                        } else if (holds_alternative<int>(groupCell)) {
-                            groupStr = to_string(get<int>(groupCell));
-                        } else if (holds_alternative<double>(groupCell)) {
-                            groupStr = to_string(static_cast<int>(get<double>(groupCell)));
-                        } else {
-                            throw runtime_error("Tipo inválido para extração do código da ilha.");
-                        }
-
-                        string islandCodeStr = extractIslandCode(groupStr);
-                        try {
-                            groupKeys[i] = stoi(islandCodeStr);
-                        } catch (...) {
-                            throw runtime_error("Falha ao converter código de ilha para inteiro.");
-                        }
-                    } else {
-                        groupKeys[i] = groupKey;
-                    }
+        if (!foraDoIntervalo)
+        {
+            totais.paraCada([&](int key, uint64_t, double sum, double) {
+                output.addRow({to_string(key), sum});
+            });
+            return output;
+        }
+    }
 
-                    aggValues[i] = toDouble(aggCell);
+    // Muitos grupos (ex.: CEPs de 5 dígitos, IDs de paciente): a soma por radix evita tabelas
+    // parciais maiores que a cache e a combinação serial no fim
+    if (size_t numParticoes = particoesRadix(gruposEstimados, sizeof(pair<int, double>) + 1, numThreads))
+    {
+        // fase 1: cada bloco espalha (chave, valor) pelas partições do hash da chave
+        const size_t numBlocos = (numRows + grao - 1) / grao;
+        vector<vector<vector<pair<int, double>>>> espalhados(numBlocos, vector<vector<pair<int, double>>>(numParticoes));
+        Executor::global().parallel_for(0, numRows, grao, [&](size_t start, size_t end)
+        {
+            auto& destino = espalhados[start / grao];
+            try {
+                for (size_t i = start; i < end; ++i) {
+                    const auto& row = input.getRow(i);
+                    const int groupKey = chaveLinha(row);
+                    destino[particaoHash(HashRapido<int>()(groupKey), numParticoes)].push_back({groupKey, toDouble(row[colIdxAgg])});
                 }
             } catch (const std::exception& e) {
-                cerr << "[Erro Thread Fase 1 " << t << "] " << e.what() << endl;
+                cerr << "[Erro Bloco " << start << "-" << end << "] " << e.what() << endl;
             }
         });
-    }
 
-    for (auto& thread : threads) thread.join();
-    threads.clear();
+        // fase 2: cada partição é somada e finalizada por uma única tarefa
+        vector<vector<vector<Cell>>> linhasParticao(numParticoes);
+        Executor::global().parallel_for(0, numParticoes, 1, [&](size_t ini, size_t fim)
+        {
+            for (size_t p = ini; p < fim; ++p)
+            {
+                TabelaHash<int, double> somas;
+                for (auto& blocos : espalhados)
+                {
+                    for (const auto& [key, value] : blocos[p]) somas[key] += value;
+                    vector<pair<int, double>>().swap(blocos[p]);
+                }
+                somas.paraCada([&](int key, double sum) {
+                    linhasParticao[p].push_back({to_string(key), sum});
+                });
+            }
+        });
 
-    // Fase 2: Agregação paralela
-    vector<unordered_map<int, double>> partialSums(numThreads);
+        for (const auto& linhas : linhasParticao)
+            for (const auto& linha : linhas) output.addRow(linha);
+        return output;
+    }
 
-    for (int t = 0; t < numThreads; ++t) {
-        threads.emplace_back([&, t]() {
-            const int start = t * chunkSize;
-            const int end = min(start + chunkSize, numRows);
+    // Extração da chave e agregação parcial em uma única passada por bloco;
+    // os mapas parciais são combinados ao final
+    auto somarBloco = [&](size_t start, size_t end)
+    {
+        TabelaHash<int, double> localSums;
 
-            for (int i = start; i < end; ++i) {
-                partialSums[t][groupKeys[i]] += aggValues[i];
+        try {
+            for (size_t i = start; i < end; ++i) {
+                const auto& row = input.getRow(i);
+                localSums[chaveLinha(row)] += toDouble(row[colIdxAgg]);
             }
-        });
-    }
+        } catch (const std::exception& e) {
+            cerr << "[Erro Bloco " << start << "-" << end << "] " << e.what() << endl;
+        }
 
-    for (auto& thread : threads) thread.join();
+        return localSums;
+    };
 
     // Combinando resultados
-    unordered_map<int, double> totalSums;
-    for (const auto& map : partialSums) {
-        for (const auto& [key, value] : map) {
-            totalSums[key] += value;
-        }
-    }
+    TabelaHash<int, double> totalSums = Executor::global().parallel_reduce(
+        0, numRows, grao, TabelaHash<int, double>(), somarBloco,
+        [](TabelaHash<int, double> total, TabelaHash<int, double> parcial)
+        {
+            parcial.paraCada([&](int key, double value) { total[key] += value; });
+            return total;
+        });
 
     // Construindo o DataFrame de saída
-    DataFrame output({groupedCol, "Total_" + aggCol}, { ColumnType::STRING, ColumnType::DOUBLE });
-
-    for (const auto& [key, sum] : totalSums) {
+    totalSums.paraCada([&](int key, double sum) {
         output.addRow({to_string(key), sum});
-    }
+    });
 
     return output;
 }
 
-
-// Handler para limpeza de dados - remove duplicatas e linhas/colunas com muitos valores nulos
-void Handler::dataCleaner(DataFrame& input)
+// group-by genérico: agregação parcial por bloco e combinação paralela por partição
+DataFrame Handler::groupBy(const DataFrame& input, const vector<string>& chaves,
+    const vector<Agregacao>& agregacoes, int numThreads)
 {
-    // Primeiro passo: remover linhas duplicadas
-    removeDuplicateRows(input);
-    
-    // Segundo passo: remover linhas com muitos valores nulos
-    removeSparseRows(input, 0.9);
-    
-    // Terceiro passo: remover colunas com muitos valores nulos
-    removeSparseColumns(input, 0.9);
+    return agruparPor(input, chaves, agregacoes, numThreads);
 }
 
-// Função auxiliar para verificar se uma célula é nula
-bool Handler::isNullCell(const Cell& cell)
-{
-    // Verifica se é string vazia (assumindo que strings vazias representam nulos)
-    if (holds_alternative<string>(cell)) return get<string>(cell).empty();
-    else if (holds_alternative<int>(cell)) return get<int>(cell) == 0;
-    else if (holds_alternative<double>(cell)) return get<double>(cell) == 0.0;
-    return false; // Outros tipos não são considerados nulos nesta implementação
-}
 
-// Hash de uma linha para detecção rápida de duplicatas
-size_t hashRow(const vector<Cell>& row)
+// Handler para limpeza de dados - remove duplicatas e colunas com muitos valores nulos
+void Handler::dataCleaner(DataFrame& input)
 {
-    size_t seed = row.size();
-    for (const auto& cell : row)
-    {
-        seed ^= std::visit([](auto&& val) {
-            return std::hash<std::decay_t<decltype(val)>>{}(val);
-        }, cell) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-    }
-    return seed;
+    dataCleaner(input, ConfigLimpeza(), static_cast<int>(Executor::global().numThreads()));
 }
 
-// Função auxiliar para remover linhas duplicadas
-void Handler::removeDuplicateRows(DataFrame& input)
+// Limpeza numa única varredura (ver limpeza.hpp), com limites configuráveis
+void Handler::dataCleaner(DataFrame& input, const ConfigLimpeza& config, int numThreads)
 {
-
-    unordered_set<size_t> seenHashes;
-    vector<vector<Cell>> uniqueRows;
-    const int numRows = input.size();
-
-    for (int i = 0; i < numRows; ++i)
-    {
-        const auto& row = input.getRow(i);
-        size_t h = hashRow(row);
-        if (seenHashes.insert(h).second)
-        {
-            uniqueRows.push_back(row);
-        }
-    }
+    TRACE_ESCOPO("dataCleaner", "handler");
+    limparDataFrame(input, config, numThreads);
 }
 
-// Função auxiliar para remover linhas com muitos valores nulos
-void Handler::removeSparseRows(DataFrame& input, double nullThreshold)
+// Função auxiliar para verificar se uma célula é nula
+bool Handler::isNullCell(const Cell& cell)
 {
-    const int numRows = input.size();
-    const int numCols = input.numCols();
-    const int thresholdCount = static_cast<int>(numRows * nullThreshold);
-
-    vector<int> nullCounts(numCols, 0);
-
-    for (int i = 0; i < numRows; ++i)
-    {
-        const auto& row = input.getRow(i);
-        for (int col = 0; col < numCols; ++col)
-        {
-            if (isNullCell(row[col])) nullCounts[col]++;
-        }
-    }
-
-    vector<int> keepIndices;
-    for (int col = 0; col < numCols; ++col)
-    {
-        if (nullCounts[col] < thresholdCount) keepIndices.push_back(col);
-    }
-
-    vector<string> newColNames;
-    vector<ColumnType> newColTypes;
-    for (int col : keepIndices)
-    {
-        newColNames.push_back(input.getColumnNames()[col]);
-        newColTypes.push_back(input.typeCol(col));
-    }
-
-    DataFrame cleaned(newColNames, newColTypes);
-    for (int i = 0; i < numRows; ++i)
-    {
-        const auto& row = input.getRow(i);
-        vector<Cell> newRow;
-        newRow.reserve(keepIndices.size());
-        for (int col : keepIndices) newRow.push_back(row[col]);
-        cleaned.addRow(std::move(newRow));
-    }
-
-    input = std::move(cleaned);
+    // String vazia, inteiro 0 ou double 0.0 (mesma regra da limpeza)
+    return celulaNulaLimpeza(cell);
 }
 
-// Função auxiliar para remover colunas com muitos valores nulos
-void Handler::removeSparseColumns(DataFrame& input, double nullThreshold)
+// Remove linhas repetidas nas colunas-chave (todas quando vazio), mantendo a primeira ocorrência
+void Handler::removeDuplicates(DataFrame& input, const vector<string>& keyCols, int numThreads)
 {
-    const int numRows = input.size();
-    const int numCols = input.numCols();
-    const int thresholdCount = static_cast<int>(numRows * nullThreshold);
-
-    vector<int> nullCounts(numCols, 0);
-
-    for (int i = 0; i < numRows; ++i)
-    {
-        const auto& row = input.getRow(i);
-        for (int col = 0; col < numCols; ++col)
-        {
-            if (isNullCell(row[col])) nullCounts[col]++;
-        }
-    }
-
-    vector<int> keepIndices;
-    for (int col = 0; col < numCols; ++col)
-    {
-        if (nullCounts[col] < thresholdCount) keepIndices.push_back(col);
-    }
-
-    vector<string> newColNames;
-    vector<ColumnType> newColTypes;
-    for (int col : keepIndices)
-    {
-        newColNames.push_back(input.getColumnNames()[col]);
-        newColTypes.push_back(input.typeCol(col));
-    }
-
-    DataFrame cleaned(newColNames, newColTypes);
-    for (int i = 0; i < numRows; ++i)
-    {
-        const auto& row = input.getRow(i);
-        vector<Cell> newRow;
-        newRow.reserve(keepIndices.size());
-        for (int col : keepIndices) newRow.push_back(row[col]);
-        cleaned.addRow(std::move(newRow));
-    }
-
-    input = std::move(cleaned);
+    TRACE_ESCOPO("removeDuplicates", "handler");
+    removerDuplicatas(input, keyCols, numThreads);
 }
 
 // Tratador para validação de dados
-void Handler::validateDataFrame(DataFrame& input, int numThreads)
+void Handler::validateDataFrame(DataFrame& input, int numThreads, Quarentena* quarentena)
 {
+    TRACE_ESCOPO("validateDataFrame", "handler");
     if (input.empty()) return;
     
     const int numRows = input.size();
-    vector<bool> validRows(numRows, true);
     
     // Analisa as colunas para determinar regras de validação
     vector<ColumnValidationRules> rules = analyzeColumnsForValidation(input, min(20, numRows));
     
-    // Valida as linhas em paralelo
-    validateRows(input, rules, validRows, numThreads);
+    // Compila cada regra uma vez e valida coluna a coluna em paralelo
+    vector<ValidadorColuna> validadores;
+    for (size_t col = 0; col < rules.size(); ++col) validadores.push_back(compileRule(rules[col], col));
     
-    // Cria novo DataFrame apenas com linhas válidas
-    createValidatedDataFrame(input, validRows);
+    // Mantém apenas as linhas válidas
+    createValidatedDataFrame(input, validarLinhas(input, validadores, numThreads), validadores, quarentena);
+}
+
+void Handler::validateDataFrame(DataFrame& input, const EsquemaValidacao* esquema, int numThreads, Quarentena* quarentena)
+{
+    if (!esquema)
+    {
+        validateDataFrame(input, numThreads, quarentena);
+        return;
+    }
+
+    TRACE_ESCOPO("validateDataFrame", "handler");
+    if (input.empty()) return;
+
+    // validadores já compilados na carga das regras; aqui só são ligados às colunas
+    const vector<ValidadorColuna> validadores = esquema->vincular(input);
+    createValidatedDataFrame(input, validarLinhas(input, validadores, numThreads), validadores, quarentena);
 }
 
 vector<Handler::ColumnValidationRules> Handler::analyzeColumnsForValidation(const DataFrame& df, int sampleSize)
@@ -654,139 +614,61 @@ void Handler::analyzeColumnPattern(const DataFrame& df, int colIndex, int sample
     }
 }
 
-void Handler::validateRows(DataFrame& input, const vector<ColumnValidationRules>& rules, vector<bool>& validRows, int numThreads)
+ValidadorColuna Handler::compileRule(const ColumnValidationRules& rule, size_t col)
 {
-    const int numRows = input.size();
-    mutex mtx;
-    
-    int chunkSize = max(numRows / numThreads, 1);
-    vector<thread> threads;
-    
-    for (int t = 0; t < numThreads; ++t)
-    {
-        threads.emplace_back([&, t]()
-        {
-            const int start = t * chunkSize;
-            const int end = (t == numThreads - 1) ? numRows : start + chunkSize;
-            
-            for (int i = start; i < end; ++i)
-            {
-                bool rowValid = true;
-                const auto& row = input.getRow(i);
-                
-                for (size_t col = 0; col < rules.size() && rowValid; ++col)
-                {
-                    if (!isValidCell(row[col], rules[col])) rowValid = false;
-                }
-                
-                if (!rowValid)
-                {
-                    lock_guard<mutex> lock(mtx);
-                    validRows[i] = false;
-                }
-            }
-        });
-    }
-    
-    for (auto& t : threads) t.join();
-}
-
-bool Handler::isValidCell(const Cell& cell, const ColumnValidationRules& rule) 
-{
-    if (isNullCell(cell)) return true;
-    
-    string strVal = toString(cell);
-
     // Ignora validação se o nome da coluna for "data"
-    if (toLower(rule.name) == "data") return true;
-    
-    // Validação para CEPs
-    if (rule.isIslandCEP || rule.isRegionCEP)
+    if (toLower(rule.name) == "data")
     {
-        if (int(strVal.length()) != rule.maxLength) return false;
-        if (!all_of(strVal.begin(), strVal.end(), ::isdigit)) return false;
-        return true;
+        ValidadorColuna todos;
+        todos.coluna = col;
+        todos.tipoColuna = rule.type;
+        return todos;
     }
     
-    // Validação para booleanos
-    if (rule.isBoolean) return rule.allowedStrings.find(strVal) != rule.allowedStrings.end();
+    // CEPs: texto só com dígitos, no tamanho da regra
+    if (rule.isIslandCEP || rule.isRegionCEP) return validadorDigitos(col, rule.type, rule.maxLength);
     
-    // Validação numérica
-    try
-    {
-        double val = toDouble(cell);
-        if (!rule.allowNegative && val < 0) return false;
-        if (val < rule.minValue || val > rule.maxValue) return false;
-    } catch (...)
-    {
-        return false;
-    }
+    // Booleanos: conjunto de valores aceitos
+    if (rule.isBoolean) return validadorConjunto(col, rule.type, vector<string>(rule.allowedStrings.begin(), rule.allowedStrings.end()));
     
-    return true;
+    // Numéricos: faixa (negativos proibidos viram mínimo 0)
+    const double minimo = rule.allowNegative ? rule.minValue : max(rule.minValue, 0.0);
+    return validadorFaixa(col, rule.type, minimo, rule.maxValue);
 }
 
-void Handler::createValidatedDataFrame(DataFrame& input, const vector<bool>& validRows)
+void Handler::createValidatedDataFrame(DataFrame& input, const MascaraLinhas& invalidRows,
+    const vector<ValidadorColuna>& validadores, Quarentena* quarentena)
 {
-    vector<string> colNames = input.getColumnNames();
-    vector<ColumnType> colTypes;
-    for (int i = 0; i < input.numCols(); ++i)
+    // só as linhas reprovadas são reavaliadas, para achar o primeiro validador que as reprova
+    if (quarentena)
     {
-        colTypes.push_back(input.typeCol(i));
-    }
-    
-    DataFrame cleaned(colNames, colTypes);
-    for (size_t i = 0; i < validRows.size(); ++i)
-    {
-        if (validRows[i])
+        const auto& nomes = input.getColumnNames();
+        for (size_t i = 0; i < static_cast<size_t>(input.size()); ++i)
         {
-            cleaned.addRow(input.getRow(i));
+            if (!invalidRows.marcada(i)) continue;
+            const vector<Cell>& linha = input.getRow(i);
+            for (const ValidadorColuna& v : validadores)
+            {
+                if (celulaValida(v, linha[v.coluna])) continue;
+                quarentena->registrar(motivoReprovacao(v, linha[v.coluna]), nomes[v.coluna], linha);
+                break;
+            }
         }
     }
-    
-    input = move(cleaned);
+
+    input.keepRows(linhasNaoMarcadas(invalidRows, input.size()));
 }
 
-void Handler::filterInvalidAges(DataFrame& input, const string& ageColumnName, int maxAge, int numThreads)
+void Handler::filterInvalidAges(DataFrame& input, const string& ageColumnName, int maxAge, int numThreads, Quarentena* quarentena)
 {
     int colIndex = input.colIdx(ageColumnName);
     if (colIndex == -1) return;
     
-    const int numRows = input.size();
-    vector<bool> validRows(numRows, true);
-    mutex mtx;
-    
-    int chunkSize = max(numRows / numThreads, 1);
-    vector<thread> threads;
-    
-    for (int t = 0; t < numThreads; ++t)
-    {
-        threads.emplace_back([&, t]() {
-            const int start = t * chunkSize;
-            const int end = (t == numThreads - 1) ? numRows : start + chunkSize;
-            
-            for (int i = start; i < end; ++i)
-            {
-                const Cell& cell = input.getRow(i)[colIndex];
-                
-                try 
-                {
-                    double age = toDouble(cell);
-                    if (age < 0 || age > maxAge)
-                    {
-                        lock_guard<mutex> lock(mtx);
-                        validRows[i] = false;
-                    }
-                } catch (...)
-                {
-                    lock_guard<mutex> lock(mtx);
-                    validRows[i] = false;
-                }
-            }
-        });
-    }
+    // idade fora de [0, maxAge] ou não numérica
+    ValidadorColuna idade = validadorFaixa(colIndex, input.typeCol(colIndex), 0, maxAge);
+    idade.aceitaNulos = false;
     
-    for (auto& t : threads) t.join();
-    createValidatedDataFrame(input, validRows);
+    createValidatedDataFrame(input, validarLinhas(input, {idade}, numThreads), {idade}, quarentena);
 }
 
 // Funções auxiliares
@@ -806,74 +688,187 @@ bool Handler::contains(const string& str, const string& substr)
     return str.find(substr) != string::npos;
 }
 
-void mergeTwoDataFrames(
-    DataFrame& df1, const DataFrame& df2,
-    const string& cepColName, const string& valueCol2, const string& suffix,
-    int numThreads = 1
-) {
-    // indíces das colunas desejadas
-    int cepIdx1 = df1.colIdx(cepColName);
-    int cepIdx2 = df2.colIdx(cepColName);
-    int valIdx2 = df2.colIdx(valueCol2);
-
-    // valores referentes do df1 no df2
-    unordered_map<string, Cell> valueMap;
-    for (int i = 0; i < df2.size(); ++i) 
+// código da ilha (dois primeiros dígitos do CEP) como inteiro, sem montar strings; mesma regra de
+// extractIslandCode ("5" e 5 viram 05, CEP sem dígitos vira 00)
+static int islandCodeFromText(const string& texto)
+{
+    int codigo = 0, digitos = 0;
+    for (char c : texto)
     {
-        // itera a linha e desbore o CEP
-        const auto& row = df2.getRow(i);
-        string islandCode = extractIslandCode(row[cepIdx2]);
-        // acha o valor de CEP na coluna desejada do df2
-        Cell valor = row[valIdx2];
-        valueMap[islandCode] = valor;  
+        if (!isdigit(static_cast<unsigned char>(c))) continue;
+        codigo = codigo * 10 + (c - '0');
+        if (++digitos == 2) break;
     }
+    return codigo;
+}
+
+static int islandCodeValue(const Cell& cepCell)
+{
+    if (const string* texto = get_if<string>(&cepCell)) return islandCodeFromText(*texto);
+
+    long long valor = holds_alternative<int>(cepCell) ? get<int>(cepCell) : static_cast<int>(get<double>(cepCell));
+    valor = llabs(valor);
+    while (valor >= 100) valor /= 10;
+    return static_cast<int>(valor);
+}
+
+// Ordenação paralela com a propriedade "ordenado por" (ver ordenacao.hpp)
+void Handler::sortBy(DataFrame& input, const vector<string>& cols, int numThreads)
+{
+    TRACE_ESCOPO("sortBy", "handler");
+    ordenarPor(input, cols, numThreads);
+}
+
+// Junção genérica, por hash ou por intercalação (ver juncao.hpp)
+DataFrame Handler::join(const DataFrame& left, const DataFrame& right, const ConfigJuncao& config, int numThreads)
+{
+    return juntar(left, right, config, numThreads);
+}
 
-    // inicializa a coluna a ser adicionada
-    string newColName = valueCol2 + suffix;
-    ColumnType newColType = df2.typeCol(valIdx2);
+// chave das junções do merge: código numérico da ilha de cada linha, numa coluna a mais (a última)
+static const string ISLAND_KEY = "__ilha";
 
-    // preenche a coluna com os valores na ordem certa
-    vector<Cell> newColValues;
-    for (int i = 0; i < df1.size(); ++i) 
+static void addIslandKey(DataFrame& df, const string& cepColName, int numThreads)
+{
+    const size_t cepIdx = df.colIdx(cepColName);
+    if (cepIdx == static_cast<size_t>(-1))
+        throw invalid_argument("Coluna CEP não encontrada em um dos DataFrames");
+
+    const size_t n = df.size();
+    vector<Cell> ilhas(n);
+    Executor::global().parallel_for(0, n, Executor::grao(n, numThreads), [&](size_t inicio, size_t fim)
     {
-        const auto& row = df1.getRow(i);
-        string islandCode = extractIslandCode(row[cepIdx1]);
+        for (size_t i = inicio; i < fim; ++i) ilhas[i] = islandCodeValue(df.getRow(i)[cepIdx]);
+    });
+    df.addColumn(ISLAND_KEY, ColumnType::INTEGER, ilhas, numThreads);
+}
 
-        if (valueMap.count(islandCode)) 
-        {
-            newColValues.push_back(valueMap[islandCode]);
-        } else 
+// colunas de um DataFrame com a chave da ilha, sem ela
+static vector<string> withoutIslandKey(const DataFrame& df)
+{
+    const auto& nomes = df.getColumnNames();
+    return vector<string>(nomes.begin(), nomes.end() - 1);
+}
+
+static vector<size_t> indicesWithoutIslandKey(const DataFrame& df)
+{
+    vector<size_t> indices(df.numCols() - 1);
+    for (size_t c = 0; c < indices.size(); ++c) indices[c] = c;
+    return indices;
+}
+
+// Dimensão do merge: o agregado da fonte com a chave da ilha e a tabela de junção por ela, montada uma vez
+TabelaJuncao Handler::islandDimension(DataFrame dim, const string& cepColName, int numThreads)
+{
+    TRACE_ESCOPO("islandDimension", "handler");
+    addIslandKey(dim, cepColName, numThreads);
+    return TabelaJuncao(move(dim), {ISLAND_KEY}, numThreads);
+}
+
+// hash da chave da ilha como as dimensões o calculam (única coluna-chave, inteira)
+static size_t islandKeyHash(vector<Cell>& chave, int ilha)
+{
+    static const vector<size_t> indice = {0};
+    chave.assign(1, ilha);
+    return hashChaveLinha(chave, indice);
+}
+
+PodaExtracao Handler::islandPruning(const string& cepColName, const vector<shared_ptr<const TabelaJuncao>>& dims)
+{
+    PodaExtracao poda;
+    poda.coluna = cepColName;
+    // mesma chave da junção: o código da ilha tirado da célula já no tipo da coluna ("01234" como inteiro é 12)
+    poda.aceita = [dims, chave = vector<Cell>()](const Cell& cep) mutable
+    {
+        const size_t h = islandKeyHash(chave, islandCodeValue(cep));
+        for (const auto& dim : dims)
+            if (dim->getFiltro().talvezContem(h)) return true;
+        return false;
+    };
+    return poda;
+}
+
+size_t Handler::pruneByIslands(DataFrame& df, const string& cepColName, const vector<shared_ptr<const TabelaJuncao>>& dims,
+    int numThreads)
+{
+    TRACE_ESCOPO("pruneByIslands", "handler");
+
+    const size_t cepIdx = df.colIdx(cepColName);
+    if (cepIdx == static_cast<size_t>(-1))
+        throw invalid_argument("Coluna CEP não encontrada no DataFrame: " + cepColName);
+
+    // uma marca por linha, em paralelo; a confirmação é exata (filtro e depois a tabela de cada dimensão)
+    const size_t n = df.size();
+    vector<char> fica(n, 0);
+    Executor::global().parallel_for(0, n, Executor::grao(n, numThreads), [&](size_t inicio, size_t fim)
+    {
+        static const vector<size_t> indice = {0};
+        vector<Cell> chave;
+        for (size_t i = inicio; i < fim; ++i)
         {
-            // Caso não encontre, coloca valor vazio
-            newColValues.push_back(Cell());  
+            const size_t h = islandKeyHash(chave, islandCodeValue(df.getRow(i)[cepIdx]));
+            for (const auto& dim : dims)
+                if (dim->contem(chave, indice, h)) { fica[i] = 1; break; }
         }
-    }
-    // Adiciona a nova coluna ao df1
-    df1.addColumn(newColName, newColType, newColValues, numThreads);
-}
+    });
 
+    vector<size_t> indices;
+    for (size_t i = 0; i < n; ++i)
+        if (fica[i]) indices.push_back(i);
+    const size_t removidas = n - indices.size();
+    if (removidas) df.keepRows(indices);
+    return removidas;
+}
 
-                    
 map<string, DataFrame> Handler::mergeByCEP(DataFrame& dfA, DataFrame& dfB, DataFrame& dfC, const string& cepColName,
     const string& colB, const string& colC, int numThreads)
 {
-    map<string, DataFrame> results;
-    
     // Verifica se a coluna CEP existe em todos os DataFrames
     if (int(dfA.colIdx(cepColName)) == -1 || int(dfB.colIdx(cepColName)) == -1 || int(dfC.colIdx(cepColName)) == -1)
     {
         throw invalid_argument("Coluna CEP não encontrada em um dos DataFrames");
     }
-    DataFrame guardaA = dfA;
-    
-    mergeTwoDataFrames(dfA, dfB,cepColName,colB, "_B", numThreads);
-    results.insert({"AB", dfA});
-    mergeTwoDataFrames(dfB, dfC,cepColName,colC, "_C", numThreads);
-    results.insert({"BC", dfB});
-    mergeTwoDataFrames(guardaA, dfC, cepColName,colC,  "_C", numThreads);
-    results.insert({"AC", guardaA});
-    mergeTwoDataFrames(dfA, dfC,cepColName,colC, "_B", numThreads);
-    results.insert({"ABC", dfA});
-    
+
+    return mergeByCEP(dfA, islandDimension(dfB, cepColName, numThreads), islandDimension(dfC, cepColName, numThreads),
+        cepColName, colB, colC, numThreads);
+}
+
+// Junções à esquerda pelo código da ilha: AB = A + colB, BC = B + colC, AC = A + colC, ABC = A + colB + colC
+map<string, DataFrame> Handler::mergeByCEP(DataFrame& dfA, const TabelaJuncao& dimB, const TabelaJuncao& dimC,
+    const string& cepColName, const string& colB, const string& colC, int numThreads)
+{
+    TRACE_ESCOPO("mergeByCEP", "handler");
+    map<string, DataFrame> results;
+
+    // a chave da ilha entra em A só durante as junções
+    addIslandKey(dfA, cepColName, numThreads);
+
+    try {
+        // AB, ABC e AC numa única sondagem do hospital contra as duas dimensões
+        ConfigJuncaoMultipla config;
+        config.tipo = TipoJuncao::ESQUERDA;
+        config.chavesEsquerda = {ISLAND_KEY};
+        config.colunasEsquerda = withoutIslandKey(dfA);
+        config.dimensoes = {{&dimB, {colB}, "_B"}, {&dimC, {colC}, "_C"}};
+        config.saidas = {{0}, {0, 1}, {1}};
+        vector<DataFrame> saidas = juntarVarias(dfA, config, numThreads);
+        results.insert({"AB", move(saidas[0])});
+        results.insert({"ABC", move(saidas[1])});
+        results.insert({"AC", move(saidas[2])});
+
+        // BC não passa pelo hospital: junção entre as dimensões (pequenas)
+        ConfigJuncao configBC;
+        configBC.tipo = TipoJuncao::ESQUERDA;
+        configBC.chavesEsquerda = {ISLAND_KEY};
+        configBC.colunasEsquerda = withoutIslandKey(dimB.getDados());
+        configBC.colunasDireita = {colC};
+        configBC.sufixo = "_C";
+        results.insert({"BC", juntar(dimB.getDados(), dimC, configBC, numThreads)});
+    } catch (...) {
+        dfA.keepColumns(indicesWithoutIslandKey(dfA), numThreads);
+        throw;
+    }
+
+    dfA.keepColumns(indicesWithoutIslandKey(dfA), numThreads);
     return results;
 }
\ No newline at end of file
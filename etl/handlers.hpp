@@ -11,7 +11,15 @@
 #include <unordered_map>
 #include <utility>
 #include <map>
+#include <memory>
 #include "dataframe.hpp"
+#include "agrupamento.hpp"
+#include "limpeza.hpp"
+#include "validacao.hpp"
+#include "quarentena.hpp"
+#include "juncao.hpp"
+#include "ordenacao.hpp"
+#include "extrator.hpp"
 
 using namespace std;
 
@@ -24,18 +32,55 @@ public:
     // função para agregar duas colunas
     DataFrame groupedDf(const DataFrame& , const string& , const string& , int , bool);
 
-    // Handler para limpeza de dados - remove duplicatas e linhas/colunas com muitos valores nulos
+    // group-by com várias chaves de qualquer tipo e várias agregações numa passada (ver agrupamento.hpp)
+    DataFrame groupBy(const DataFrame&, const vector<string>&, const vector<Agregacao>&, int);
+
+    // Handler para limpeza de dados - remove duplicatas e colunas com muitos valores nulos (limites padrão)
     void dataCleaner(DataFrame&);
 
+    // limpeza numa única varredura com limites configuráveis (ver limpeza.hpp)
+    void dataCleaner(DataFrame&, const ConfigLimpeza&, int);
+
+    // remove linhas repetidas nas colunas-chave (todas quando vazio), mantendo a primeira ocorrência;
+    // exata (hashes iguais são confirmados pelas células) e paralela (ver deduplicacao.hpp)
+    void removeDuplicates(DataFrame&, const vector<string>&, int);
+
     // Função auxiliar para verificar se uma célula é nula
     bool isNullCell(const Cell&);
 
-    // Handler para validar dados
-    void validateDataFrame(DataFrame&, int);
+    // Handler para validar dados (regras inferidas por amostra); com quarentena, as linhas descartadas
+    // vão para ela com o motivo e a coluna
+    void validateDataFrame(DataFrame&, int, Quarentena* = nullptr);
+
+    // valida com as regras declaradas da fonte; sem esquema (nullptr) cai na inferência por amostra
+    void validateDataFrame(DataFrame&, const EsquemaValidacao*, int, Quarentena* = nullptr);
 
-    // Handler para merge de 3 DataFrames por CEP
+    // ordena as linhas pelas colunas (radix para inteiros, merge sort para o resto) e marca o DataFrame como
+    // ordenado, o que faz join e groupBy usarem os caminhos por ordem (ver ordenacao.hpp)
+    void sortBy(DataFrame&, const vector<string>&, int);
+
+    // junção interna, à esquerda, semi ou anti em colunas-chave quaisquer, por hash ou, com as duas entradas
+    // ordenadas pelas chaves, por intercalação (ver juncao.hpp)
+    DataFrame join(const DataFrame&, const DataFrame&, const ConfigJuncao&, int);
+
+    // Handler para merge de 3 DataFrames por CEP (junções à esquerda pelo código da ilha)
     map<string, DataFrame> mergeByCEP(DataFrame&, DataFrame&, DataFrame&, const string&, const string&, const string&, int);
 
+    // dimensão do merge (agregado de OMS ou secretaria) pronta para as junções por ilha; imutável, pode ser
+    // compartilhada por todos os merges de uma execução
+    TabelaJuncao islandDimension(DataFrame, const string&, int);
+
+    // poda por ilha para a extração: aceita o CEP (no tipo da coluna, com a mesma chave de ilha da junção)
+    // cuja ilha talvez esteja em alguma das dimensões, pelo filtro de Bloom delas (sem falsos negativos)
+    PodaExtracao islandPruning(const string&, const vector<shared_ptr<const TabelaJuncao>>&);
+
+    // remove as linhas cuja ilha não está em nenhuma das dimensões, conferindo nas tabelas (tira os falsos
+    // positivos do Bloom); devolve quantas saíram
+    size_t pruneByIslands(DataFrame&, const string&, const vector<shared_ptr<const TabelaJuncao>>&, int);
+
+    // merge contra dimensões já prontas (sem copiar nem reconstruir o lado da construção)
+    map<string, DataFrame> mergeByCEP(DataFrame&, const TabelaJuncao&, const TabelaJuncao&, const string&, const string&, const string&, int);
+
 private:
     // Estrutura para regras de validação
     struct ColumnValidationRules {
@@ -73,22 +118,12 @@ private:
     void agregarGrupoPar(const std::vector<Cell>&, const std::vector<Cell>&,
         const std::vector<Cell>&, mutex&, std::unordered_map<std::string, double>&);
     
-    // Função auxiliar para remover linhas duplicadas
-    void removeDuplicateRows(DataFrame&);
-
-    // Função auxiliar para remover linhas com muitos valores nulos
-    void removeSparseRows(DataFrame&, double);
-
-    // Função auxiliar para remover colunas com muitos valores nulos
-    void removeSparseColumns(DataFrame&, double);
-
     // Métodos auxiliares para validação
     vector<ColumnValidationRules> analyzeColumnsForValidation(const DataFrame&, int);
     void analyzeColumnPattern(const DataFrame&, int, int, ColumnValidationRules&);
-    void validateRows(DataFrame&, const vector<ColumnValidationRules>&, vector<bool>&, int);
-    bool isValidCell(const Cell&, const ColumnValidationRules&);
-    void createValidatedDataFrame(DataFrame&, const vector<bool>&);
-    void filterInvalidAges(DataFrame&, const string&, int, int);
+    ValidadorColuna compileRule(const ColumnValidationRules&, size_t);
+    void createValidatedDataFrame(DataFrame&, const MascaraLinhas&, const vector<ValidadorColuna>&, Quarentena*);
+    void filterInvalidAges(DataFrame&, const string&, int, int, Quarentena* = nullptr);
 
     // Funções auxiliares genéricas
     string toLower(const string&);
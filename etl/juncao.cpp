@@ -0,0 +1,641 @@
+#include "juncao.hpp"
+#include "agrupamento.hpp"
+#include "deduplicacao.hpp"
+#include "executor.hpp"
+#include "trace.hpp"
+#include "tabela_hash.hpp"
+#include "ordenacao.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+#include <cstdint>
+#include <utility>
+
+namespace
+{
+    constexpr size_t NENHUMA = TabelaJuncao::NENHUMA;
+
+    // valor que preenche as colunas da direita numa linha sem par (junção à esquerda)
+    Cell nuloDoTipo(ColumnType tipo)
+    {
+        switch (tipo)
+        {
+            case ColumnType::INTEGER: return 0;
+            case ColumnType::DOUBLE:  return 0.0;
+            case ColumnType::STRING:  return string();
+        }
+        return string();
+    }
+
+    vector<size_t> indicesColunas(const DataFrame& df, const vector<string>& nomes, const string& lado)
+    {
+        vector<size_t> indices;
+        for (const auto& nome : nomes)
+        {
+            const size_t idx = df.colIdx(nome);
+            if (idx == static_cast<size_t>(-1))
+                throw invalid_argument("Coluna da junção não encontrada (" + lado + "): " + nome);
+            indices.push_back(idx);
+        }
+        return indices;
+    }
+
+    // chaves da esquerda pareadas pela posição com as da direita (mesma quantidade e mesmos tipos)
+    vector<size_t> chavesDaEsquerda(const DataFrame& esquerda, const vector<string>& nomes, const DataFrame& direita,
+        const vector<string>& nomesDireita, const vector<size_t>& chavesD)
+    {
+        if (nomes.size() != nomesDireita.size())
+            throw invalid_argument("A junção precisa do mesmo número de colunas-chave nos dois lados.");
+
+        const vector<size_t> chavesE = indicesColunas(esquerda, nomes, "esquerda");
+        for (size_t k = 0; k < chavesE.size(); ++k)
+        {
+            if (esquerda.typeCol(chavesE[k]) != direita.typeCol(chavesD[k]))
+                throw invalid_argument("Colunas-chave de tipos diferentes: " + nomes[k] + " e " + nomesDireita[k]);
+        }
+        return chavesE;
+    }
+
+    vector<size_t> chavesDaEsquerda(const DataFrame& esquerda, const vector<string>& nomes, const TabelaJuncao& tabela)
+    {
+        return chavesDaEsquerda(esquerda, nomes, tabela.getDados(), tabela.getChaves(), tabela.getIdxChaves());
+    }
+
+    vector<size_t> colunasDaEsquerda(const DataFrame& esquerda, const vector<string>& nomes)
+    {
+        vector<size_t> colunas = indicesColunas(esquerda, nomes, "esquerda");
+        if (nomes.empty())
+            for (int c = 0; c < esquerda.numCols(); ++c) colunas.push_back(static_cast<size_t>(c));
+        return colunas;
+    }
+
+    // colunas da direita na saída (vazio = todas menos as chaves)
+    vector<size_t> colunasDaDireita(const DataFrame& direita, const vector<size_t>& chavesD, const vector<string>& nomes)
+    {
+        vector<size_t> colunas = indicesColunas(direita, nomes, "direita");
+        if (nomes.empty())
+            for (int c = 0; c < direita.numCols(); ++c)
+                if (find(chavesD.begin(), chavesD.end(), static_cast<size_t>(c)) == chavesD.end())
+                    colunas.push_back(static_cast<size_t>(c));
+        return colunas;
+    }
+
+    void checarRepetidas(vector<string> nomes)
+    {
+        sort(nomes.begin(), nomes.end());
+        auto repetido = adjacent_find(nomes.begin(), nomes.end());
+        if (repetido != nomes.end())
+            throw invalid_argument("Coluna repetida na saída da junção: " + *repetido);
+    }
+
+    // índices das linhas espalhados pelas partições do hash, [bloco][partição], cada lista em ordem crescente
+    vector<vector<vector<size_t>>> espalhar(const vector<size_t>& hashes, size_t numParticoes, int numThreads)
+    {
+        const size_t numLinhas = hashes.size();
+        const size_t grao = Executor::grao(numLinhas, numThreads);
+        const size_t numBlocos = (numLinhas + grao - 1) / grao;
+
+        vector<vector<vector<size_t>>> espalhadas(numBlocos, vector<vector<size_t>>(numParticoes));
+        Executor::global().parallel_for(0, numLinhas, grao, [&](size_t inicio, size_t fim)
+        {
+            auto& destino = espalhadas[inicio / grao];
+            for (size_t i = inicio; i < fim; ++i) destino[particaoHash(hashes[i], numParticoes)].push_back(i);
+        });
+        return espalhadas;
+    }
+}
+
+TabelaJuncao::TabelaJuncao(DataFrame dados, const vector<string>& chaves, int numThreads, size_t particoes)
+    : TabelaJuncao(make_shared<const DataFrame>(move(dados)), chaves, numThreads, particoes)
+{
+}
+
+TabelaJuncao TabelaJuncao::sobre(const DataFrame& dados, const vector<string>& chaves, int numThreads, size_t particoes)
+{
+    // ponteiro sem dono (construtor de aliasing com dono vazio)
+    return TabelaJuncao(shared_ptr<const DataFrame>(shared_ptr<const DataFrame>(), &dados), chaves, numThreads, particoes);
+}
+
+TabelaJuncao::TabelaJuncao(shared_ptr<const DataFrame> dadosConstrucao, const vector<string>& nomesChaves, int numThreads,
+    size_t particoes)
+    : dados(move(dadosConstrucao)), chaves(nomesChaves)
+{
+    TRACE_ESCOPO("construirJuncao", "handler");
+
+    if (numThreads <= 0)
+        throw invalid_argument("Número de threads deve ser maior que zero.");
+    if (chaves.empty())
+        throw invalid_argument("A junção precisa de ao menos uma coluna-chave.");
+    idxChaves = indicesColunas(*dados, chaves, "direita");
+
+    // hash da chave de cada linha, em paralelo
+    const DataFrame& direita = *dados;
+    const size_t numLinhas = static_cast<size_t>(direita.size());
+    vector<size_t> hashes(numLinhas);
+    Executor::global().parallel_for(0, numLinhas, Executor::grao(numLinhas, numThreads), [&](size_t inicio, size_t fim)
+    {
+        for (size_t j = inicio; j < fim; ++j) hashes[j] = hashChaveLinha(direita.getRow(j), idxChaves);
+    });
+
+    filtro = FiltroBloom(numLinhas);
+    for (size_t h : hashes) filtro.inserir(h);
+
+    // radix só quando as tabelas (slot + controle + encadeamento por linha) passam da L2
+    const size_t numParticoes = particoes ? particoes : max<size_t>(
+        particoesRadix(numLinhas, sizeof(pair<size_t, pair<size_t, size_t>>) + 1 + sizeof(size_t), numThreads), 1);
+    tabelas.resize(numParticoes);
+
+    // linhas de mesmo hash encadeadas na ordem das linhas; cada partição só escreve nas próprias linhas
+    proxima.assign(numLinhas, NENHUMA);
+    auto inserir = [&](TabelaHash<size_t, pair<size_t, size_t>>& tabela, size_t j)
+    {
+        auto [pontas, nova] = tabela.inserir(hashes[j], {j, j});
+        if (nova) return;
+        proxima[pontas->second] = j;
+        pontas->second = j;
+    };
+
+    if (numParticoes == 1)
+    {
+        tabelas[0].reservar(numLinhas);
+        for (size_t j = 0; j < numLinhas; ++j) inserir(tabelas[0], j);
+        return;
+    }
+
+    auto espalhadas = espalhar(hashes, numParticoes, numThreads);
+    Executor::global().parallel_for(0, numParticoes, 1, [&](size_t ini, size_t fim)
+    {
+        for (size_t p = ini; p < fim; ++p)
+        {
+            for (auto& blocos : espalhadas)
+            {
+                for (size_t j : blocos[p]) inserir(tabelas[p], j);
+                vector<size_t>().swap(blocos[p]);
+            }
+        }
+    });
+}
+
+namespace
+{
+    // colunas da saída de uma junção de duas entradas e as chaves pareadas
+    struct PlanoJuncao
+    {
+        TipoJuncao tipo;
+        bool comDireita;                 // interna e à esquerda levam colunas da direita
+        vector<size_t> chavesE, chavesD;
+        vector<size_t> colunasE, colunasD;
+        vector<string> nomes;
+        vector<ColumnType> tipos;
+        vector<Cell> nulosDireita;
+    };
+
+    PlanoJuncao planejar(const DataFrame& esquerda, const DataFrame& direita, const vector<string>& nomesChaveDireita,
+        const vector<size_t>& chavesD, const ConfigJuncao& config, int numThreads)
+    {
+        if (numThreads <= 0)
+            throw invalid_argument("Número de threads deve ser maior que zero.");
+
+        PlanoJuncao plano;
+        plano.tipo = config.tipo;
+        plano.comDireita = config.tipo == TipoJuncao::INTERNA || config.tipo == TipoJuncao::ESQUERDA;
+        plano.chavesE = chavesDaEsquerda(esquerda, config.chavesEsquerda, direita, nomesChaveDireita, chavesD);
+        plano.chavesD = chavesD;
+
+        // colunas da saída: as da esquerda e, nas junções interna e à esquerda, as da direita com o sufixo
+        plano.colunasE = colunasDaEsquerda(esquerda, config.colunasEsquerda);
+        if (plano.comDireita) plano.colunasD = colunasDaDireita(direita, chavesD, config.colunasDireita);
+
+        for (size_t c : plano.colunasE)
+        {
+            plano.nomes.push_back(esquerda.getColumnNames()[c]);
+            plano.tipos.push_back(esquerda.typeCol(c));
+        }
+        for (size_t c : plano.colunasD)
+        {
+            plano.nomes.push_back(direita.getColumnNames()[c] + config.sufixo);
+            plano.tipos.push_back(direita.typeCol(c));
+            plano.nulosDireita.push_back(nuloDoTipo(direita.typeCol(c)));
+        }
+        checarRepetidas(plano.nomes);
+        return plano;
+    }
+
+    // Monta a saída a partir da sondagem: achados[i] = pares da linha i da esquerda e, por tarefa, os pares
+    // (linha da esquerda, linha da direita), os de uma mesma linha juntos e na ordem da direita
+    DataFrame materializar(const DataFrame& esquerda, const DataFrame& direita, const PlanoJuncao& plano,
+        const vector<uint32_t>& achados, vector<vector<pair<size_t, size_t>>>& paresPorTarefa, int numThreads)
+    {
+        const size_t numE = static_cast<size_t>(esquerda.size());
+
+        // ---- posição de cada linha da esquerda na saída ----
+        vector<size_t> inicioSaida(numE + 1, 0);
+        for (size_t i = 0; i < numE; ++i)
+        {
+            size_t linhas = 0;
+            switch (plano.tipo)
+            {
+                case TipoJuncao::INTERNA:  linhas = achados[i]; break;
+                case TipoJuncao::ESQUERDA: linhas = max<size_t>(achados[i], 1); break;
+                case TipoJuncao::SEMI:     linhas = achados[i] > 0; break;
+                case TipoJuncao::ANTI:     linhas = achados[i] == 0; break;
+            }
+            inicioSaida[i + 1] = inicioSaida[i] + linhas;
+        }
+        const size_t numSaida = inicioSaida[numE];
+
+        // linha da direita de cada linha da saída (NENHUMA = sem par), espalhada pelas tarefas em paralelo
+        vector<size_t> direitaDaSaida;
+        if (plano.comDireita)
+        {
+            direitaDaSaida.resize(numSaida);
+            Executor::global().parallel_for(0, paresPorTarefa.size(), 1, [&](size_t ini, size_t fim)
+            {
+                for (size_t t = ini; t < fim; ++t)
+                {
+                    size_t anterior = NENHUMA, posicao = 0;
+                    for (const auto& [i, j] : paresPorTarefa[t])
+                    {
+                        posicao = i == anterior ? posicao + 1 : inicioSaida[i];
+                        anterior = i;
+                        direitaDaSaida[posicao] = j;
+                    }
+                    vector<pair<size_t, size_t>>().swap(paresPorTarefa[t]);
+                }
+            });
+        }
+
+        // ---- materialização em paralelo, na ordem da esquerda ----
+        vector<vector<Cell>> linhas(numSaida);
+        Executor::global().parallel_for(0, numE, Executor::grao(numE, numThreads * 8), [&](size_t inicio, size_t fim)
+        {
+            for (size_t i = inicio; i < fim; ++i)
+            {
+                const vector<Cell>& linhaE = esquerda.getRow(i);
+                for (size_t k = inicioSaida[i]; k < inicioSaida[i + 1]; ++k)
+                {
+                    vector<Cell>& linha = linhas[k];
+                    linha.reserve(plano.nomes.size());
+                    for (size_t c : plano.colunasE) linha.push_back(linhaE[c]);
+                    if (!plano.comDireita) continue;
+
+                    const size_t j = direitaDaSaida[k];
+                    if (j == NENHUMA) linha.insert(linha.end(), plano.nulosDireita.begin(), plano.nulosDireita.end());
+                    else for (size_t c : plano.colunasD) linha.push_back(direita.getRow(j)[c]);
+                }
+            }
+        });
+
+        DataFrame saida(plano.nomes, plano.tipos);
+        saida.addRows(move(linhas));
+
+        // a saída segue a ordem da esquerda (e, numa mesma linha, a da direita)
+        vector<string> ordem;
+        for (const string& coluna : esquerda.getSortedBy())
+        {
+            const size_t idx = esquerda.colIdx(coluna);
+            if (find(plano.colunasE.begin(), plano.colunasE.end(), idx) == plano.colunasE.end()) break;
+            ordem.push_back(coluna);
+        }
+        saida.setSortedBy(ordem);
+        return saida;
+    }
+
+    // Sort-merge join: as duas entradas já ordenadas pelas chaves. Cada morsel da esquerda acha por busca
+    // binária onde sua primeira chave começa na direita e avança os dois lados juntos, sem tabela hash
+    DataFrame juntarOrdenados(const DataFrame& esquerda, const DataFrame& direita, const ConfigJuncao& config,
+        const vector<string>& chavesDireita, int numThreads)
+    {
+        TRACE_ESCOPO("juntarOrdenados", "handler");
+
+        const PlanoJuncao plano = planejar(esquerda, direita, chavesDireita,
+            indicesColunas(direita, chavesDireita, "direita"), config, numThreads);
+        const vector<size_t>& chavesE = plano.chavesE;
+        const vector<size_t>& chavesD = plano.chavesD;
+
+        const size_t numE = static_cast<size_t>(esquerda.size());
+        const size_t numD = static_cast<size_t>(direita.size());
+        vector<uint32_t> achados(numE, 0);
+
+        const size_t morsel = Executor::grao(numE, numThreads * 8);
+        vector<vector<pair<size_t, size_t>>> paresPorTarefa((numE + morsel - 1) / morsel);
+        Executor::global().parallel_for(0, numE, morsel, [&](size_t inicio, size_t fim)
+        {
+            auto& pares = paresPorTarefa[inicio / morsel];
+            auto comparar = [&](size_t i, size_t j)
+            {
+                return compararChaves(esquerda.getRow(i), chavesE, direita.getRow(j), chavesD);
+            };
+
+            // primeira linha da direita com chave >= a da primeira linha do morsel
+            size_t j = 0, fimBusca = numD;
+            while (j < fimBusca)
+            {
+                const size_t meio = j + (fimBusca - j) / 2;
+                if (comparar(inicio, meio) > 0) j = meio + 1;
+                else fimBusca = meio;
+            }
+
+            // [j, fimTrecho) = linhas da direita com a chave da linha atual; chave repetida na esquerda reaproveita
+            // o trecho, chave nova (maior) começa depois dele
+            size_t fimTrecho = j;
+            for (size_t i = inicio; i < fim; ++i)
+            {
+                if (i == inicio || compararChaves(esquerda.getRow(i), chavesE, esquerda.getRow(i - 1), chavesE) != 0)
+                {
+                    j = fimTrecho;
+                    while (j < numD && comparar(i, j) > 0) ++j;
+                    fimTrecho = j;
+                    while (fimTrecho < numD && comparar(i, fimTrecho) == 0) ++fimTrecho;
+                }
+
+                achados[i] = static_cast<uint32_t>(fimTrecho - j);
+                if (plano.comDireita)
+                    for (size_t k = j; k < fimTrecho; ++k) pares.push_back({i, k});
+                if (achados[i] == 0 && plano.tipo == TipoJuncao::ESQUERDA) pares.push_back({i, NENHUMA});
+            }
+        });
+
+        return materializar(esquerda, direita, plano, achados, paresPorTarefa, numThreads);
+    }
+}
+
+bool TabelaJuncao::contem(const vector<Cell>& linha, const vector<size_t>& chavesLinha, size_t h) const
+{
+    if (!filtro.talvezContem(h)) return false;
+    for (size_t j = primeiraLinha(h); j != NENHUMA; j = proximaLinha(j))
+        if (compararChaves(linha, chavesLinha, dados->getRow(j), idxChaves) == 0) return true;
+    return false;
+}
+
+DataFrame juntar(const DataFrame& esquerda, const DataFrame& direita, const ConfigJuncao& config, int numThreads)
+{
+    const vector<string>& chavesDireita = config.chavesDireita.empty() ? config.chavesEsquerda : config.chavesDireita;
+
+    // as duas entradas já ordenadas pelas chaves: intercala em vez de construir a tabela hash
+    if (config.particoes == 0 && ordenadoPor(esquerda, config.chavesEsquerda) && ordenadoPor(direita, chavesDireita))
+        return juntarOrdenados(esquerda, direita, config, chavesDireita, numThreads);
+
+    return juntar(esquerda, TabelaJuncao::sobre(direita, chavesDireita, numThreads, config.particoes), config, numThreads);
+}
+
+DataFrame juntar(const DataFrame& esquerda, const TabelaJuncao& tabela, const ConfigJuncao& config, int numThreads)
+{
+    TRACE_ESCOPO("juntar", "handler");
+
+    if (!config.chavesDireita.empty() && config.chavesDireita != tabela.getChaves())
+        throw invalid_argument("As colunas-chave da direita não são as da tabela de junção.");
+    const DataFrame& direita = tabela.getDados();
+    const PlanoJuncao plano = planejar(esquerda, direita, tabela.getChaves(), tabela.getIdxChaves(), config, numThreads);
+    const vector<size_t>& chavesE = plano.chavesE;
+    const vector<size_t>& chavesD = plano.chavesD;
+    const TipoJuncao tipo = plano.tipo;
+    const bool comDireita = plano.comDireita;
+
+    const size_t numE = static_cast<size_t>(esquerda.size());
+
+    // ---- sondagem: pares (linha da esquerda, linha da direita) de cada tarefa ----
+    // pares de uma mesma linha da esquerda ficam juntos na lista da tarefa que a sondou
+    vector<uint32_t> achados(numE, 0);
+    auto mesmaChave = [&](const vector<Cell>& linhaE, const vector<Cell>& linhaD)
+    {
+        for (size_t k = 0; k < chavesE.size(); ++k)
+            if (!(linhaE[chavesE[k]] == linhaD[chavesD[k]])) return false;
+        return true;
+    };
+    auto sondar = [&](size_t i, size_t h, vector<pair<size_t, size_t>>& pares)
+    {
+        uint32_t encontrados = 0;
+        size_t j = tabela.primeiraLinha(h);
+        if (j != NENHUMA)
+        {
+            const vector<Cell>& linhaE = esquerda.getRow(i);
+            for (; j != NENHUMA; j = tabela.proximaLinha(j))
+            {
+                if (!mesmaChave(linhaE, direita.getRow(j))) continue;
+                ++encontrados;
+                if (!comDireita) break;   // semi/anti só precisam saber se há par
+                pares.push_back({i, j});
+            }
+        }
+        if (encontrados == 0 && tipo == TipoJuncao::ESQUERDA) pares.push_back({i, NENHUMA});
+        achados[i] = encontrados;
+    };
+
+    vector<vector<pair<size_t, size_t>>> paresPorTarefa;
+    const size_t numParticoes = tabela.numParticoes();
+    if (numParticoes == 1)
+    {
+        // morsels: bem mais blocos que threads, para o roubo de tarefas equilibrar chaves desiguais
+        const size_t morsel = Executor::grao(numE, numThreads * 8);
+        paresPorTarefa.resize((numE + morsel - 1) / morsel);
+        Executor::global().parallel_for(0, numE, morsel, [&](size_t inicio, size_t fim)
+        {
+            auto& pares = paresPorTarefa[inicio / morsel];
+            for (size_t i = inicio; i < fim; ++i)
+                sondar(i, hashChaveLinha(esquerda.getRow(i), chavesE), pares);
+        });
+    }
+    else
+    {
+        vector<size_t> hashesE(numE);
+        Executor::global().parallel_for(0, numE, Executor::grao(numE, numThreads * 8), [&](size_t inicio, size_t fim)
+        {
+            for (size_t i = inicio; i < fim; ++i) hashesE[i] = hashChaveLinha(esquerda.getRow(i), chavesE);
+        });
+
+        // cada partição da esquerda é sondada só contra a tabela da mesma partição
+        auto espalhadasE = espalhar(hashesE, numParticoes, numThreads);
+        paresPorTarefa.resize(numParticoes);
+        Executor::global().parallel_for(0, numParticoes, 1, [&](size_t ini, size_t fim)
+        {
+            for (size_t p = ini; p < fim; ++p)
+            {
+                for (auto& blocos : espalhadasE)
+                {
+                    for (size_t i : blocos[p]) sondar(i, hashesE[i], paresPorTarefa[p]);
+                    vector<size_t>().swap(blocos[p]);
+                }
+            }
+        });
+    }
+
+    return materializar(esquerda, direita, plano, achados, paresPorTarefa, numThreads);
+}
+
+vector<DataFrame> juntarVarias(const DataFrame& esquerda, const ConfigJuncaoMultipla& config, int numThreads)
+{
+    TRACE_ESCOPO("juntarVarias", "handler");
+
+    if (numThreads <= 0)
+        throw invalid_argument("Número de threads deve ser maior que zero.");
+    if (config.tipo != TipoJuncao::INTERNA && config.tipo != TipoJuncao::ESQUERDA)
+        throw invalid_argument("A junção múltipla só aceita junção interna ou à esquerda.");
+    if (config.dimensoes.empty())
+        throw invalid_argument("A junção múltipla precisa de ao menos uma dimensão.");
+
+    // as chaves da esquerda são as mesmas para todas as dimensões, então o hash de cada linha também
+    const size_t numDims = config.dimensoes.size();
+    vector<size_t> chavesE;
+    vector<vector<size_t>> colunasD(numDims);
+    for (size_t d = 0; d < numDims; ++d)
+    {
+        const TabelaJuncao* tabela = config.dimensoes[d].tabela;
+        if (!tabela)
+            throw invalid_argument("Dimensão da junção sem tabela.");
+        chavesE = chavesDaEsquerda(esquerda, config.chavesEsquerda, *tabela);
+        colunasD[d] = colunasDaDireita(tabela->getDados(), tabela->getIdxChaves(), config.dimensoes[d].colunas);
+    }
+    const vector<size_t> colunasE = colunasDaEsquerda(esquerda, config.colunasEsquerda);
+
+    // colunas de cada saída: as da esquerda e as das dimensões da saída, cada uma com seu sufixo
+    const size_t numSaidas = config.saidas.size();
+    vector<vector<string>> nomes(numSaidas);
+    vector<vector<ColumnType>> tipos(numSaidas);
+    for (size_t s = 0; s < numSaidas; ++s)
+    {
+        for (size_t c : colunasE)
+        {
+            nomes[s].push_back(esquerda.getColumnNames()[c]);
+            tipos[s].push_back(esquerda.typeCol(c));
+        }
+        for (size_t d : config.saidas[s])
+        {
+            if (d >= numDims)
+                throw invalid_argument("Saída da junção com dimensão inexistente: " + to_string(d));
+            const DataFrame& direita = config.dimensoes[d].tabela->getDados();
+            for (size_t c : colunasD[d])
+            {
+                nomes[s].push_back(direita.getColumnNames()[c] + config.dimensoes[d].sufixo);
+                tipos[s].push_back(direita.typeCol(c));
+            }
+        }
+        checarRepetidas(nomes[s]);
+    }
+
+    vector<vector<Cell>> nulosDimensao(numDims);
+    for (size_t d = 0; d < numDims; ++d)
+        for (size_t c : colunasD[d]) nulosDimensao[d].push_back(nuloDoTipo(config.dimensoes[d].tabela->getDados().typeCol(c)));
+
+    const size_t numE = static_cast<size_t>(esquerda.size());
+
+    // ---- sondagem: uma passada pela esquerda, todas as dimensões por linha ----
+    // cada morsel guarda, por dimensão, as linhas da direita achadas na ordem das suas linhas da esquerda
+    vector<vector<uint32_t>> achados(numDims, vector<uint32_t>(numE, 0));
+    const size_t morsel = Executor::grao(numE, numThreads * 8);
+    vector<vector<vector<size_t>>> paresPorTarefa((numE + morsel - 1) / morsel, vector<vector<size_t>>(numDims));
+    Executor::global().parallel_for(0, numE, morsel, [&](size_t inicio, size_t fim)
+    {
+        auto& pares = paresPorTarefa[inicio / morsel];
+        for (size_t i = inicio; i < fim; ++i)
+        {
+            const vector<Cell>& linhaE = esquerda.getRow(i);
+            const size_t h = hashChaveLinha(linhaE, chavesE);
+            for (size_t d = 0; d < numDims; ++d)
+            {
+                const TabelaJuncao& tabela = *config.dimensoes[d].tabela;
+                const vector<size_t>& chavesD = tabela.getIdxChaves();
+                uint32_t encontrados = 0;
+                for (size_t j = tabela.primeiraLinha(h); j != NENHUMA; j = tabela.proximaLinha(j))
+                {
+                    const vector<Cell>& linhaD = tabela.getDados().getRow(j);
+                    bool mesma = true;
+                    for (size_t k = 0; k < chavesE.size() && mesma; ++k) mesma = linhaE[chavesE[k]] == linhaD[chavesD[k]];
+                    if (!mesma) continue;
+                    ++encontrados;
+                    pares[d].push_back(j);
+                }
+                achados[d][i] = encontrados;
+            }
+        }
+    });
+
+    // pares de cada dimensão contíguos por linha da esquerda (os morsels já estão na ordem das linhas)
+    vector<vector<size_t>> inicioPares(numDims, vector<size_t>(numE + 1, 0));
+    vector<vector<size_t>> paresDimensao(numDims);
+    for (size_t d = 0; d < numDims; ++d)
+    {
+        for (size_t i = 0; i < numE; ++i) inicioPares[d][i + 1] = inicioPares[d][i] + achados[d][i];
+        paresDimensao[d].resize(inicioPares[d][numE]);
+    }
+    Executor::global().parallel_for(0, paresPorTarefa.size(), 1, [&](size_t ini, size_t fim)
+    {
+        for (size_t t = ini; t < fim; ++t)
+        {
+            for (size_t d = 0; d < numDims; ++d)
+            {
+                copy(paresPorTarefa[t][d].begin(), paresPorTarefa[t][d].end(),
+                    paresDimensao[d].begin() + inicioPares[d][t * morsel]);
+                vector<size_t>().swap(paresPorTarefa[t][d]);
+            }
+        }
+    });
+
+    // ---- posição de cada linha da esquerda em cada saída: produto das linhas de cada dimensão ----
+    const bool aEsquerda = config.tipo == TipoJuncao::ESQUERDA;
+    auto linhasDimensao = [&](size_t d, size_t i) -> size_t { return aEsquerda ? max<uint32_t>(achados[d][i], 1) : achados[d][i]; };
+
+    vector<vector<size_t>> inicioSaida(numSaidas, vector<size_t>(numE + 1, 0));
+    vector<vector<vector<Cell>>> linhas(numSaidas);
+    for (size_t s = 0; s < numSaidas; ++s)
+    {
+        for (size_t i = 0; i < numE; ++i)
+        {
+            size_t produto = 1;
+            for (size_t d : config.saidas[s]) produto *= linhasDimensao(d, i);
+            inicioSaida[s][i + 1] = inicioSaida[s][i] + produto;
+        }
+        linhas[s].resize(inicioSaida[s][numE]);
+    }
+
+    // ---- materialização de todas as saídas numa passada, na ordem da esquerda ----
+    // numa saída {b, c} as linhas de c variam mais rápido, como na junção encadeada
+    Executor::global().parallel_for(0, numE, morsel, [&](size_t inicio, size_t fim)
+    {
+        vector<size_t> digitos;
+        for (size_t i = inicio; i < fim; ++i)
+        {
+            const vector<Cell>& linhaE = esquerda.getRow(i);
+            for (size_t s = 0; s < numSaidas; ++s)
+            {
+                const vector<size_t>& dims = config.saidas[s];
+                digitos.assign(dims.size(), 0);
+                for (size_t k = inicioSaida[s][i]; k < inicioSaida[s][i + 1]; ++k)
+                {
+                    vector<Cell>& linha = linhas[s][k];
+                    linha.reserve(nomes[s].size());
+                    for (size_t c : colunasE) linha.push_back(linhaE[c]);
+                    for (size_t p = 0; p < dims.size(); ++p)
+                    {
+                        const size_t d = dims[p];
+                        if (achados[d][i] == 0)
+                        {
+                            linha.insert(linha.end(), nulosDimensao[d].begin(), nulosDimensao[d].end());
+                            continue;
+                        }
+                        const vector<Cell>& linhaD = config.dimensoes[d].tabela->getDados().getRow(
+                            paresDimensao[d][inicioPares[d][i] + digitos[p]]);
+                        for (size_t c : colunasD[d]) linha.push_back(linhaD[c]);
+                    }
+
+                    // próxima combinação (a última dimensão é a de dentro)
+                    for (size_t p = dims.size(); p-- > 0;)
+                    {
+                        if (++digitos[p] < linhasDimensao(dims[p], i)) break;
+                        digitos[p] = 0;
+                    }
+                }
+            }
+        }
+    });
+
+    vector<DataFrame> saidas;
+    saidas.reserve(numSaidas);
+    for (size_t s = 0; s < numSaidas; ++s)
+    {
+        DataFrame saida(nomes[s], tipos[s]);
+        saida.addRows(move(linhas[s]));
+        saidas.push_back(move(saida));
+    }
+    return saidas;
+}
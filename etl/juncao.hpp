@@ -0,0 +1,122 @@
+#ifndef JUNCAO_HPP
+#define JUNCAO_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <memory>
+#include <limits>
+#include <utility>
+#include "dataframe.hpp"
+#include "tabela_hash.hpp"
+#include "agrupamento.hpp"
+#include "filtro_bloom.hpp"
+
+using namespace std;
+
+// Junção por hash. O lado da direita (construção, em geral a dimensão) tem o hash da chave calculado em
+// paralelo e vira tabelas hash com as linhas de mesmo hash encadeadas; o da esquerda (sondagem) é
+// percorrido em blocos pequenos (morsels) distribuídos pelo pool, que roubam trabalho entre si. As chaves
+// podem ter várias colunas e são comparadas pelo valor tipado das células.
+//
+// Quando as tabelas da construção passam da L2 os dois lados são particionados por radix (bits altos do
+// hash): cada partição da direita é construída e sondada por uma única tarefa, com a tabela no cache.
+// A saída mantém a ordem das linhas da esquerda e, para uma mesma linha, a ordem das da direita.
+//
+// O lado da construção pode ser montado uma vez (TabelaJuncao) e reaproveitado: depois de pronta a tabela
+// só é lida, então vale como "dimensão difundida", compartilhada sem locks por todas as sondagens.
+// Ela também traz um filtro de Bloom das chaves, que pode ser levado para antes da junção (até a extração)
+// para descartar cedo as linhas que não teriam par.
+
+enum class TipoJuncao { INTERNA, ESQUERDA, SEMI, ANTI };
+
+struct ConfigJuncao
+{
+    TipoJuncao tipo = TipoJuncao::INTERNA;
+    vector<string> chavesEsquerda;
+    vector<string> chavesDireita;      // vazio = mesmos nomes da esquerda
+    vector<string> colunasEsquerda;    // colunas da esquerda na saída (vazio = todas)
+    vector<string> colunasDireita;     // colunas da direita na saída (vazio = todas menos as chaves)
+    string sufixo;                     // acrescentado ao nome das colunas da direita na saída
+    size_t particoes = 0;              // 0 = automático (radix só quando a construção passa da L2)
+};
+
+// Lado da construção pronto e imutável: os dados, as colunas-chave e as tabelas hash (hash da chave ->
+// primeira linha com esse hash, com as seguintes encadeadas na ordem das linhas)
+class TabelaJuncao
+{
+public:
+    static constexpr size_t NENHUMA = numeric_limits<size_t>::max();
+
+    // constrói sobre os dados (movidos para a tabela); particoes = 0 escolhe sozinho (radix só quando as
+    // tabelas passam da L2). Lança invalid_argument para chave inexistente ou numThreads <= 0
+    TabelaJuncao(DataFrame dados, const vector<string>& chaves, int numThreads, size_t particoes = 0);
+
+    // sem copiar: os dados continuam de quem chama e precisam durar mais que a tabela
+    static TabelaJuncao sobre(const DataFrame& dados, const vector<string>& chaves, int numThreads, size_t particoes = 0);
+
+    const DataFrame& getDados() const { return *dados; }
+    const vector<string>& getChaves() const { return chaves; }
+    const vector<size_t>& getIdxChaves() const { return idxChaves; }
+    size_t numParticoes() const { return tabelas.size(); }
+
+    // partição do hash (bits altos, como na agregação por radix)
+    size_t particao(size_t h) const { return tabelas.size() == 1 ? 0 : particaoHash(h, tabelas.size()); }
+
+    // primeira linha com o hash (NENHUMA se não houver) e a seguinte com o mesmo hash
+    size_t primeiraLinha(size_t h) const
+    {
+        const auto* pontas = tabelas[particao(h)].encontrar(h);
+        return pontas ? pontas->first : NENHUMA;
+    }
+    size_t proximaLinha(size_t j) const { return proxima[j]; }
+
+    // filtro de Bloom dos hashes das chaves (mesmo hash de hashChaveLinha sobre as colunas-chave)
+    const FiltroBloom& getFiltro() const { return filtro; }
+
+    // se alguma linha tem exatamente a chave das colunas chavesLinha de `linha` (mesmos tipos das chaves)
+    bool contem(const vector<Cell>& linha, const vector<size_t>& chavesLinha, size_t h) const;
+
+private:
+    TabelaJuncao(shared_ptr<const DataFrame> dados, const vector<string>& chaves, int numThreads, size_t particoes);
+
+    shared_ptr<const DataFrame> dados;
+    vector<string> chaves;
+    vector<size_t> idxChaves;
+    vector<size_t> proxima;
+    vector<TabelaHash<size_t, pair<size_t, size_t>>> tabelas;   // por partição: hash -> (primeira, última) linha
+    FiltroBloom filtro;
+};
+
+// Junta esquerda e direita. ESQUERDA preenche as linhas sem par com o nulo do tipo de cada coluna (0, 0.0
+// ou ""); SEMI e ANTI devolvem só as colunas da esquerda, uma vez por linha. Lança invalid_argument para
+// coluna inexistente, chaves de quantidades ou tipos diferentes, nome repetido na saída ou numThreads <= 0.
+DataFrame juntar(const DataFrame& esquerda, const DataFrame& direita, const ConfigJuncao& config, int numThreads);
+
+// mesma junção contra um lado da construção já pronto (chavesDireita, se dadas, devem ser as da tabela;
+// config.particoes não se aplica)
+DataFrame juntar(const DataFrame& esquerda, const TabelaJuncao& direita, const ConfigJuncao& config, int numThreads);
+
+// Junção de várias dimensões numa passada: cada linha da esquerda tem o hash da chave calculado uma vez e é
+// sondada em todas as tabelas; as saídas pedidas (combinações de dimensões) saem dos mesmos pares, sem varrer
+// a esquerda de novo. Uma saída com as dimensões {b, c} é igual a juntar a esquerda com b e o resultado com c.
+struct DimensaoJuncao
+{
+    const TabelaJuncao* tabela = nullptr;
+    vector<string> colunas;            // colunas da dimensão na saída (vazio = todas menos as chaves)
+    string sufixo;
+};
+
+struct ConfigJuncaoMultipla
+{
+    TipoJuncao tipo = TipoJuncao::ESQUERDA;   // só INTERNA ou ESQUERDA
+    vector<string> chavesEsquerda;            // pareadas com as chaves de todas as dimensões
+    vector<string> colunasEsquerda;           // vazio = todas
+    vector<DimensaoJuncao> dimensoes;
+    vector<vector<size_t>> saidas;            // dimensões de cada saída, na ordem das colunas (índices em dimensoes)
+};
+
+// uma saída por elemento de config.saidas, na mesma ordem; lança invalid_argument como juntar
+vector<DataFrame> juntarVarias(const DataFrame& esquerda, const ConfigJuncaoMultipla& config, int numThreads);
+
+#endif // JUNCAO_HPP
@@ -0,0 +1,108 @@
+#include "limpeza.hpp"
+#include "deduplicacao.hpp"
+#include "executor.hpp"
+#include "trace.hpp"
+#include <stdexcept>
+#include <cstdint>
+
+bool celulaNulaLimpeza(const Cell& celula)
+{
+    if (holds_alternative<string>(celula)) return get<string>(celula).empty();
+    if (holds_alternative<int>(celula)) return get<int>(celula) == 0;
+    return get<double>(celula) == 0.0;
+}
+
+ResultadoLimpeza limparDataFrame(DataFrame& input, const ConfigLimpeza& config, int numThreads)
+{
+    TRACE_ESCOPO("limparDataFrame", "handler");
+
+    if (numThreads <= 0)
+        throw invalid_argument("Número de threads deve ser maior que zero.");
+
+    ResultadoLimpeza resultado;
+    const size_t numLinhas = static_cast<size_t>(input.size());
+    const size_t numColunas = static_cast<size_t>(input.numCols());
+    const double maxNulosLinha = config.limiteNulosLinha * static_cast<double>(numColunas);
+
+    // varredura única: marca as células nulas de cada linha e descarta as linhas esparsas
+    vector<uint8_t> nulas(numLinhas * numColunas, 0);
+    auto marcarNulas = [&](size_t i, const vector<Cell>& linha)
+    {
+        uint8_t* marcas = nulas.data() + i * numColunas;
+        size_t nulosLinha = 0;
+        for (size_t c = 0; c < numColunas && c < linha.size(); ++c)
+        {
+            marcas[c] = celulaNulaLimpeza(linha[c]);
+            nulosLinha += marcas[c];
+        }
+        return static_cast<double>(nulosLinha) <= maxNulosLinha;
+    };
+
+    vector<char> manter;
+    if (config.removerDuplicatas)
+    {
+        manter = marcarUnicas(input, colunasDeduplicacao(input, config.colunasChave), numThreads, marcarNulas);
+    }
+    else
+    {
+        manter.assign(numLinhas, 0);
+        Executor::global().parallel_for(0, numLinhas, Executor::grao(numLinhas, numThreads), [&](size_t inicio, size_t fim)
+        {
+            for (size_t i = inicio; i < fim; ++i) manter[i] = marcarNulas(i, input.getRow(i));
+        });
+    }
+
+    // linhas que ficam (as outras são esparsas ou duplicatas)
+    vector<size_t> linhas;
+    linhas.reserve(numLinhas);
+    for (size_t i = 0; i < numLinhas; ++i)
+    {
+        if (manter[i]) linhas.push_back(i);
+    }
+
+    // nulos por coluna só nas linhas que ficam, somando as marcas (sem voltar às células)
+    const size_t grao = Executor::grao(linhas.size(), numThreads);
+    vector<size_t> nulosColuna = Executor::global().parallel_reduce(
+        0, linhas.size(), grao, vector<size_t>(numColunas, 0),
+        [&](size_t inicio, size_t fim)
+        {
+            vector<size_t> parcial(numColunas, 0);
+            for (size_t k = inicio; k < fim; ++k)
+            {
+                const uint8_t* marcas = nulas.data() + linhas[k] * numColunas;
+                for (size_t c = 0; c < numColunas; ++c) parcial[c] += marcas[c];
+            }
+            return parcial;
+        },
+        [&](vector<size_t> total, const vector<size_t>& parcial)
+        {
+            for (size_t c = 0; c < numColunas; ++c) total[c] += parcial[c];
+            return total;
+        });
+
+    const size_t maxNulosColuna = static_cast<size_t>(linhas.size() * config.limiteNulosColuna);
+    vector<size_t> colunas;
+    for (size_t c = 0; c < numColunas; ++c)
+    {
+        if (nulosColuna[c] < maxNulosColuna) colunas.push_back(c);
+    }
+
+    // contagem das linhas esparsas: descartadas pelo filtro da varredura (não entraram na deduplicação)
+    if (config.limiteNulosLinha < 1.0)
+    {
+        for (size_t i = 0; i < numLinhas; ++i)
+        {
+            if (manter[i]) continue;
+            size_t nulosLinha = 0;
+            for (size_t c = 0; c < numColunas; ++c) nulosLinha += nulas[i * numColunas + c];
+            resultado.linhasEsparsas += static_cast<double>(nulosLinha) > maxNulosLinha;
+        }
+    }
+    resultado.duplicatas = numLinhas - linhas.size() - resultado.linhasEsparsas;
+    resultado.colunasRemovidas = numColunas - colunas.size();
+
+    // materialização única: linhas movidas para a frente, depois as colunas compactadas no lugar
+    input.keepRows(linhas);
+    input.keepColumns(colunas, numThreads);
+    return resultado;
+}
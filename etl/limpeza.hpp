@@ -0,0 +1,36 @@
+#ifndef LIMPEZA_HPP
+#define LIMPEZA_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "dataframe.hpp"
+
+using namespace std;
+
+// Limpeza fundida: uma única varredura paralela calcula, por linha, o hash da deduplicação e quais células
+// são nulas (um byte por célula); a deduplicação, os nulos por linha e por coluna saem dessas marcas, e as
+// linhas e colunas que sobrevivem são materializadas uma vez, movendo as células no lugar.
+
+struct ConfigLimpeza
+{
+    bool removerDuplicatas = true;
+    vector<string> colunasChave;       // colunas da deduplicação; vazio = linha inteira
+    double limiteNulosColuna = 0.9;    // coluna sai quando nulos >= limite * linhas restantes
+    double limiteNulosLinha = 1.0;     // linha sai quando nulos > limite * colunas (1.0 = nunca)
+};
+
+struct ResultadoLimpeza
+{
+    size_t duplicatas = 0;
+    size_t linhasEsparsas = 0;
+    size_t colunasRemovidas = 0;
+};
+
+// célula nula para a limpeza: string vazia, inteiro 0 ou double 0.0
+bool celulaNulaLimpeza(const Cell& celula);
+
+// limpa input no lugar; lança invalid_argument para colunas-chave inexistentes ou numThreads <= 0
+ResultadoLimpeza limparDataFrame(DataFrame& input, const ConfigLimpeza& config, int numThreads);
+
+#endif // LIMPEZA_HPP
@@ -5,21 +5,24 @@
 #include <sstream>
 #include <variant>
 
-void save_as_csv(const DataFrame& df, const std::string& filename) {
-    std::ofstream out(filename);
+void save_as_csv(const DataFrame& df, const std::string& filename, bool acrescentar) {
+    std::ofstream out(filename, acrescentar ? std::ios::app : std::ios::trunc);
     if (!out.is_open()) {
         throw std::runtime_error("Não foi possível abrir o arquivo: " + filename);
     }
 
     const auto& nomesColunas = df.getColumnNames();
 
-    // Escreve os nomes das colunas
-    for (size_t i = 0; i < nomesColunas.size(); ++i) {
-        out << nomesColunas[i];
-        if (i < nomesColunas.size() - 1)
-            out << ",";
+    // Escreve os nomes das colunas (uma vez só quando acrescenta)
+    out.seekp(0, std::ios::end);
+    if (out.tellp() == 0) {
+        for (size_t i = 0; i < nomesColunas.size(); ++i) {
+            out << nomesColunas[i];
+            if (i < nomesColunas.size() - 1)
+                out << ",";
+        }
+        out << "\n";
     }
-    out << "\n";
 
     // Escreve os dados
     for (int i = 0; i < df.size(); ++i) {
@@ -4,14 +4,16 @@
 #include "dataframe.hpp"
 #include <string>
 
-// Função para salvar um DataFrame como arquivo CSV
-void save_as_csv(const DataFrame& df, const std::string& filename);
+// Função para salvar um DataFrame como arquivo CSV; com acrescentar, grava no fim de um arquivo
+// existente (o cabeçalho só sai se o arquivo ainda estiver vazio)
+void save_as_csv(const DataFrame& df, const std::string& filename, bool acrescentar = false);
 
 // Struct usada no pipeline para comunicação entre handler (produtor) e loader (consumidor)
 struct LoaderItem {
     DataFrame df;
     std::string nomeArquivoOriginal;
     int threadId;
+    bool acrescentar = false;   // quarentena: várias entregas da mesma fonte no mesmo arquivo
 };
 
 #endif // LOADER_HPP
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "ordenacao.hpp"
+#include "executor.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <numeric>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    constexpr size_t BITS_DIGITO = 8;
+    constexpr size_t NUM_DIGITOS = size_t(1) << BITS_DIGITO;
+
+    struct ChaveLinha
+    {
+        uint32_t chave;
+        size_t linha;
+    };
+
+    // inteiro com sinal como sem sinal na mesma ordem (bit de sinal invertido)
+    inline uint32_t chaveRadix(const Cell& celula)
+    {
+        return static_cast<uint32_t>(get<int>(celula)) ^ 0x80000000u;
+    }
+
+    // radix LSD estável sobre `ordem`, uma coluna inteira de cada vez, da última chave para a primeira
+    void ordenarRadix(const DataFrame& df, const vector<size_t>& idxColunas, vector<size_t>& ordem, int numThreads)
+    {
+        const size_t n = ordem.size();
+        const size_t grao = Executor::grao(n, numThreads);
+        const size_t numBlocos = (n + grao - 1) / grao;
+
+        vector<ChaveLinha> atual(n), destino(n);
+        vector<array<size_t, NUM_DIGITOS>> posicoes(numBlocos);
+
+        for (size_t k = idxColunas.size(); k-- > 0;)
+        {
+            const size_t coluna = idxColunas[k];
+            Executor::global().parallel_for(0, n, grao, [&](size_t inicio, size_t fim)
+            {
+                for (size_t i = inicio; i < fim; ++i) atual[i] = {chaveRadix(df.getRow(ordem[i])[coluna]), ordem[i]};
+            });
+
+            for (size_t deslocamento = 0; deslocamento < 32; deslocamento += BITS_DIGITO)
+            {
+                auto digito = [deslocamento](uint32_t chave) { return (chave >> deslocamento) & (NUM_DIGITOS - 1); };
+
+                // histograma de cada bloco
+                Executor::global().parallel_for(0, n, grao, [&](size_t inicio, size_t fim)
+                {
+                    auto& contagem = posicoes[inicio / grao];
+                    contagem.fill(0);
+                    for (size_t i = inicio; i < fim; ++i) ++contagem[digito(atual[i].chave)];
+                });
+
+                // todas as chaves com o mesmo dígito: a passada não muda nada
+                size_t total = 0;
+                bool unico = false;
+                for (size_t d = 0; d < NUM_DIGITOS && !unico; ++d)
+                {
+                    size_t doDigito = 0;
+                    for (size_t b = 0; b < numBlocos; ++b) doDigito += posicoes[b][d];
+                    unico = doDigito == n;
+                }
+                if (unico) continue;
+
+                // início de cada (dígito, bloco): dígitos em ordem e, num dígito, blocos em ordem (estável)
+                for (size_t d = 0; d < NUM_DIGITOS; ++d)
+                {
+                    for (size_t b = 0; b < numBlocos; ++b)
+                    {
+                        const size_t contagem = posicoes[b][d];
+                        posicoes[b][d] = total;
+                        total += contagem;
+                    }
+                }
+
+                Executor::global().parallel_for(0, n, grao, [&](size_t inicio, size_t fim)
+                {
+                    auto& proxima = posicoes[inicio / grao];
+                    for (size_t i = inicio; i < fim; ++i) destino[proxima[digito(atual[i].chave)]++] = atual[i];
+                });
+                atual.swap(destino);
+            }
+
+            for (size_t i = 0; i < n; ++i) ordem[i] = atual[i].linha;
+        }
+    }
+
+    // merge sort estável: blocos ordenados em paralelo, depois intercalados aos pares até sobrar um
+    void ordenarIntercalando(const DataFrame& df, const vector<size_t>& idxColunas, vector<size_t>& ordem, int numThreads)
+    {
+        const size_t n = ordem.size();
+        auto menor = [&](size_t a, size_t b)
+        {
+            return compararChaves(df.getRow(a), idxColunas, df.getRow(b), idxColunas) < 0;
+        };
+
+        const size_t grao = Executor::grao(n, numThreads);
+        Executor::global().parallel_for(0, n, grao, [&](size_t inicio, size_t fim)
+        {
+            stable_sort(ordem.begin() + inicio, ordem.begin() + fim, menor);
+        });
+
+        vector<size_t> destino(n);
+        for (size_t largura = grao; largura < n; largura *= 2)
+        {
+            const size_t numPares = (n + 2 * largura - 1) / (2 * largura);
+            Executor::global().parallel_for(0, numPares, 1, [&](size_t ini, size_t fim)
+            {
+                for (size_t p = ini; p < fim; ++p)
+                {
+                    const size_t inicio = p * 2 * largura;
+                    const size_t meio = min(inicio + largura, n);
+                    const size_t final = min(inicio + 2 * largura, n);
+                    // std::merge tira da primeira metade nos empates: mantém a ordem da entrada
+                    merge(ordem.begin() + inicio, ordem.begin() + meio, ordem.begin() + meio, ordem.begin() + final,
+                        destino.begin() + inicio, menor);
+                }
+            });
+            ordem.swap(destino);
+        }
+    }
+}
+
+int compararChaves(const vector<Cell>& a, const vector<size_t>& chavesA, const vector<Cell>& b, const vector<size_t>& chavesB)
+{
+    for (size_t k = 0; k < chavesA.size(); ++k)
+    {
+        const Cell& x = a[chavesA[k]];
+        const Cell& y = b[chavesB[k]];
+        if (x < y) return -1;
+        if (y < x) return 1;
+    }
+    return 0;
+}
+
+vector<size_t> ordemDasLinhas(const DataFrame& df, const vector<string>& colunas, int numThreads)
+{
+    TRACE_ESCOPO("ordemDasLinhas", "handler");
+
+    if (numThreads <= 0)
+        throw invalid_argument("Número de threads deve ser maior que zero.");
+
+    vector<size_t> idxColunas;
+    bool soInteiros = true;
+    for (const auto& nome : colunas)
+    {
+        const size_t idx = df.colIdx(nome);
+        if (idx == static_cast<size_t>(-1))
+            throw invalid_argument("Coluna de ordenação não encontrada no DataFrame: " + nome);
+        idxColunas.push_back(idx);
+        soInteiros &= df.typeCol(idx) == ColumnType::INTEGER;
+    }
+
+    vector<size_t> ordem(static_cast<size_t>(df.size()));
+    iota(ordem.begin(), ordem.end(), size_t(0));
+    if (ordem.size() < 2 || idxColunas.empty()) return ordem;
+
+    if (soInteiros) ordenarRadix(df, idxColunas, ordem, numThreads);
+    else ordenarIntercalando(df, idxColunas, ordem, numThreads);
+    return ordem;
+}
+
+void ordenarPor(DataFrame& df, const vector<string>& colunas, int numThreads)
+{
+    if (ordenadoPor(df, colunas)) return;
+
+    df.reorderRows(ordemDasLinhas(df, colunas, numThreads));
+    df.setSortedBy(colunas);
+}
+
+bool ordenadoPor(const DataFrame& df, const vector<string>& colunas)
+{
+    const vector<string>& ordem = df.getSortedBy();
+    return !colunas.empty() && colunas.size() <= ordem.size() && equal(colunas.begin(), colunas.end(), ordem.begin());
+}
+
+bool agrupadoPor(const DataFrame& df, const vector<string>& colunas)
+{
+    const vector<string>& ordem = df.getSortedBy();
+    if (colunas.empty() || colunas.size() > ordem.size()) return false;
+    return is_permutation(colunas.begin(), colunas.end(), ordem.begin());
+}
@@ -0,0 +1,36 @@
+#ifndef ORDENACAO_HPP
+#define ORDENACAO_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "dataframe.hpp"
+
+using namespace std;
+
+// Ordenação paralela das linhas de um DataFrame por uma lista de colunas, crescente e estável (linhas de
+// chaves iguais mantêm a ordem da entrada). Chaves só de colunas inteiras vão por radix LSD: 8 bits por
+// passada, histogramas por bloco e espalhamento em paralelo, pulando as passadas em que todas as chaves têm o
+// mesmo dígito. As demais (texto, double) por merge sort: blocos ordenados em paralelo e intercalados aos
+// pares, uma rodada por vez.
+//
+// O DataFrame ordenado fica marcado (getSortedBy); junção e group-by trocam a tabela hash pela intercalação
+// das entradas (sort-merge join) e pela agregação por trechos quando elas já chegam ordenadas pelas chaves.
+
+// permutação que ordena as linhas: a i-ésima linha em ordem é a ordem[i] da entrada. Lança invalid_argument
+// para coluna inexistente ou numThreads <= 0
+vector<size_t> ordemDasLinhas(const DataFrame& df, const vector<string>& colunas, int numThreads);
+
+// ordena as linhas no lugar e marca o DataFrame como ordenado pelas colunas
+void ordenarPor(DataFrame& df, const vector<string>& colunas, int numThreads);
+
+// se o DataFrame está marcado como ordenado com `colunas` no início da ordem, nessa sequência
+bool ordenadoPor(const DataFrame& df, const vector<string>& colunas);
+
+// se linhas de mesmas `colunas` estão juntas: o começo da ordem tem exatamente essas colunas, em qualquer sequência
+bool agrupadoPor(const DataFrame& df, const vector<string>& colunas);
+
+// compara as chaves de duas linhas (colunas pareadas pela posição) na ordem das células: < 0, 0 ou > 0
+int compararChaves(const vector<Cell>& a, const vector<size_t>& chavesA, const vector<Cell>& b, const vector<size_t>& chavesB);
+
+#endif // ORDENACAO_HPP
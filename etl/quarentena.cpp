@@ -0,0 +1,94 @@
+#include "quarentena.hpp"
+#include "limpeza.hpp"
+#include <utility>
+
+const char* codigoMotivo(MotivoRejeicao motivo)
+{
+    switch (motivo)
+    {
+        case MotivoRejeicao::TAMANHO: return "TAMANHO";
+        case MotivoRejeicao::TIPO:    return "TIPO";
+        case MotivoRejeicao::FAIXA:   return "FAIXA";
+        case MotivoRejeicao::DIGITOS: return "DIGITOS";
+        case MotivoRejeicao::VALOR:   return "VALOR";
+    }
+    return "?";
+}
+
+MotivoRejeicao motivoReprovacao(const ValidadorColuna& v, const Cell& celula)
+{
+    // célula não nula de outro tipo (a ordem de ColumnType é a das alternativas de Cell): tipo errado,
+    // exceto quando a checagem também avalia o outro tipo (dígitos e conjunto comparam o texto)
+    const bool outroTipo = celula.index() != static_cast<size_t>(v.tipoColuna) && !celulaNulaLimpeza(celula);
+    if (outroTipo && (v.exigeTipo || v.tipo == TipoValidador::FAIXA || v.tipo == TipoValidador::ACEITA_TUDO))
+        return MotivoRejeicao::TIPO;
+
+    switch (v.tipo)
+    {
+        case TipoValidador::DIGITOS:  return MotivoRejeicao::DIGITOS;
+        case TipoValidador::CONJUNTO: return MotivoRejeicao::VALOR;
+        case TipoValidador::FAIXA:    return MotivoRejeicao::FAIXA;
+        default:                      return MotivoRejeicao::TIPO;
+    }
+}
+
+string linhaEmTexto(const vector<Cell>& linha)
+{
+    string texto;
+    for (size_t i = 0; i < linha.size(); ++i)
+    {
+        if (i) texto += '|';
+        texto += toString(linha[i]);
+    }
+    return texto;
+}
+
+string linhaEmTexto(const vector<string>& valores)
+{
+    string texto;
+    for (size_t i = 0; i < valores.size(); ++i)
+    {
+        if (i) texto += '|';
+        texto += valores[i];
+    }
+    return texto;
+}
+
+void Quarentena::registrar(MotivoRejeicao motivo, const string& coluna, string linha)
+{
+    linhas.push_back({string(codigoMotivo(motivo)), coluna, move(linha)});
+    ++porMotivo[static_cast<size_t>(motivo)];
+}
+
+void Quarentena::registrar(MotivoRejeicao motivo, const string& coluna, const vector<Cell>& linha)
+{
+    registrar(motivo, coluna, linhaEmTexto(linha));
+}
+
+void Quarentena::acumular(Quarentena&& outra)
+{
+    if (linhas.empty()) linhas = move(outra.linhas);
+    else for (auto& linha : outra.linhas) linhas.push_back(move(linha));
+    for (size_t m = 0; m < NUM_MOTIVOS; ++m) porMotivo[m] += outra.porMotivo[m];
+
+    outra.linhas.clear();
+    outra.porMotivo = {};
+}
+
+map<string, uint64_t> Quarentena::contagens() const
+{
+    map<string, uint64_t> contagem;
+    for (size_t m = 0; m < NUM_MOTIVOS; ++m)
+        if (porMotivo[m]) contagem[codigoMotivo(static_cast<MotivoRejeicao>(m))] = porMotivo[m];
+    return contagem;
+}
+
+DataFrame Quarentena::retirar()
+{
+    DataFrame df({"motivo", "coluna", "linha"}, {ColumnType::STRING, ColumnType::STRING, ColumnType::STRING});
+    for (const auto& linha : linhas) df.addRow(linha);
+
+    linhas.clear();
+    porMotivo = {};
+    return df;
+}
@@ -0,0 +1,58 @@
+#ifndef QUARENTENA_HPP
+#define QUARENTENA_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include "dataframe.hpp"
+#include "validacao.hpp"
+
+using namespace std;
+
+// Quarentena: as linhas descartadas pela extração (tamanho/tipo) e pela validação não somem, vão para uma
+// saída por fonte com o motivo, a coluna que reprovou e a linha original (células separadas por '|'). A
+// validação continua marcando só a máscara no caminho quente; apenas as linhas reprovadas são reavaliadas
+// para achar o motivo.
+
+enum class MotivoRejeicao : uint8_t { TAMANHO, TIPO, FAIXA, DIGITOS, VALOR };
+
+// código curto gravado na quarentena e nas métricas ("TAMANHO", "TIPO", "FAIXA", "DIGITOS", "VALOR")
+const char* codigoMotivo(MotivoRejeicao motivo);
+
+// motivo pelo qual a célula reprova no validador (tipo errado ou a checagem do validador)
+MotivoRejeicao motivoReprovacao(const ValidadorColuna& v, const Cell& celula);
+
+class Quarentena
+{
+public:
+    static constexpr size_t NUM_MOTIVOS = 5;
+
+    // linha já em texto (ex.: a linha crua do CSV) ou em células
+    void registrar(MotivoRejeicao motivo, const string& coluna, string linha);
+    void registrar(MotivoRejeicao motivo, const string& coluna, const vector<Cell>& linha);
+
+    // move as linhas de outra quarentena para o fim desta
+    void acumular(Quarentena&& outra);
+
+    bool empty() const { return linhas.empty(); }
+    size_t size() const { return linhas.size(); }
+
+    // linhas por código de motivo (só motivos com alguma linha)
+    map<string, uint64_t> contagens() const;
+
+    // esvazia a quarentena num DataFrame com as colunas motivo, coluna e linha
+    DataFrame retirar();
+
+private:
+    vector<vector<Cell>> linhas;
+    array<uint64_t, NUM_MOTIVOS> porMotivo = {};
+};
+
+// células de uma linha em texto, separadas por '|' (a linha vai inteira numa coluna do CSV)
+string linhaEmTexto(const vector<Cell>& linha);
+string linhaEmTexto(const vector<string>& valores);
+
+#endif // QUARENTENA_HPP
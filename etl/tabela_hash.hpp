@@ -0,0 +1,209 @@
+#ifndef TABELA_HASH_HPP
+#define TABELA_HASH_HPP
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// Tabela hash plana com endereçamento aberto (estilo "swiss table"): chaves e valores ficam num
+// vetor contíguo e um byte de controle por slot guarda 7 bits do hash (a "tag") ou VAZIO. A busca
+// olha 16 tags de uma vez (uma comparação SSE2, ou um laço escalar sem SSE2) e só compara a chave
+// nos slots cuja tag bate; grupos cheios seguem para o grupo seguinte (sondagem linear por grupo).
+// Sem nós alocados nem ponteiros para seguir: feita para agregações, deduplicação e joins, que só
+// inserem e consultam. Não há remoção de chaves individuais (só limpar()).
+
+// mistura final do murmur3: espalha bits de hashes fracos (o hash padrão de inteiros é a identidade)
+inline size_t misturarHash(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+}
+
+// hash padrão da tabela: a tag usa os bits altos e o grupo os baixos, então todos precisam variar
+template <typename K, typename = void>
+struct HashRapido
+{
+    size_t operator()(const K& chave) const { return misturarHash(hash<K>()(chave)); }
+};
+
+// inteiros: uma multiplicação (Fibonacci) e um xor bastam, e custam bem menos que a mistura completa
+template <typename K>
+struct HashRapido<K, enable_if_t<is_integral_v<K>>>
+{
+    size_t operator()(K chave) const
+    {
+        uint64_t h = static_cast<uint64_t>(chave) * 0x9e3779b97f4a7c15ULL;
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+};
+
+template <typename K, typename V, typename Hash = HashRapido<K>, typename Igual = equal_to<K>>
+class TabelaHash
+{
+public:
+    static constexpr size_t LARGURA_GRUPO = 16;
+
+    TabelaHash() = default;
+    explicit TabelaHash(size_t capacidadeInicial) { reservar(capacidadeInicial); }
+
+    size_t size() const { return numItens; }
+    bool empty() const { return numItens == 0; }
+
+    // garante espaço para n chaves sem crescer
+    void reservar(size_t n)
+    {
+        size_t slots = LARGURA_GRUPO;
+        while (slots * 7 / 8 < n) slots *= 2;
+        if (slots > controle.size()) realocar(slots);
+    }
+
+    // ponteiro para o valor da chave (nullptr se não existir)
+    V* encontrar(const K& chave)
+    {
+        if (numItens == 0) return nullptr;
+        const size_t h = hasher(chave);
+        size_t indice;
+        return procurar(chave, h, indice) ? &slots[indice].second : nullptr;
+    }
+
+    const V* encontrar(const K& chave) const { return const_cast<TabelaHash*>(this)->encontrar(chave); }
+
+    bool contem(const K& chave) const { return encontrar(chave) != nullptr; }
+
+    // insere (chave, valor) se a chave não existir; devolve o valor guardado e se inseriu
+    pair<V*, bool> inserir(const K& chave, V valor = V())
+    {
+        if (numItens + 1 > controle.size() * 7 / 8) realocar(max(LARGURA_GRUPO, controle.size() * 2));
+
+        const size_t h = hasher(chave);
+        size_t indice;
+        if (procurar(chave, h, indice)) return {&slots[indice].second, false};
+
+        indice = slotLivre(h);
+        controle[indice] = tag(h);
+        slots[indice].first = chave;
+        slots[indice].second = move(valor);
+        ++numItens;
+        return {&slots[indice].second, true};
+    }
+
+    V& operator[](const K& chave) { return *inserir(chave).first; }
+
+    // visita (chave, valor) de todos os itens (ordem das posições na tabela)
+    template <typename F>
+    void paraCada(F&& f)
+    {
+        for (size_t i = 0; i < controle.size(); ++i)
+            if (controle[i] != VAZIO) f(slots[i].first, slots[i].second);
+    }
+
+    template <typename F>
+    void paraCada(F&& f) const
+    {
+        for (size_t i = 0; i < controle.size(); ++i)
+            if (controle[i] != VAZIO) f(slots[i].first, slots[i].second);
+    }
+
+    // esvazia mantendo a capacidade
+    void limpar()
+    {
+        fill(controle.begin(), controle.end(), VAZIO);
+        for (auto& slot : slots) slot = pair<K, V>();
+        numItens = 0;
+    }
+
+private:
+    static constexpr int8_t VAZIO = -128;
+
+    // 7 bits altos do hash (nunca negativos, então nunca iguais a VAZIO)
+    static int8_t tag(size_t h) { return static_cast<int8_t>(h >> (sizeof(size_t) * 8 - 7)); }
+
+    // bit i ligado quando o byte i do grupo vale `valor`
+    uint32_t casar(size_t grupo, int8_t valor) const
+    {
+        const int8_t* ctrl = controle.data() + grupo * LARGURA_GRUPO;
+#ifdef __SSE2__
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(valor))));
+#else
+        uint32_t mascara = 0;
+        for (size_t i = 0; i < LARGURA_GRUPO; ++i)
+            mascara |= static_cast<uint32_t>(ctrl[i] == valor) << i;
+        return mascara;
+#endif
+    }
+
+    size_t numGrupos() const { return controle.size() / LARGURA_GRUPO; }
+
+    bool procurar(const K& chave, size_t h, size_t& indice) const
+    {
+        if (controle.empty()) return false;
+
+        const size_t mascaraGrupos = numGrupos() - 1;
+        const int8_t t = tag(h);
+        for (size_t grupo = h & mascaraGrupos, passos = 0; passos < numGrupos(); grupo = (grupo + 1) & mascaraGrupos, ++passos)
+        {
+            for (uint32_t m = casar(grupo, t); m; m &= m - 1)
+            {
+                const size_t i = grupo * LARGURA_GRUPO + __builtin_ctz(m);
+                if (igual(slots[i].first, chave))
+                {
+                    indice = i;
+                    return true;
+                }
+            }
+            // um slot vazio no grupo encerra a sondagem: a chave teria sido posta nele
+            if (casar(grupo, VAZIO)) return false;
+        }
+        return false;
+    }
+
+    size_t slotLivre(size_t h) const
+    {
+        const size_t mascaraGrupos = numGrupos() - 1;
+        for (size_t grupo = h & mascaraGrupos;; grupo = (grupo + 1) & mascaraGrupos)
+        {
+            uint32_t vazios = casar(grupo, VAZIO);
+            if (vazios) return grupo * LARGURA_GRUPO + __builtin_ctz(vazios);
+        }
+    }
+
+    void realocar(size_t novosSlots)
+    {
+        vector<int8_t> controleAntigo(novosSlots, VAZIO);
+        vector<pair<K, V>> slotsAntigos(novosSlots);
+        controle.swap(controleAntigo);
+        slots.swap(slotsAntigos);
+
+        for (size_t i = 0; i < controleAntigo.size(); ++i)
+        {
+            if (controleAntigo[i] == VAZIO) continue;
+            const size_t h = hasher(slotsAntigos[i].first);
+            const size_t destino = slotLivre(h);
+            controle[destino] = tag(h);
+            slots[destino] = move(slotsAntigos[i]);
+        }
+    }
+
+    vector<int8_t> controle;     // tag ou VAZIO por slot; tamanho potência de 2, múltiplo de 16
+    vector<pair<K, V>> slots;
+    size_t numItens = 0;
+    Hash hasher;
+    Igual igual;
+};
+
+#endif // TABELA_HASH_HPP
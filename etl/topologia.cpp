@@ -0,0 +1,156 @@
+#include "topologia.hpp"
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <sched.h>
+
+// lê uma linha de um arquivo do sysfs ("" se não existir)
+static string lerLinha(const string& caminho)
+{
+    ifstream arquivo(caminho);
+    string linha;
+    if (arquivo.is_open()) getline(arquivo, linha);
+    return linha;
+}
+
+// lista de CPUs no formato do kernel: "0-3,8,10-11"
+static vector<int> lerListaCpus(const string& texto)
+{
+    vector<int> cpus;
+    stringstream entrada(texto);
+    string faixa;
+    while (getline(entrada, faixa, ','))
+    {
+        if (faixa.empty()) continue;
+        try {
+            size_t traco = faixa.find('-');
+            int ini = stoi(faixa.substr(0, traco));
+            int fim = traco == string::npos ? ini : stoi(faixa.substr(traco + 1));
+            for (int c = ini; c <= fim; ++c) cpus.push_back(c);
+        } catch (const exception&) {
+            // faixa malformada: ignora
+        }
+    }
+    return cpus;
+}
+
+// CPUs em que o processo pode rodar
+static vector<int> cpusPermitidas()
+{
+    vector<int> cpus;
+    cpu_set_t conjunto;
+    CPU_ZERO(&conjunto);
+    if (sched_getaffinity(0, sizeof(conjunto), &conjunto) == 0)
+    {
+        for (int c = 0; c < CPU_SETSIZE; ++c)
+            if (CPU_ISSET(c, &conjunto)) cpus.push_back(c);
+    }
+    if (cpus.empty()) cpus.push_back(0);
+    return cpus;
+}
+
+const Topologia& Topologia::sistema()
+{
+    static Topologia topologia;
+    return topologia;
+}
+
+Topologia::Topologia(const string& raiz)
+{
+    const vector<int> permitidas = cpusPermitidas();
+    const set<int> conjuntoPermitido(permitidas.begin(), permitidas.end());
+    socketPorCpu.assign(permitidas.back() + 1, -1);
+
+    // domínio de cada CPU identificado pela lista de CPUs que dividem a L3 (ou pelo socket)
+    map<pair<int, vector<int>>, vector<int>> porDominio;
+    for (int cpu : permitidas)
+    {
+        const string base = raiz + "/cpu" + to_string(cpu);
+
+        string pacote = lerLinha(base + "/topology/physical_package_id");
+        int socket = 0;
+        try {
+            socket = pacote.empty() ? 0 : max(stoi(pacote), 0);
+        } catch (const exception&) {}
+
+        string compartilhada;
+        for (int indice = 0; indice < 8 && compartilhada.empty(); ++indice)
+        {
+            const string cache = base + "/cache/index" + to_string(indice);
+            if (lerLinha(cache + "/level") == "3")
+                compartilhada = lerLinha(cache + "/shared_cpu_list");
+        }
+
+        // só as CPUs permitidas contam (a L3 pode ser dividida com CPUs fora do cpuset)
+        vector<int> vizinhas;
+        for (int c : lerListaCpus(compartilhada))
+            if (conjuntoPermitido.count(c)) vizinhas.push_back(c);
+
+        porDominio[{socket, vizinhas}].push_back(cpu);
+        socketPorCpu[cpu] = socket;
+    }
+
+    // renumera os sockets em 0..n-1 (ids do kernel podem pular)
+    map<int, int> indiceSocket;
+    for (const auto& [chave, cpus] : porDominio)
+        indiceSocket.emplace(chave.first, static_cast<int>(indiceSocket.size()));
+
+    sockets.assign(indiceSocket.size(), {});
+    for (const auto& [chave, cpus] : porDominio)
+    {
+        const int socket = indiceSocket[chave.first];
+        sockets[socket].push_back(static_cast<int>(dominios.size()));
+        dominios.push_back({cpus, socket});
+    }
+    for (int cpu : permitidas) socketPorCpu[cpu] = indiceSocket[socketPorCpu[cpu]];
+    totalCpus = static_cast<int>(permitidas.size());
+
+    // L2 da primeira CPU permitida ("1024K", "2M")
+    for (int indice = 0; indice < 8; ++indice)
+    {
+        const string cache = raiz + "/cpu" + to_string(permitidas.front()) + "/cache/index" + to_string(indice);
+        if (lerLinha(cache + "/level") != "2") continue;
+
+        const string tamanho = lerLinha(cache + "/size");
+        try {
+            size_t valor = stoul(tamanho);
+            if (tamanho.back() == 'K') valor <<= 10;
+            else if (tamanho.back() == 'M') valor <<= 20;
+            if (valor > 0) cacheL2 = valor;
+        } catch (const exception&) {}
+        break;
+    }
+}
+
+int Topologia::socketAtual() const
+{
+    const int cpu = sched_getcpu();
+    if (cpu < 0 || cpu >= static_cast<int>(socketPorCpu.size())) return 0;
+    return max(socketPorCpu[cpu], 0);
+}
+
+int Topologia::dominioWorker(int estagio, int id) const
+{
+    const int socket = (max(id, 1) - 1) % numSockets();
+    const vector<int>& doSocket = sockets[socket];
+    return doSocket[max(estagio, 0) % doSocket.size()];
+}
+
+string Topologia::descrever() const
+{
+    return to_string(numSockets()) + " socket(s), " + to_string(numDominios()) + " domínio(s) L3, " +
+        to_string(numCpus()) + " CPU(s)";
+}
+
+bool Topologia::fixarThreadAtual(const vector<int>& cpus)
+{
+    if (cpus.empty()) return false;
+
+    cpu_set_t conjunto;
+    CPU_ZERO(&conjunto);
+    for (int c : cpus)
+        if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &conjunto);
+    return sched_setaffinity(0, sizeof(conjunto), &conjunto) == 0;
+}
@@ -0,0 +1,63 @@
+#ifndef TOPOLOGIA_HPP
+#define TOPOLOGIA_HPP
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Topologia de CPUs lida de /sys/devices/system/cpu: sockets e domínios de cache L3 (núcleos que
+// compartilham a mesma L3). Só entram as CPUs que o processo pode usar (sched_getaffinity), então
+// em containers a topologia é a do cgroup/cpuset. Sem /sys legível, ou sem L3 informada, cai para
+// um domínio por socket e, em último caso, um único domínio com todas as CPUs permitidas.
+class Topologia
+{
+public:
+    // topologia da máquina, lida uma vez
+    static const Topologia& sistema();
+
+    explicit Topologia(const string& raiz = "/sys/devices/system/cpu");
+
+    int numSockets() const { return static_cast<int>(sockets.size()); }
+    int numDominios() const { return static_cast<int>(dominios.size()); }
+    int numCpus() const { return totalCpus; }
+
+    // CPUs de um domínio L3 e domínios de um socket
+    const vector<int>& cpusDominio(int dominio) const { return dominios[dominio].cpus; }
+    const vector<int>& dominiosSocket(int socket) const { return sockets[socket]; }
+    int socketDominio(int dominio) const { return dominios[dominio].socket; }
+
+    // tamanho da cache L2 de um núcleo em bytes (1 MiB se o sysfs não informar)
+    size_t bytesCacheL2() const { return cacheL2; }
+
+    // socket em que a thread atual está rodando agora (0 se não der para saber)
+    int socketAtual() const;
+
+    // com um único domínio L3 fixar threads não muda nada (ex.: container de um socket)
+    bool valeFixar() const { return numDominios() > 1; }
+
+    // domínio para o worker `id` (1..n) do estágio de índice `estagio`: workers se alternam entre os
+    // sockets e, dentro de um socket, todos os workers do mesmo estágio ficam no mesmo domínio L3
+    int dominioWorker(int estagio, int id) const;
+
+    // resumo legível ("2 sockets, 4 domínios L3, 32 CPUs")
+    string descrever() const;
+
+    // restringe a thread atual às CPUs dadas (sched_setaffinity); false se o kernel recusar
+    static bool fixarThreadAtual(const vector<int>& cpus);
+
+private:
+    struct Dominio
+    {
+        vector<int> cpus;
+        int socket;
+    };
+
+    vector<Dominio> dominios;
+    vector<vector<int>> sockets;     // índices dos domínios de cada socket
+    vector<int> socketPorCpu;        // indexado pela CPU (-1 = fora do conjunto permitido)
+    int totalCpus = 0;
+    size_t cacheL2 = 1 << 20;
+};
+
+#endif // TOPOLOGIA_HPP
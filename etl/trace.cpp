@@ -0,0 +1,180 @@
+#include "trace.hpp"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <limits>
+#include <set>
+
+namespace Trace
+{
+    struct Evento
+    {
+        const char* nome;
+        const char* categoria;
+        int64_t inicio;
+        int64_t fim;
+    };
+
+    // anel de eventos de uma thread: só a dona escreve
+    struct BufferThread
+    {
+        vector<Evento> eventos;
+        atomic<uint64_t> escritos{0};
+        uint64_t geracao = 0;
+        string nome;
+        int tid = 0;
+    };
+
+    // buffers vivem até o fim do processo (threads podem terminar antes do salvar)
+    static mutex registroMtx;
+    static vector<unique_ptr<BufferThread>> buffers;
+
+    static atomic<bool> gravando{false};
+    static atomic<uint64_t> geracaoAtual{0};
+    static atomic<size_t> capacidade{1 << 16};
+
+    static thread_local BufferThread* bufferLocal = nullptr;
+
+    static BufferThread& bufferDaThread()
+    {
+        if (!bufferLocal)
+        {
+            auto novo = make_unique<BufferThread>();
+            lock_guard<mutex> lock(registroMtx);
+            novo->tid = static_cast<int>(buffers.size()) + 1;
+            novo->nome = "thread-" + to_string(novo->tid);
+            bufferLocal = novo.get();
+            buffers.push_back(move(novo));
+        }
+        return *bufferLocal;
+    }
+
+    int64_t agoraNs()
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void ativar(size_t eventosPorThread)
+    {
+        capacidade = max<size_t>(eventosPorThread, 1);
+        // cada thread descarta o próprio anel ao ver a nova geração (sem mexer no anel dos outros)
+        geracaoAtual.fetch_add(1, memory_order_acq_rel);
+        gravando.store(true, memory_order_release);
+    }
+
+    void desativar()
+    {
+        gravando.store(false, memory_order_release);
+    }
+
+    bool ativo()
+    {
+        return gravando.load(memory_order_relaxed);
+    }
+
+    void nomearThread(const string& nome)
+    {
+        bufferDaThread().nome = nome;
+    }
+
+    const char* internar(const string& nome)
+    {
+        static mutex internadosMtx;
+        static set<string> internados;
+
+        lock_guard<mutex> lock(internadosMtx);
+        return internados.insert(nome).first->c_str();
+    }
+
+    void registrar(const char* nome, const char* categoria, int64_t inicioNs, int64_t fimNs)
+    {
+        if (!ativo()) return;
+
+        BufferThread& buffer = bufferDaThread();
+        const uint64_t geracao = geracaoAtual.load(memory_order_acquire);
+        if (buffer.geracao != geracao)
+        {
+            buffer.eventos.assign(capacidade.load(memory_order_relaxed), Evento{nullptr, nullptr, 0, 0});
+            buffer.escritos.store(0, memory_order_relaxed);
+            buffer.geracao = geracao;
+        }
+
+        const uint64_t i = buffer.escritos.load(memory_order_relaxed);
+        buffer.eventos[i % buffer.eventos.size()] = Evento{nome, categoria, inicioNs, fimNs};
+        buffer.escritos.store(i + 1, memory_order_release);
+    }
+
+    // escapa aspas e barras do nome da thread
+    static string escapar(const string& texto)
+    {
+        string saida;
+        for (char c : texto)
+        {
+            if (c == '"' || c == '\\') saida += '\\';
+            saida += c;
+        }
+        return saida;
+    }
+
+    void salvar(const string& caminho)
+    {
+        ofstream out(caminho);
+        if (!out.is_open())
+            throw runtime_error("Não foi possível abrir o arquivo de trace: " + caminho);
+
+        lock_guard<mutex> lock(registroMtx);
+        const uint64_t geracao = geracaoAtual.load(memory_order_acquire);
+
+        // eventos válidos de cada anel (os mais antigos podem ter sido sobrescritos)
+        auto intervalo = [](const BufferThread& b, uint64_t& ini, uint64_t& fim) {
+            fim = b.escritos.load(memory_order_acquire);
+            ini = fim > b.eventos.size() ? fim - b.eventos.size() : 0;
+        };
+
+        // origem da linha do tempo: o evento mais antigo
+        int64_t origem = numeric_limits<int64_t>::max();
+        for (const auto& b : buffers)
+        {
+            if (b->geracao != geracao) continue;
+            uint64_t ini, fim;
+            intervalo(*b, ini, fim);
+            for (uint64_t i = ini; i < fim; ++i)
+                origem = min(origem, b->eventos[i % b->eventos.size()].inicio);
+        }
+
+        out << "{\"traceEvents\":[\n";
+        bool primeiro = true;
+        auto separar = [&] {
+            if (!primeiro) out << ",\n";
+            primeiro = false;
+        };
+
+        out.setf(ios::fixed);
+        out.precision(3);
+        for (const auto& b : buffers)
+        {
+            separar();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid
+                << ",\"args\":{\"name\":\"" << escapar(b->nome) << "\"}}";
+
+            if (b->geracao != geracao) continue;
+            uint64_t ini, fim;
+            intervalo(*b, ini, fim);
+            for (uint64_t i = ini; i < fim; ++i)
+            {
+                const Evento& e = b->eventos[i % b->eventos.size()];
+                separar();
+                out << "{\"name\":\"" << e.nome << "\",\"cat\":\"" << e.categoria
+                    << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+                    << ",\"ts\":" << (e.inicio - origem) / 1000.0
+                    << ",\"dur\":" << (e.fim - e.inicio) / 1000.0 << "}";
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+// Linha do tempo da execução no formato trace_event do Chrome (abre no Perfetto / chrome://tracing).
+// Cada thread grava eventos "X" (início + duração) num anel próprio, sem locks; o anel sobrescreve os
+// eventos mais antigos quando enche. Só existe com -DETL_TRACE (make TRACE=1): sem a flag as macros
+// abaixo somem e a instrumentação não custa nada. Com a flag, cada evento custa duas leituras do relógio
+// e uma escrita no anel, e nada é gravado enquanto Trace::ativar() não for chamado.
+//
+//   TRACE_ESCOPO("tratar", "estagio");          // evento do início ao fim do bloco
+//   TRACE_NOMEAR_THREAD("extracao-" + to_string(id));
+//
+// Os nomes e categorias precisam ser literais (o anel guarda só o ponteiro).
+
+namespace Trace
+{
+    // começa a gravar eventos (descarta os de uma execução anterior)
+    void ativar(size_t eventosPorThread = 1 << 16);
+    void desativar();
+    bool ativo();
+
+    // nome da thread atual na linha do tempo
+    void nomearThread(const string& nome);
+
+    // cópia permanente de um nome montado em tempo de execução (ex.: nome do estágio)
+    const char* internar(const string& nome);
+
+    // grava um evento completo na thread atual
+    void registrar(const char* nome, const char* categoria, int64_t inicioNs, int64_t fimNs);
+
+    // grava o JSON trace_event com os eventos de todas as threads
+    void salvar(const string& caminho);
+
+    int64_t agoraNs();
+
+    // evento do construtor ao destrutor
+    class Escopo
+    {
+    public:
+        Escopo(const char* nome, const char* categoria)
+            : nome(nome), categoria(categoria), inicio(ativo() ? agoraNs() : -1) {}
+
+        ~Escopo()
+        {
+            if (inicio >= 0) registrar(nome, categoria, inicio, agoraNs());
+        }
+
+        Escopo(const Escopo&) = delete;
+        Escopo& operator=(const Escopo&) = delete;
+
+    private:
+        const char* nome;
+        const char* categoria;
+        int64_t inicio;
+    };
+}
+
+#ifdef ETL_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_ESCOPO(nome, categoria) Trace::Escopo TRACE_CONCAT(escopoTrace_, __LINE__)(nome, categoria)
+#define TRACE_NOMEAR_THREAD(nome) Trace::nomearThread(nome)
+#else
+#define TRACE_ESCOPO(nome, categoria) ((void)0)
+#define TRACE_NOMEAR_THREAD(nome) ((void)0)
+#endif
+
+#endif // TRACE_HPP
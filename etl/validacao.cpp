@@ -0,0 +1,341 @@
+#include "validacao.hpp"
+#include "executor.hpp"
+#include "trace.hpp"
+#include "../json.hpp"
+#include <algorithm>
+#include <variant>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+namespace
+{
+    bool nula(int x) { return x == 0; }
+    bool nula(double x) { return x == 0.0; }
+    bool nula(const string& x) { return x.empty(); }
+
+    // Um kernel por tipo de validador, com uma sobrecarga por tipo de célula. As regras seguem o texto
+    // da célula (to_string para números): um double nunca tem só dígitos nem bate com "0"/"1".
+    struct KernelAceitaTudo
+    {
+        template <typename T>
+        static bool valido(const ValidadorColuna&, const T&) { return true; }
+    };
+
+    struct KernelDigitos
+    {
+        static bool valido(const ValidadorColuna& v, int x)
+        {
+            if (v.aceitaNulos && nula(x)) return true;
+            if (x < 0) return false;
+            size_t digitos = 1;
+            for (int resto = x / 10; resto; resto /= 10) ++digitos;
+            return digitos == v.numDigitos;
+        }
+
+        static bool valido(const ValidadorColuna& v, double x) { return v.aceitaNulos && nula(x); }
+
+        static bool valido(const ValidadorColuna& v, const string& x)
+        {
+            if (v.aceitaNulos && nula(x)) return true;
+            return x.size() == v.numDigitos &&
+                all_of(x.begin(), x.end(), [](unsigned char c) { return c >= '0' && c <= '9'; });
+        }
+    };
+
+    struct KernelConjunto
+    {
+        template <typename T>
+        static bool contem(const vector<T>& aceitos, const T& x)
+        {
+            return find(aceitos.begin(), aceitos.end(), x) != aceitos.end();
+        }
+
+        static bool valido(const ValidadorColuna& v, int x) { return (v.aceitaNulos && nula(x)) || contem(v.inteiros, x); }
+        static bool valido(const ValidadorColuna& v, double x) { return (v.aceitaNulos && nula(x)) || contem(v.reais, x); }
+        static bool valido(const ValidadorColuna& v, const string& x) { return (v.aceitaNulos && nula(x)) || contem(v.textos, x); }
+    };
+
+    struct KernelFaixa
+    {
+        // NaN passa: nenhuma comparação com ele é verdadeira
+        static bool valido(const ValidadorColuna& v, double x)
+        {
+            if (v.aceitaNulos && nula(x)) return true;
+            return !(x < v.minimo || x > v.maximo);
+        }
+
+        static bool valido(const ValidadorColuna& v, int x) { return valido(v, static_cast<double>(x)); }
+
+        // texto não numérico só passa se for nulo
+        static bool valido(const ValidadorColuna& v, const string& x) { return v.aceitaNulos && nula(x); }
+    };
+
+    // células do tipo T vão direto ao kernel; as de outro tipo caem no visit genérico (ou reprovam, com
+    // exigeTipo, se não forem nulas)
+    template <typename Kernel, typename T>
+    inline bool avaliarTipado(const ValidadorColuna& v, const Cell& celula)
+    {
+        if (const T* valor = get_if<T>(&celula)) return Kernel::valido(v, *valor);
+        if (v.exigeTipo) return v.aceitaNulos && visit([](const auto& outro) { return nula(outro); }, celula);
+        return visit([&](const auto& outro) { return Kernel::valido(v, outro); }, celula);
+    }
+
+    template <typename Kernel>
+    bool avaliar(const ValidadorColuna& v, const Cell& celula)
+    {
+        switch (v.tipoColuna)
+        {
+            case ColumnType::INTEGER: return avaliarTipado<Kernel, int>(v, celula);
+            case ColumnType::DOUBLE:  return avaliarTipado<Kernel, double>(v, celula);
+            case ColumnType::STRING:  return avaliarTipado<Kernel, string>(v, celula);
+        }
+        return true;
+    }
+
+    // varre [inicio, fim) (inicio múltiplo de 64) numa coluna cujas células são do tipo T
+    template <typename Kernel, typename T>
+    void varrerTipado(const DataFrame& df, const ValidadorColuna& v, size_t inicio, size_t fim, uint64_t* palavras)
+    {
+        for (size_t base = inicio; base < fim; base += 64)
+        {
+            const size_t limite = min(base + 64, fim);
+            uint64_t invalidas = 0;
+            for (size_t i = base; i < limite; ++i)
+            {
+                const bool ok = avaliarTipado<Kernel, T>(v, df.getRow(i)[v.coluna]);
+                invalidas |= uint64_t(!ok) << (i - base);
+            }
+            palavras[base >> 6] |= invalidas;
+        }
+    }
+
+    template <typename Kernel>
+    void varrer(const DataFrame& df, const ValidadorColuna& v, size_t inicio, size_t fim, uint64_t* palavras)
+    {
+        switch (v.tipoColuna)
+        {
+            case ColumnType::INTEGER: varrerTipado<Kernel, int>(df, v, inicio, fim, palavras); break;
+            case ColumnType::DOUBLE:  varrerTipado<Kernel, double>(df, v, inicio, fim, palavras); break;
+            case ColumnType::STRING:  varrerTipado<Kernel, string>(df, v, inicio, fim, palavras); break;
+        }
+    }
+}
+
+ValidadorColuna validadorFaixa(size_t coluna, ColumnType tipoColuna, double minimo, double maximo)
+{
+    ValidadorColuna v;
+    v.coluna = coluna;
+    v.tipoColuna = tipoColuna;
+    v.tipo = TipoValidador::FAIXA;
+    v.minimo = minimo;
+    v.maximo = maximo;
+    return v;
+}
+
+ValidadorColuna validadorDigitos(size_t coluna, ColumnType tipoColuna, size_t numDigitos)
+{
+    ValidadorColuna v;
+    v.coluna = coluna;
+    v.tipoColuna = tipoColuna;
+    v.tipo = TipoValidador::DIGITOS;
+    v.numDigitos = numDigitos;
+    return v;
+}
+
+ValidadorColuna validadorConjunto(size_t coluna, ColumnType tipoColuna, const vector<string>& aceitos)
+{
+    ValidadorColuna v;
+    v.coluna = coluna;
+    v.tipoColuna = tipoColuna;
+    v.tipo = TipoValidador::CONJUNTO;
+    v.textos = aceitos;
+
+    // números cujo texto (to_string) é um dos aceitos, para comparar sem converter cada célula
+    for (const string& texto : aceitos)
+    {
+        try {
+            size_t usados = 0;
+            const int inteiro = stoi(texto, &usados);
+            if (usados == texto.size() && to_string(inteiro) == texto) v.inteiros.push_back(inteiro);
+        } catch (const exception&) {}
+        try {
+            size_t usados = 0;
+            const double real = stod(texto, &usados);
+            if (usados == texto.size() && to_string(real) == texto) v.reais.push_back(real);
+        } catch (const exception&) {}
+    }
+    return v;
+}
+
+// compila a regra de uma coluna do arquivo de regras
+static ValidadorColuna compilarRegra(const string& coluna, const json& regra)
+{
+    if (!regra.is_object()) throw runtime_error("regra da coluna " + coluna + " deve ser um objeto");
+
+    ColumnType tipo = ColumnType::STRING;
+    bool exigeTipo = false;
+    if (regra.contains("tipo"))
+    {
+        const string nome = regra.at("tipo").get<string>();
+        if (nome == "int") tipo = ColumnType::INTEGER;
+        else if (nome == "double") tipo = ColumnType::DOUBLE;
+        else if (nome != "string") throw runtime_error("tipo desconhecido na coluna " + coluna + ": " + nome);
+        exigeTipo = true;
+    }
+
+    ValidadorColuna v;
+    if (regra.contains("cep"))
+    {
+        const string formato = regra.at("cep").get<string>();
+        if (formato != "ilha" && formato != "regiao")
+            throw runtime_error("formato de CEP desconhecido na coluna " + coluna + ": " + formato);
+        v = validadorDigitos(0, tipo, formato == "ilha" ? 2 : 5);
+    }
+    else if (regra.contains("digitos"))
+    {
+        v = validadorDigitos(0, tipo, regra.at("digitos").get<size_t>());
+    }
+    else if (regra.contains("valores"))
+    {
+        vector<string> aceitos;
+        for (const auto& valor : regra.at("valores"))
+            aceitos.push_back(valor.is_string() ? valor.get<string>() : valor.dump());
+        v = validadorConjunto(0, tipo, aceitos);
+    }
+    else if (regra.contains("min") || regra.contains("max"))
+    {
+        v = validadorFaixa(0, tipo, regra.value("min", -numeric_limits<double>::infinity()),
+            regra.value("max", numeric_limits<double>::infinity()));
+    }
+    else
+    {
+        v.tipoColuna = tipo;
+    }
+
+    v.exigeTipo = exigeTipo;
+    v.aceitaNulos = regra.value("nulos", true);
+    return v;
+}
+
+EsquemaValidacao EsquemaValidacao::carregar(const string& caminho)
+{
+    ifstream arquivo(caminho);
+    if (!arquivo.is_open()) throw runtime_error("Não foi possível abrir o arquivo de regras: " + caminho);
+
+    EsquemaValidacao esquema;
+    try {
+        json j;
+        arquivo >> j;
+        esquema.fonte = j.value("fonte", filesystem::path(caminho).stem().string());
+        for (const auto& [coluna, regra] : j.at("colunas").items())
+            esquema.regras.push_back({coluna, compilarRegra(coluna, regra)});
+        esquema.tipoAvisado = make_shared<vector<atomic<bool>>>(esquema.regras.size());
+    } catch (const json::exception& e) {
+        throw runtime_error("Arquivo de regras inválido (" + caminho + "): " + e.what());
+    } catch (const runtime_error& e) {
+        throw runtime_error("Arquivo de regras inválido (" + caminho + "): " + e.what());
+    }
+    return esquema;
+}
+
+vector<EsquemaValidacao> EsquemaValidacao::carregarDiretorio(const string& diretorio)
+{
+    vector<EsquemaValidacao> esquemas;
+    error_code erro;
+    if (!filesystem::is_directory(diretorio, erro)) return esquemas;
+
+    vector<string> arquivos;
+    for (const auto& entrada : filesystem::directory_iterator(diretorio, erro))
+        if (entrada.path().extension() == ".json") arquivos.push_back(entrada.path().string());
+    sort(arquivos.begin(), arquivos.end());
+
+    for (const auto& caminho : arquivos)
+    {
+        try {
+            esquemas.push_back(carregar(caminho));
+        } catch (const exception& e) {
+            cerr << "[Regras] " << e.what() << endl;
+        }
+    }
+    return esquemas;
+}
+
+vector<ValidadorColuna> EsquemaValidacao::vincular(const DataFrame& df) const
+{
+    vector<ValidadorColuna> validadores;
+    for (size_t k = 0; k < regras.size(); ++k)
+    {
+        const auto& [coluna, regra] = regras[k];
+        const size_t idx = df.colIdx(coluna);
+        if (idx == static_cast<size_t>(-1)) continue;
+
+        ValidadorColuna v = regra;
+        v.coluna = idx;
+        if (!v.exigeTipo) v.tipoColuna = df.typeCol(idx);
+        // vinculado a cada lote no modo stream: avisa só na primeira vez
+        else if (v.tipoColuna != df.typeCol(idx) && tipoAvisado && !(*tipoAvisado)[k].exchange(true, memory_order_relaxed))
+            cerr << "[Regras] " << fonte << ": coluna " << coluna << " não tem o tipo declarado" << endl;
+        validadores.push_back(move(v));
+    }
+    return validadores;
+}
+
+bool celulaValida(const ValidadorColuna& v, const Cell& celula)
+{
+    switch (v.tipo)
+    {
+        case TipoValidador::ACEITA_TUDO: return !v.exigeTipo || avaliar<KernelAceitaTudo>(v, celula);
+        case TipoValidador::DIGITOS:     return avaliar<KernelDigitos>(v, celula);
+        case TipoValidador::CONJUNTO:    return avaliar<KernelConjunto>(v, celula);
+        case TipoValidador::FAIXA:       return avaliar<KernelFaixa>(v, celula);
+    }
+    return true;
+}
+
+size_t MascaraLinhas::contar() const
+{
+    size_t total = 0;
+    for (uint64_t palavra : palavras) total += __builtin_popcountll(palavra);
+    return total;
+}
+
+MascaraLinhas validarLinhas(const DataFrame& input, const vector<ValidadorColuna>& validadores, int numThreads)
+{
+    TRACE_ESCOPO("validarLinhas", "handler");
+
+    const size_t numLinhas = static_cast<size_t>(input.size());
+    MascaraLinhas invalidas(numLinhas);
+    if (numLinhas == 0) return invalidas;
+
+    // blocos múltiplos de 64 linhas: cada palavra da máscara é escrita por um único bloco
+    const size_t grao = (Executor::grao(numLinhas, numThreads) + 63) / 64 * 64;
+    Executor::global().parallel_for(0, numLinhas, grao, [&](size_t inicio, size_t fim)
+    {
+        for (const ValidadorColuna& v : validadores)
+        {
+            switch (v.tipo)
+            {
+                case TipoValidador::ACEITA_TUDO:
+                    if (v.exigeTipo) varrer<KernelAceitaTudo>(input, v, inicio, fim, invalidas.palavras.data());
+                    break;
+                case TipoValidador::DIGITOS:  varrer<KernelDigitos>(input, v, inicio, fim, invalidas.palavras.data()); break;
+                case TipoValidador::CONJUNTO: varrer<KernelConjunto>(input, v, inicio, fim, invalidas.palavras.data()); break;
+                case TipoValidador::FAIXA:    varrer<KernelFaixa>(input, v, inicio, fim, invalidas.palavras.data()); break;
+            }
+        }
+    });
+
+    return invalidas;
+}
+
+vector<size_t> linhasNaoMarcadas(const MascaraLinhas& mascara, size_t numLinhas)
+{
+    vector<size_t> linhas;
+    linhas.reserve(numLinhas);
+    for (size_t i = 0; i < numLinhas; ++i)
+        if (!mascara.marcada(i)) linhas.push_back(i);
+    return linhas;
+}
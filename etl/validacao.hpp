@@ -0,0 +1,98 @@
+#ifndef VALIDACAO_HPP
+#define VALIDACAO_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <memory>
+#include <atomic>
+#include "dataframe.hpp"
+
+using namespace std;
+
+// Validação compilada: cada regra de coluna vira, uma vez, um validador especializado pelo tipo da regra
+// e pelo tipo da coluna (faixa numérica, quantidade de dígitos, conjunto de valores aceitos). A validação
+// roda coluna a coluna dentro de blocos de 64 linhas alinhados, marcando as linhas inválidas numa máscara
+// de bits; cada palavra da máscara pertence a um único bloco, então não há locks.
+//
+// As regras de cada fonte vêm de arquivos JSON (EsquemaValidacao, compilados na partida); a inferência
+// por amostra do Handler fica só para fontes sem arquivo de regras.
+
+enum class TipoValidador { ACEITA_TUDO, DIGITOS, CONJUNTO, FAIXA };
+
+struct ValidadorColuna
+{
+    size_t coluna = 0;
+    ColumnType tipoColuna = ColumnType::STRING;
+    TipoValidador tipo = TipoValidador::ACEITA_TUDO;
+    bool aceitaNulos = true;     // células nulas ("" / 0 / 0.0) passam sem checagem
+    bool exigeTipo = false;      // célula não nula de outro tipo que tipoColuna reprova
+
+    size_t numDigitos = 0;                                   // DIGITOS: texto só com esta quantidade de dígitos
+    double minimo = -numeric_limits<double>::infinity();     // FAIXA
+    double maximo = numeric_limits<double>::infinity();      // FAIXA
+    vector<string> textos;                                   // CONJUNTO: textos aceitos
+    vector<int> inteiros;                                    // CONJUNTO: inteiros cujo texto está em textos
+    vector<double> reais;                                    // CONJUNTO: doubles cujo texto está em textos
+};
+
+// validadores prontos para uma coluna do tipo tipoColuna
+ValidadorColuna validadorFaixa(size_t coluna, ColumnType tipoColuna, double minimo, double maximo);
+ValidadorColuna validadorDigitos(size_t coluna, ColumnType tipoColuna, size_t numDigitos);
+ValidadorColuna validadorConjunto(size_t coluna, ColumnType tipoColuna, const vector<string>& aceitos);
+
+// Regras declaradas de uma fonte, lidas de um arquivo JSON:
+//   {"fonte": "hospital", "colunas": {"idade": {"tipo": "int", "min": 0, "max": 120},
+//                                     "cep": {"tipo": "int", "cep": "regiao"},
+//                                     "internado": {"tipo": "int", "valores": [0, 1]}}}
+// Por coluna: "tipo" ("int", "double" ou "string"; células de outro tipo reprovam), e no máximo uma
+// checagem: "cep" ("ilha" = 2 dígitos, "regiao" = 5) ou "digitos", "valores", ou "min"/"max".
+// "nulos": false faz as células nulas também passarem pela checagem.
+class EsquemaValidacao
+{
+public:
+    // lê e compila um arquivo de regras; lança runtime_error se não abrir ou tiver regra inválida
+    static EsquemaValidacao carregar(const string& caminho);
+
+    // esquemas de todos os .json de um diretório (vazio se ele não existir); arquivos inválidos são
+    // reportados e ignorados
+    static vector<EsquemaValidacao> carregarDiretorio(const string& diretorio);
+
+    // fonte (nome do arquivo sem extensão quando o JSON não declara "fonte")
+    const string& getFonte() const { return fonte; }
+
+    // validadores ligados às colunas de df; colunas sem regra não são validadas e regras de colunas
+    // ausentes são ignoradas. Coluna com tipo diferente do declarado é avisada uma vez por regra (as
+    // células reprovam como TIPO e são contadas na quarentena)
+    vector<ValidadorColuna> vincular(const DataFrame& df) const;
+
+private:
+    string fonte;
+    vector<pair<string, ValidadorColuna>> regras;   // coluna -> validador compilado (índice definido no vínculo)
+    shared_ptr<vector<atomic<bool>>> tipoAvisado;   // por regra: divergência de tipo já avisada
+};
+
+// uma célula isolada pelo validador (mesmas regras da varredura; usado fora do caminho quente)
+bool celulaValida(const ValidadorColuna& v, const Cell& celula);
+
+// Máscara de linhas: bit i ligado = linha i marcada
+struct MascaraLinhas
+{
+    vector<uint64_t> palavras;
+
+    explicit MascaraLinhas(size_t numLinhas = 0) : palavras((numLinhas + 63) / 64, 0) {}
+    bool marcada(size_t i) const { return (palavras[i >> 6] >> (i & 63)) & 1; }
+    void marcar(size_t i) { palavras[i >> 6] |= uint64_t(1) << (i & 63); }
+    size_t contar() const;
+};
+
+// linhas reprovadas por algum validador
+MascaraLinhas validarLinhas(const DataFrame& input, const vector<ValidadorColuna>& validadores, int numThreads);
+
+// índices (crescentes) das linhas não marcadas
+vector<size_t> linhasNaoMarcadas(const MascaraLinhas& mascara, size_t numLinhas);
+
+#endif // VALIDACAO_HPP
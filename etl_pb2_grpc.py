@@ -39,6 +39,11 @@ class ETLServiceStub(object):
                 request_serializer=etl__pb2.DadosRequest.SerializeToString,
                 response_deserializer=etl__pb2.DadosResponse.FromString,
                 _registered_method=True)
+        self.EnviarDadosStream = channel.stream_unary(
+                '/etl.ETLService/EnviarDadosStream',
+                request_serializer=etl__pb2.DadosRequest.SerializeToString,
+                response_deserializer=etl__pb2.DadosResponse.FromString,
+                _registered_method=True)
 
 
 class ETLServiceServicer(object):
@@ -50,6 +55,13 @@ class ETLServiceServicer(object):
         context.set_details('Method not implemented!')
         raise NotImplementedError('Method not implemented!')
 
+    def EnviarDadosStream(self, request_iterator, context):
+        """Ingestão em lotes: cada mensagem do stream carrega um pedaço do arquivo (mesma origem e nome_arquivo)
+        """
+        context.set_code(grpc.StatusCode.UNIMPLEMENTED)
+        context.set_details('Method not implemented!')
+        raise NotImplementedError('Method not implemented!')
+
 
 def add_ETLServiceServicer_to_server(servicer, server):
     rpc_method_handlers = {
@@ -58,6 +70,11 @@ def add_ETLServiceServicer_to_server(servicer, server):
                     request_deserializer=etl__pb2.DadosRequest.FromString,
                     response_serializer=etl__pb2.DadosResponse.SerializeToString,
             ),
+            'EnviarDadosStream': grpc.stream_unary_rpc_method_handler(
+                    servicer.EnviarDadosStream,
+                    request_deserializer=etl__pb2.DadosRequest.FromString,
+                    response_serializer=etl__pb2.DadosResponse.SerializeToString,
+            ),
     }
     generic_handler = grpc.method_handlers_generic_handler(
             'etl.ETLService', rpc_method_handlers)
@@ -95,3 +112,31 @@ class ETLService(object):
             timeout,
             metadata,
             _registered_method=True)
+
+
+    @staticmethod
+    def EnviarDadosStream(request_iterator,
+            target,
+            options=(),
+            channel_credentials=None,
+            call_credentials=None,
+            insecure=False,
+            compression=None,
+            wait_for_ready=None,
+            timeout=None,
+            metadata=None):
+        return grpc.experimental.stream_unary(
+            request_iterator,
+            target,
+            '/etl.ETLService/EnviarDadosStream',
+            etl__pb2.DadosRequest.SerializeToString,
+            etl__pb2.DadosResponse.FromString,
+            options,
+            channel_credentials,
+            insecure,
+            call_credentials,
+            compression,
+            wait_for_ready,
+            timeout,
+            metadata,
+            _registered_method=True)
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include "etl/tabela_hash.hpp"
+
+using namespace std;
+
+// Compara a TabelaHash (etl/tabela_hash.hpp) com os mapas da biblioteca padrão nos três usos do
+// pipeline: agregação por chave inteira (groupedDf), agregação por chave string curta (códigos de
+// ilha, merge) e deduplicação por hash de linha (dataCleaner).
+// Uso: ./hashBench [numLinhas] [numChaves]   (padrão: 1000000 linhas, 1/10 das linhas como chaves)
+
+template <typename F>
+static double medir(F&& f)
+{
+    auto inicio = chrono::steady_clock::now();
+    f();
+    chrono::duration<double> decorrido = chrono::steady_clock::now() - inicio;
+    return decorrido.count();
+}
+
+static void relatar(const string& caso, size_t numLinhas, double padrao, double plana, double checagem)
+{
+    cout << caso << "\n"
+         << "   unordered: " << padrao << " s (" << numLinhas / padrao / 1e6 << " M linhas/s)\n"
+         << "   TabelaHash: " << plana << " s (" << numLinhas / plana / 1e6 << " M linhas/s)"
+         << " | ganho " << padrao / plana << "x | checagem " << checagem << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t numLinhas = argc > 1 ? stoul(argv[1]) : 1000000;
+    const size_t numChaves = argc > 2 ? stoul(argv[2]) : max<size_t>(numLinhas / 10, 1);
+
+    mt19937_64 gerador(42);
+    uniform_int_distribution<int> sortearChave(0, static_cast<int>(numChaves) - 1);
+
+    vector<int> chaves(numLinhas);
+    vector<double> valores(numLinhas);
+    for (size_t i = 0; i < numLinhas; ++i)
+    {
+        chaves[i] = sortearChave(gerador);
+        valores[i] = static_cast<double>(i % 100);
+    }
+
+    cout << "\n=== " << numLinhas << " linhas, " << numChaves << " chaves distintas ===" << endl;
+
+    // ---- Agregação por chave inteira ----
+    {
+        double somaPadrao = 0, somaPlana = 0;
+        double tPadrao = medir([&] {
+            unordered_map<int, double> totais;
+            for (size_t i = 0; i < numLinhas; ++i) totais[chaves[i]] += valores[i];
+            for (const auto& [k, v] : totais) somaPadrao += v;
+        });
+        double tPlana = medir([&] {
+            TabelaHash<int, double> totais;
+            for (size_t i = 0; i < numLinhas; ++i) totais[chaves[i]] += valores[i];
+            totais.paraCada([&](int, double v) { somaPlana += v; });
+        });
+        relatar("Soma por chave int", numLinhas, tPadrao, tPlana, somaPlana - somaPadrao);
+    }
+
+    // ---- Agregação por chave string curta (códigos como os de ilha/CEP) ----
+    {
+        vector<string> chavesTexto(numLinhas);
+        for (size_t i = 0; i < numLinhas; ++i) chavesTexto[i] = to_string(10000 + chaves[i]);
+
+        double somaPadrao = 0, somaPlana = 0;
+        double tPadrao = medir([&] {
+            unordered_map<string, double> totais;
+            for (size_t i = 0; i < numLinhas; ++i) totais[chavesTexto[i]] += valores[i];
+            for (const auto& [k, v] : totais) somaPadrao += v;
+        });
+        double tPlana = medir([&] {
+            TabelaHash<string, double> totais;
+            for (size_t i = 0; i < numLinhas; ++i) totais[chavesTexto[i]] += valores[i];
+            totais.paraCada([&](const string&, double v) { somaPlana += v; });
+        });
+        relatar("Soma por chave string", numLinhas, tPadrao, tPlana, somaPlana - somaPadrao);
+    }
+
+    // ---- Deduplicação por hash de linha ----
+    {
+        vector<size_t> hashes(numLinhas);
+        for (size_t i = 0; i < numLinhas; ++i) hashes[i] = hash<int>()(chaves[i]) * 0x9e3779b97f4a7c15ULL;
+
+        size_t unicosPadrao = 0, unicosPlana = 0;
+        double tPadrao = medir([&] {
+            unordered_set<size_t> vistos;
+            for (size_t h : hashes) unicosPadrao += vistos.insert(h).second;
+        });
+        double tPlana = medir([&] {
+            TabelaHash<size_t, bool> vistos;
+            for (size_t h : hashes) unicosPlana += vistos.inserir(h).second;
+        });
+        relatar("Deduplicação por hash", numLinhas, tPadrao, tPlana,
+            static_cast<double>(unicosPlana) - static_cast<double>(unicosPadrao));
+    }
+
+    return 0;
+}
@@ -2,6 +2,8 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <sstream>
+#include <cstdlib>
 #include "json.hpp"
 #include "pipeline/pipeline.hpp"
 
@@ -55,9 +57,58 @@ void processarSecretaria(const std::string& caminho) {
     }
 }
 
+// opções depois das entradas: --metricas <arquivo.json|arquivo.prom>, --trace <arquivo.json>,
+// --workers <extração,tratamento,merge,loader>, --autoescala <orçamento de núcleos, 0 = todos> e
+// --fixar-cpus <0|1> (afinidade pelos domínios L3) e --podar-ilhas <0|1> (poda do hospital pelas ilhas de
+// OMS e secretaria). Nos modos por lotes (--stream, --shm) valem tratamento e loader de --workers; autoescala,
+// afinidade e poda são só do modo por arquivos
+bool lerOpcoes(int argc, char* argv[], int inicio, ConfigPipeline& config) {
+    if (argc < inicio || (argc - inicio) % 2 != 0) return false;
+
+    for (int i = inicio; i + 1 < argc; i += 2) {
+        std::string opcao = argv[i];
+        if (opcao == "--metricas") config.arquivoMetricas = argv[i + 1];
+        else if (opcao == "--trace") config.arquivoTrace = argv[i + 1];
+        else if (opcao == "--workers") {
+            char virgula;
+            std::istringstream valores(argv[i + 1]);
+            if (!(valores >> config.workersExtracao >> virgula >> config.workersTratamento
+                >> virgula >> config.workersMerge >> virgula >> config.workersLoader)) return false;
+        }
+        else if (opcao == "--fixar-cpus") config.fixarCpus = std::string(argv[i + 1]) == "1";
+        else if (opcao == "--podar-ilhas") config.podarPorIlha = std::string(argv[i + 1]) == "1";
+        else if (opcao == "--autoescala") {
+            config.autoescala = true;
+            config.orcamentoNucleos = std::atoi(argv[i + 1]);
+        }
+        else return false;
+    }
+    return true;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 4) {
-        std::cerr << "Uso: programa.exe <oms.json> <hospital.json> <secretaria.json>\n";
+    ConfigPipeline config;
+    config.numConsumidores = 4;
+
+    // modo stream: lotes chegam pela entrada padrão (enviados pelo server.py)
+    const std::string modo = argc > 1 ? argv[1] : "";
+    if (modo == "--stream" && lerOpcoes(argc, argv, 2, config)) {
+        Pipeline(config).executarStream(std::cin);
+        return 0;
+    }
+
+    // modo memória compartilhada: produtores locais enviam lotes pelo canal (ver pipeline/canal_shm.hpp)
+    if (modo == "--shm" && lerOpcoes(argc, argv, 3, config)) {
+        Pipeline(config).executarShm(argv[2]);
+        return 0;
+    }
+
+    if (modo == "--stream" || modo == "--shm" || !lerOpcoes(argc, argv, 4, config)) {
+        std::cerr << "Uso: programa.exe <oms.json> <hospital.json> <secretaria.json> [opções]\n";
+        std::cerr << "     programa.exe --stream [opções]   (lotes \"<origem>\\t<json>\" pela entrada padrão)\n";
+        std::cerr << "     programa.exe --shm <nome do canal> [opções]   (ex.: /etl_canal)\n";
+        std::cerr << "Opções: [--metricas <arquivo>] [--trace <arquivo>] [--workers <e,t,m,l>]\n";
+        std::cerr << "        [--autoescala <núcleos>] [--fixar-cpus 1] [--podar-ilhas 1]   (as três últimas só por arquivos)\n";
         return 1;
     }
 
@@ -65,7 +116,8 @@ int main(int argc, char* argv[]) {
     std::string arquivoSecretaria = argv[2];
     std::string arquivoOms = argv[1];
 
-    executarPipeline(4, arquivoOms, arquivoSecretaria, arquivoHospital);
+    Pipeline pipeline(config);
+    pipeline.executar(arquivoOms, arquivoSecretaria, arquivoHospital);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,145 @@
+#include "autoescala.hpp"
+#include <algorithm>
+#include <chrono>
+
+// ---------------- Vagas ----------------
+
+VagasEstagio::VagasEstagio(const string& nome, int inicial, int minimo, int maximo,
+    const MetricasEstagio& metricas, function<size_t()> profundidade, function<bool()> entradaFechada)
+    : nome(nome), limite(0), minimo(max(minimo, 1)), maximo(max(maximo, max(minimo, 1))),
+      metricas(metricas), profundidade(move(profundidade)), entradaFechada(move(entradaFechada))
+{
+    limite = clamp(inicial, this->minimo, this->maximo);
+}
+
+bool VagasEstagio::aguardar(int id)
+{
+    if (id <= limite.load(memory_order_acquire)) return true;
+
+    unique_lock<mutex> lock(mtx);
+    while (id > limite.load(memory_order_acquire))
+    {
+        // sem vaga e sem mais entrada: os workers ativos drenam o que sobrou
+        if (entradaFechada()) return false;
+        // o fechamento da entrada não avisa esta condvar, então a espera tem prazo
+        condVar.wait_for(lock, chrono::milliseconds(5));
+    }
+    return true;
+}
+
+void VagasEstagio::definirLimite(int novo)
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        limite.store(clamp(novo, minimo, maximo), memory_order_release);
+    }
+    condVar.notify_all();
+}
+
+// ---------------- Controlador ----------------
+
+ControladorWorkers::ControladorWorkers(int orcamentoNucleos, int intervaloMs)
+    : orcamento(orcamentoNucleos), intervaloMs(max(intervaloMs, 1))
+{
+}
+
+ControladorWorkers::~ControladorWorkers()
+{
+    parar();
+}
+
+VagasEstagio& ControladorWorkers::adicionarEstagio(const string& nome, int inicial, int minimo, int maximo,
+    const MetricasEstagio& metricas, function<size_t()> profundidade, function<bool()> entradaFechada)
+{
+    estagios.push_back(make_unique<VagasEstagio>(nome, inicial, minimo, maximo, metricas,
+        move(profundidade), move(entradaFechada)));
+    return *estagios.back();
+}
+
+void ControladorWorkers::iniciar()
+{
+    encerrar = false;
+    periodico = thread([this] {
+        unique_lock<mutex> lock(mtx);
+        while (!condVar.wait_for(lock, chrono::milliseconds(intervaloMs), [this] { return encerrar; }))
+            ajustar();
+    });
+}
+
+void ControladorWorkers::parar()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        encerrar = true;
+    }
+    condVar.notify_all();
+    if (periodico.joinable()) periodico.join();
+}
+
+void ControladorWorkers::ajustar()
+{
+    // tempo mínimo de serviço assumido antes do primeiro item medido (1 µs)
+    constexpr double SERVICO_MINIMO_NS = 1e3;
+
+    int soma = 0;
+    VagasEstagio* receptor = nullptr;
+    VagasEstagio* doador = nullptr;
+
+    for (auto& e : estagios)
+    {
+        uint64_t itens = 0, ocupado = 0;
+        for (const auto& w : e->metricas.getWorkers())
+        {
+            itens += w->itens.load(memory_order_relaxed);
+            ocupado += w->ocupadoNs.load(memory_order_relaxed);
+        }
+
+        // média móvel do tempo de serviço com os itens terminados desde a última rodada
+        if (itens > e->itensAnterior)
+        {
+            double amostra = static_cast<double>(ocupado - e->ocupadoAnterior) / (itens - e->itensAnterior);
+            e->servicoNs = e->servicoNs == 0 ? amostra : 0.7 * e->servicoNs + 0.3 * amostra;
+        }
+        e->itensAnterior = itens;
+        e->ocupadoAnterior = ocupado;
+
+        const int limite = e->getLimite();
+        const size_t profundidade = e->profundidade();
+        e->carga = profundidade * max(e->servicoNs, SERVICO_MINIMO_NS) / limite;
+        soma += limite;
+
+        // recebe vaga o estágio com mais trabalho acumulado; doa o mais folgado
+        if (profundidade > 0 && limite < e->maximo && (!receptor || e->carga > receptor->carga))
+            receptor = e.get();
+        if (limite > e->minimo && (!doador || e->carga < doador->carga))
+            doador = e.get();
+    }
+
+    if (doador == receptor) doador = nullptr;
+
+    // acima do orçamento (limites iniciais grandes demais): devolve uma vaga do mais folgado
+    if (soma > orcamento)
+    {
+        if (doador)
+        {
+            doador->definirLimite(doador->getLimite() - 1);
+            ++ajustes;
+        }
+        return;
+    }
+
+    if (!receptor) return;
+
+    if (soma < orcamento)
+    {
+        receptor->definirLimite(receptor->getLimite() + 1);
+        ++ajustes;
+    }
+    else if (doador && doador->carga * 2 < receptor->carga)
+    {
+        // orçamento cheio: só move se o receptor estiver bem mais atrasado (evita oscilar)
+        doador->definirLimite(doador->getLimite() - 1);
+        receptor->definirLimite(receptor->getLimite() + 1);
+        ++ajustes;
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef AUTOESCALA_HPP
+#define AUTOESCALA_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "metricas.hpp"
+
+using namespace std;
+
+// Autoescala dos workers do pipeline: cada estágio sobe o número máximo de threads, mas só as de id
+// até o limite atual puxam itens da fila; as demais ficam paradas numa vaga. Um controlador periódico
+// move vagas entre estágios olhando a profundidade da fila de entrada e o tempo de serviço medido,
+// sem passar do orçamento total de núcleos.
+
+// Vagas de um estágio: o worker id só trabalha enquanto id <= limite
+class VagasEstagio
+{
+public:
+    VagasEstagio(const string& nome, int inicial, int minimo, int maximo,
+        const MetricasEstagio& metricas, function<size_t()> profundidade, function<bool()> entradaFechada);
+
+    // espera o worker id ter vaga; false quando a entrada fechou e o worker está sobrando
+    bool aguardar(int id);
+
+    void definirLimite(int limite);
+    int getLimite() const { return limite.load(memory_order_relaxed); }
+
+    const string& getNome() const { return nome; }
+    int getMinimo() const { return minimo; }
+    int getMaximo() const { return maximo; }
+
+private:
+    friend class ControladorWorkers;
+
+    string nome;
+    atomic<int> limite;
+    int minimo;
+    int maximo;
+
+    const MetricasEstagio& metricas;
+    function<size_t()> profundidade;
+    function<bool()> entradaFechada;
+
+    mutex mtx;
+    condition_variable condVar;
+
+    // estado do controlador (só a thread do controlador mexe)
+    uint64_t itensAnterior = 0;
+    uint64_t ocupadoAnterior = 0;
+    double servicoNs = 0;     // média móvel do tempo de serviço por item
+    double carga = 0;         // tempo estimado para esvaziar a fila com o limite atual
+};
+
+// Controlador periódico das vagas de todos os estágios de uma execução
+class ControladorWorkers
+{
+public:
+    // orcamentoNucleos: soma máxima dos limites (nunca abaixo de um worker por estágio)
+    ControladorWorkers(int orcamentoNucleos, int intervaloMs);
+    ~ControladorWorkers();
+
+    ControladorWorkers(const ControladorWorkers&) = delete;
+    ControladorWorkers& operator=(const ControladorWorkers&) = delete;
+
+    // cadastra um estágio antes de iniciar(); a referência vale enquanto o controlador existir
+    VagasEstagio& adicionarEstagio(const string& nome, int inicial, int minimo, int maximo,
+        const MetricasEstagio& metricas, function<size_t()> profundidade, function<bool()> entradaFechada);
+
+    void iniciar();
+    void parar();
+
+    // vagas movidas entre estágios desde o início
+    int getAjustes() const { return ajustes; }
+    const vector<unique_ptr<VagasEstagio>>& getEstagios() const { return estagios; }
+
+private:
+    // uma rodada: mede os estágios e move no máximo uma vaga
+    void ajustar();
+
+    vector<unique_ptr<VagasEstagio>> estagios;
+    int orcamento;
+    int intervaloMs;
+    int ajustes = 0;
+
+    bool encerrar = false;
+    mutex mtx;
+    condition_variable condVar;
+    thread periodico;
+};
+
+#endif // AUTOESCALA_HPP
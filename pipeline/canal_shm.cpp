@@ -0,0 +1,347 @@
+#include "canal_shm.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <new>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+
+using namespace std;
+
+const uint32_t MAGICO_CANAL = 0x45544C31; // "ETL1"
+
+// deslocamento do primeiro slot (cabeçalho arredondado para linha de cache)
+static size_t inicioSlots()
+{
+    return (sizeof(CanalShmCabecalho) + 63) / 64 * 64;
+}
+
+// espera progressiva: gira um pouco, depois cede a CPU e por fim dorme alguns microssegundos
+// (mantém a entrega abaixo de 1 ms sem queimar um núcleo quando o canal está ocioso)
+static void esperar(int& tentativas)
+{
+    ++tentativas;
+    if (tentativas < 64) return;
+    if (tentativas < 256) { this_thread::yield(); return; }
+    this_thread::sleep_for(chrono::microseconds(50));
+}
+
+static int64_t agoraNs()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+CanalShm::~CanalShm()
+{
+    if (base) munmap(base, tamanhoTotal);
+    if (dono) shm_unlink(nome.c_str());
+}
+
+void CanalShm::mapear(const string& nomeCanal, bool criar, uint32_t numSlots, uint32_t tamanhoSlot)
+{
+    nome = nomeCanal;
+
+    int fd;
+    if (criar)
+    {
+        // remove um canal antigo com o mesmo nome (execução anterior interrompida)
+        shm_unlink(nome.c_str());
+        fd = shm_open(nome.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) throw runtime_error("Não foi possível criar o canal: " + nome);
+
+        tamanhoTotal = inicioSlots() + size_t(numSlots) * tamanhoSlot;
+        if (ftruncate(fd, tamanhoTotal) != 0)
+        {
+            close(fd);
+            shm_unlink(nome.c_str());
+            throw runtime_error("Não foi possível dimensionar o canal: " + nome);
+        }
+        dono = true;
+    }
+    else
+    {
+        fd = shm_open(nome.c_str(), O_RDWR, 0600);
+        if (fd < 0) throw runtime_error("Canal não encontrado: " + nome);
+
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            close(fd);
+            throw runtime_error("Não foi possível ler o canal: " + nome);
+        }
+        tamanhoTotal = info.st_size;
+    }
+
+    void* mapa = mmap(nullptr, tamanhoTotal, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapa == MAP_FAILED) throw runtime_error("Falha no mmap do canal: " + nome);
+
+    base = static_cast<uint8_t*>(mapa);
+
+    if (criar)
+    {
+        // inicializa o cabeçalho e as sequências dos slots (posição i livre para o ciclo 0)
+        cabecalho = new (base) CanalShmCabecalho();
+        cabecalho->numSlots = numSlots;
+        cabecalho->tamanhoSlot = tamanhoSlot;
+        cabecalho->cabeca.store(0, memory_order_relaxed);
+        cabecalho->cauda.store(0, memory_order_relaxed);
+        cabecalho->produtoresAtivos.store(0, memory_order_relaxed);
+        cabecalho->fechado.store(0, memory_order_relaxed);
+
+        for (uint64_t i = 0; i < numSlots; ++i)
+        {
+            new (&sequenciaSlot(i)) atomic<uint64_t>(i);
+        }
+        // o mágico é publicado por último: produtores só usam o canal depois dele
+        atomic_thread_fence(memory_order_release);
+        cabecalho->magico = MAGICO_CANAL;
+    }
+    else
+    {
+        cabecalho = reinterpret_cast<CanalShmCabecalho*>(base);
+        if (tamanhoTotal < inicioSlots() || cabecalho->magico != MAGICO_CANAL)
+        {
+            throw runtime_error("Canal inválido ou ainda não inicializado: " + nome);
+        }
+        atomic_thread_fence(memory_order_acquire);
+    }
+}
+
+// layout de cada slot: [sequência (8 bytes) | tamanho usado (4) | reservado (4) | dados]
+atomic<uint64_t>& CanalShm::sequenciaSlot(uint64_t pos)
+{
+    uint8_t* slot = base + inicioSlots() + (pos % cabecalho->numSlots) * cabecalho->tamanhoSlot;
+    return *reinterpret_cast<atomic<uint64_t>*>(slot);
+}
+
+uint32_t& CanalShm::tamanhoUsado(uint64_t pos)
+{
+    uint8_t* slot = base + inicioSlots() + (pos % cabecalho->numSlots) * cabecalho->tamanhoSlot;
+    return *reinterpret_cast<uint32_t*>(slot + 8);
+}
+
+uint8_t* CanalShm::dadosSlot(uint64_t pos)
+{
+    return base + inicioSlots() + (pos % cabecalho->numSlots) * cabecalho->tamanhoSlot + 16;
+}
+
+size_t CanalShm::capacidadeSlot() const
+{
+    return cabecalho->tamanhoSlot - 16;
+}
+
+////////////////////////////////////// PRODUTOR //////////////////////////////////////
+
+ProdutorShm::ProdutorShm(const string& nomeCanal)
+{
+    mapear(nomeCanal, false, 0, 0);
+    cabecalho->produtoresAtivos.fetch_add(1, memory_order_relaxed);
+}
+
+// produtor destruído sem fechar conta como fechado, para o consumidor não esperar para sempre
+ProdutorShm::~ProdutorShm()
+{
+    if (cabecalho) fechar();
+}
+
+size_t ProdutorShm::linhasPorLote(OrigemShm origem) const
+{
+    size_t tamanhoLinha = origem == OrigemShm::OMS ? sizeof(LinhaOMSBin)
+        : origem == OrigemShm::HOSPITAL ? sizeof(LinhaHospitalBin) : sizeof(LinhaSecretariaBin);
+    return (capacidadeSlot() - sizeof(LoteShmCabecalho)) / tamanhoLinha;
+}
+
+void ProdutorShm::enviarLote(OrigemShm origem, const void* linhas, size_t numLinhas, size_t tamanhoLinha)
+{
+    uint64_t pos = cabecalho->cabeca.load(memory_order_relaxed);
+    int tentativas = 0;
+
+    // reserva um slot: ele está livre quando a sequência é igual à posição
+    while (true)
+    {
+        uint64_t seq = sequenciaSlot(pos).load(memory_order_acquire);
+        int64_t dif = int64_t(seq) - int64_t(pos);
+
+        if (dif == 0)
+        {
+            if (cabecalho->cabeca.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+        }
+        else if (dif < 0)
+        {
+            // anel cheio: o consumidor ainda não liberou este slot (controle de fluxo)
+            esperar(tentativas);
+            pos = cabecalho->cabeca.load(memory_order_relaxed);
+        }
+        else
+        {
+            pos = cabecalho->cabeca.load(memory_order_relaxed);
+        }
+    }
+
+    LoteShmCabecalho lote{static_cast<uint32_t>(origem), static_cast<uint32_t>(numLinhas), agoraNs()};
+    uint8_t* destino = dadosSlot(pos);
+    memcpy(destino, &lote, sizeof(lote));
+    memcpy(destino + sizeof(lote), linhas, numLinhas * tamanhoLinha);
+    tamanhoUsado(pos) = static_cast<uint32_t>(sizeof(lote) + numLinhas * tamanhoLinha);
+
+    // publica o slot para o consumidor
+    sequenciaSlot(pos).store(pos + 1, memory_order_release);
+}
+
+// cada envio divide o vetor em lotes que cabem em um slot
+void ProdutorShm::enviar(const vector<LinhaOMSBin>& linhas)
+{
+    const size_t porLote = linhasPorLote(OrigemShm::OMS);
+    for (size_t i = 0; i < linhas.size(); i += porLote)
+        enviarLote(OrigemShm::OMS, &linhas[i], min(porLote, linhas.size() - i), sizeof(LinhaOMSBin));
+}
+
+void ProdutorShm::enviar(const vector<LinhaHospitalBin>& linhas)
+{
+    const size_t porLote = linhasPorLote(OrigemShm::HOSPITAL);
+    for (size_t i = 0; i < linhas.size(); i += porLote)
+        enviarLote(OrigemShm::HOSPITAL, &linhas[i], min(porLote, linhas.size() - i), sizeof(LinhaHospitalBin));
+}
+
+void ProdutorShm::enviar(const vector<LinhaSecretariaBin>& linhas)
+{
+    const size_t porLote = linhasPorLote(OrigemShm::SECRETARIA);
+    for (size_t i = 0; i < linhas.size(); i += porLote)
+        enviarLote(OrigemShm::SECRETARIA, &linhas[i], min(porLote, linhas.size() - i), sizeof(LinhaSecretariaBin));
+}
+
+void ProdutorShm::fechar()
+{
+    if (fechou) return;
+    fechou = true;
+
+    // o último produtor ativo marca o canal como fechado
+    if (cabecalho->produtoresAtivos.fetch_sub(1, memory_order_acq_rel) == 1)
+        cabecalho->fechado.store(1, memory_order_release);
+}
+
+////////////////////////////////////// CONSUMIDOR //////////////////////////////////////
+
+ConsumidorShm::ConsumidorShm(const string& nomeCanal, uint32_t numSlots, uint32_t tamanhoSlot)
+{
+    if (numSlots == 0 || tamanhoSlot < 16 + sizeof(LoteShmCabecalho) + sizeof(LinhaHospitalBin))
+        throw invalid_argument("Dimensões inválidas para o canal em memória compartilhada.");
+
+    mapear(nomeCanal, true, numSlots, (tamanhoSlot + 63) / 64 * 64);
+}
+
+ConsumidorShm::~ConsumidorShm() = default;
+
+bool ConsumidorShm::receber(string& origem, DataFrame& df)
+{
+    const uint64_t pos = cabecalho->cauda.load(memory_order_relaxed);
+    int tentativas = 0;
+
+    // o slot está pronto quando a sequência é posição + 1
+    while (sequenciaSlot(pos).load(memory_order_acquire) != pos + 1)
+    {
+        // fechado, sem produtores ativos e sem slots reservados pendentes: fim do canal
+        if (cabecalho->fechado.load(memory_order_acquire) &&
+            cabecalho->produtoresAtivos.load(memory_order_acquire) == 0 &&
+            cabecalho->cabeca.load(memory_order_acquire) == pos)
+        {
+            return false;
+        }
+        esperar(tentativas);
+    }
+
+    const uint8_t* dados = dadosSlot(pos);
+    LoteShmCabecalho lote;
+    memcpy(&lote, dados, sizeof(lote));
+    ultimoEnvio = lote.enviadoNs;
+
+    // converte direto da memória compartilhada, sem cópia intermediária do lote
+    try {
+        df = loteShmParaDataFrame(dados, tamanhoUsado(pos), origem);
+    } catch (...) {
+        sequenciaSlot(pos).store(pos + cabecalho->numSlots, memory_order_release);
+        cabecalho->cauda.store(pos + 1, memory_order_relaxed);
+        throw;
+    }
+
+    // devolve o slot para o próximo ciclo do anel
+    sequenciaSlot(pos).store(pos + cabecalho->numSlots, memory_order_release);
+    cabecalho->cauda.store(pos + 1, memory_order_relaxed);
+    return true;
+}
+
+////////////////////////////////////// CONVERSÃO //////////////////////////////////////
+
+// data com no máximo 11 caracteres, sem depender de terminador vindo do produtor
+static string lerData(const char (&data)[12])
+{
+    return string(data, strnlen(data, sizeof(data)));
+}
+
+DataFrame loteShmParaDataFrame(const uint8_t* dados, size_t tamanho, string& origem)
+{
+    LoteShmCabecalho lote;
+    if (tamanho < sizeof(lote)) throw runtime_error("Lote em memória compartilhada truncado.");
+    memcpy(&lote, dados, sizeof(lote));
+
+    const uint8_t* linhas = dados + sizeof(lote);
+    const size_t bytesLinhas = tamanho - sizeof(lote);
+
+    switch (static_cast<OrigemShm>(lote.origem))
+    {
+        case OrigemShm::OMS:
+        {
+            if (bytesLinhas < lote.numLinhas * sizeof(LinhaOMSBin)) throw runtime_error("Lote OMS truncado.");
+            origem = "oms";
+            DataFrame df({"num_obitos", "populacao", "cep", "num_recuperados", "num_vacinados", "data"},
+                {ColumnType::INTEGER, ColumnType::INTEGER, ColumnType::INTEGER, ColumnType::INTEGER,
+                 ColumnType::INTEGER, ColumnType::STRING});
+            for (uint32_t i = 0; i < lote.numLinhas; ++i)
+            {
+                LinhaOMSBin l;
+                memcpy(&l, linhas + i * sizeof(l), sizeof(l));
+                df.addRow({l.num_obitos, l.populacao, l.cep, l.num_recuperados, l.num_vacinados, lerData(l.data)});
+            }
+            return df;
+        }
+        case OrigemShm::HOSPITAL:
+        {
+            if (bytesLinhas < lote.numLinhas * sizeof(LinhaHospitalBin)) throw runtime_error("Lote hospital truncado.");
+            origem = "hospital";
+            DataFrame df({"id_hospital", "data", "internado", "idade", "sexo", "cep",
+                          "sintoma1", "sintoma2", "sintoma3", "sintoma4"},
+                {ColumnType::INTEGER, ColumnType::STRING, ColumnType::INTEGER, ColumnType::INTEGER,
+                 ColumnType::INTEGER, ColumnType::INTEGER, ColumnType::INTEGER, ColumnType::INTEGER,
+                 ColumnType::INTEGER, ColumnType::INTEGER});
+            for (uint32_t i = 0; i < lote.numLinhas; ++i)
+            {
+                LinhaHospitalBin l;
+                memcpy(&l, linhas + i * sizeof(l), sizeof(l));
+                df.addRow({l.id_hospital, lerData(l.data), l.internado, l.idade, l.sexo, l.cep,
+                           l.sintoma1, l.sintoma2, l.sintoma3, l.sintoma4});
+            }
+            return df;
+        }
+        case OrigemShm::SECRETARIA:
+        {
+            if (bytesLinhas < lote.numLinhas * sizeof(LinhaSecretariaBin)) throw runtime_error("Lote secretaria truncado.");
+            origem = "secretaria";
+            DataFrame df({"diagnostico", "vacinado", "cep", "escolaridade", "populacao", "data"},
+                {ColumnType::INTEGER, ColumnType::INTEGER, ColumnType::INTEGER, ColumnType::INTEGER,
+                 ColumnType::INTEGER, ColumnType::STRING});
+            for (uint32_t i = 0; i < lote.numLinhas; ++i)
+            {
+                LinhaSecretariaBin l;
+                memcpy(&l, linhas + i * sizeof(l), sizeof(l));
+                df.addRow({l.diagnostico, l.vacinado, l.cep, l.escolaridade, l.populacao, lerData(l.data)});
+            }
+            return df;
+        }
+    }
+    throw runtime_error("Origem desconhecida no lote em memória compartilhada.");
+}
@@ -0,0 +1,150 @@
+#ifndef CANAL_SHM_HPP
+#define CANAL_SHM_HPP
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "../etl/dataframe.hpp"
+
+using namespace std;
+
+// Canal em memória compartilhada (shm_open + mmap) para produtores na mesma máquina do pipeline.
+// É um anel de slots de tamanho fixo (fila MPSC): vários produtores reservam slots com CAS
+// e um único consumidor (o pipeline) lê em ordem. Cada slot carrega um lote de linhas no
+// layout binário fixo abaixo, espelhando as mensagens Linha* do etl.proto.
+// O canal conta os produtores conectados e só fecha quando o último chama fechar() (ou é destruído);
+// todos os produtores devem se conectar antes que o primeiro feche.
+
+// Origem do lote (mesmos tipos do etl.proto)
+enum class OrigemShm : uint32_t {OMS = 1, HOSPITAL = 2, SECRETARIA = 3};
+
+// Linhas em layout binário fixo (campos na mesma ordem do etl.proto, data "dd-mm-aaaa")
+struct LinhaOMSBin {
+    int32_t num_obitos;
+    int32_t populacao;
+    int32_t cep;
+    int32_t num_recuperados;
+    int32_t num_vacinados;
+    char data[12];
+};
+
+struct LinhaHospitalBin {
+    int32_t id_hospital;
+    char data[12];
+    int32_t internado;
+    int32_t idade;
+    int32_t sexo;
+    int32_t cep;
+    int32_t sintoma1;
+    int32_t sintoma2;
+    int32_t sintoma3;
+    int32_t sintoma4;
+};
+
+struct LinhaSecretariaBin {
+    int32_t diagnostico;
+    int32_t vacinado;
+    int32_t cep;
+    int32_t escolaridade;
+    int32_t populacao;
+    char data[12];
+};
+
+// Cabeçalho de cada lote dentro de um slot, seguido de numLinhas linhas da origem
+struct LoteShmCabecalho {
+    uint32_t origem;
+    uint32_t numLinhas;
+    int64_t enviadoNs;   // steady_clock no envio, para medir a latência de entrega
+};
+
+// Cabeçalho do segmento compartilhado (início do mmap)
+struct CanalShmCabecalho {
+    uint32_t magico;
+    uint32_t numSlots;
+    uint32_t tamanhoSlot;
+    alignas(64) atomic<uint64_t> cabeca;           // próxima posição a reservar (produtores)
+    alignas(64) atomic<uint64_t> cauda;            // próxima posição a consumir (consumidor)
+    alignas(64) atomic<uint32_t> produtoresAtivos;
+    atomic<uint32_t> fechado;
+};
+
+// Configuração padrão do canal
+const uint32_t SHM_NUM_SLOTS = 64;
+const uint32_t SHM_TAMANHO_SLOT = 64 * 1024;
+
+// Base comum: mapeamento do segmento e acesso aos slots
+class CanalShm {
+public:
+    CanalShm(const CanalShm&) = delete;
+    CanalShm& operator=(const CanalShm&) = delete;
+
+protected:
+    CanalShm() = default;
+    ~CanalShm();
+
+    // cria (consumidor) ou abre (produtor) o segmento
+    void mapear(const string& nome, bool criar, uint32_t numSlots, uint32_t tamanhoSlot);
+
+    // sequência e área de dados de um slot
+    atomic<uint64_t>& sequenciaSlot(uint64_t pos);
+    uint32_t& tamanhoUsado(uint64_t pos);
+    uint8_t* dadosSlot(uint64_t pos);
+
+    // bytes úteis por slot
+    size_t capacidadeSlot() const;
+
+    string nome;
+    bool dono = false;
+    CanalShmCabecalho* cabecalho = nullptr;
+    uint8_t* base = nullptr;
+    size_t tamanhoTotal = 0;
+};
+
+// Biblioteca do produtor local: envia lotes de linhas para o pipeline
+class ProdutorShm : public CanalShm {
+public:
+    // conecta a um canal já criado pelo consumidor
+    explicit ProdutorShm(const string& nomeCanal);
+    ~ProdutorShm();
+
+    // quantas linhas de cada origem cabem em um lote
+    size_t linhasPorLote(OrigemShm origem) const;
+
+    // envia as linhas, dividindo em lotes; bloqueia enquanto o anel estiver cheio
+    void enviar(const vector<LinhaOMSBin>& linhas);
+    void enviar(const vector<LinhaHospitalBin>& linhas);
+    void enviar(const vector<LinhaSecretariaBin>& linhas);
+
+    // este produtor não envia mais lotes; o canal fecha quando o último produtor conectado fechar
+    void fechar();
+
+private:
+    bool fechou = false;
+
+    // copia um lote para um slot livre (reserva com CAS na cabeça)
+    void enviarLote(OrigemShm origem, const void* linhas, size_t numLinhas, size_t tamanhoLinha);
+};
+
+// Consumidor do pipeline: cria o canal e converte cada lote em DataFrame
+class ConsumidorShm : public CanalShm {
+public:
+    explicit ConsumidorShm(const string& nomeCanal,
+        uint32_t numSlots = SHM_NUM_SLOTS, uint32_t tamanhoSlot = SHM_TAMANHO_SLOT);
+    ~ConsumidorShm();
+
+    // espera o próximo lote; devolve false quando o canal foi fechado e esvaziado
+    bool receber(string& origem, DataFrame& df);
+
+    // instante de envio (steady_clock, ns) do último lote recebido
+    int64_t ultimoEnvioNs() const { return ultimoEnvio; }
+
+private:
+    int64_t ultimoEnvio = 0;
+};
+
+// Converte um lote no layout binário para DataFrame (mesmas colunas do carregamento em JSON)
+DataFrame loteShmParaDataFrame(const uint8_t* dados, size_t tamanho, string& origem);
+
+#endif
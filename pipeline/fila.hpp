@@ -0,0 +1,297 @@
+#ifndef FILA_HPP
+#define FILA_HPP
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+#include <new>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// Fila MPMC limitada e sem locks (anel de Vyukov) usada nas arestas entre estágios do pipeline.
+// Cada célula tem um número de sequência que diz se ela está livre para a posição de escrita
+// ou pronta para a posição de leitura; produtores e consumidores reservam posições com CAS.
+// Com a fila cheia empilhar() espera (backpressure: o estágio anterior desacelera em vez de a
+// memória crescer). fechar() encerra a entrada: empilhar() passa a devolver false e desempilhar()
+// entrega o que já foi empilhado e só então devolve false.
+
+// Política de espera bloqueante: gira um pouco e depois dorme numa condition_variable.
+// Indicada para itens pesados (DataFrames), em que a espera pode ser longa.
+class EsperaBloqueante
+{
+public:
+    template <typename Pronto>
+    void esperar(Pronto pronto)
+    {
+        for (int i = 0; i < GIROS; ++i)
+        {
+            if (pronto()) return;
+            this_thread::yield();
+        }
+
+        dormindo.fetch_add(1);
+        {
+            unique_lock<mutex> lock(mtx);
+            condVar.wait(lock, pronto);
+        }
+        dormindo.fetch_sub(1);
+    }
+
+    // acorda quem estiver dormindo; sem ninguém esperando não toca no mutex
+    void acordar()
+    {
+        atomic_thread_fence(memory_order_seq_cst);
+        if (dormindo.load() == 0) return;
+        {
+            lock_guard<mutex> lock(mtx);
+        }
+        condVar.notify_all();
+    }
+
+private:
+    static constexpr int GIROS = 64;
+    atomic<int> dormindo{0};
+    mutex mtx;
+    condition_variable condVar;
+};
+
+// Política de espera ativa: nunca dorme, só cede o núcleo entre tentativas.
+// Indicada para itens pequenos e estágios com núcleo dedicado (menor latência de entrega).
+class EsperaAtiva
+{
+public:
+    template <typename Pronto>
+    void esperar(Pronto pronto)
+    {
+        while (!pronto()) this_thread::yield();
+    }
+
+    void acordar() {}
+};
+
+template <typename T, typename Espera = EsperaBloqueante>
+class FilaLimitada
+{
+public:
+    explicit FilaLimitada(size_t capacidade) { alocar(capacidade); }
+
+    ~FilaLimitada() { liberar(); }
+
+    FilaLimitada(const FilaLimitada&) = delete;
+    FilaLimitada& operator=(const FilaLimitada&) = delete;
+
+    // tenta empilhar sem esperar; devolve false se a fila estiver cheia ou fechada
+    bool tentarEmpilhar(T&& valor)
+    {
+        if (fechada.load(memory_order_acquire)) return false;
+        if (!reservarEscrita(valor)) return false;
+        esperaConsumidores.acordar();
+        return true;
+    }
+
+    // empilha esperando espaço (backpressure); devolve false se a fila foi fechada
+    bool empilhar(T valor)
+    {
+        while (true)
+        {
+            if (fechada.load(memory_order_acquire)) return false;
+            if (reservarEscrita(valor))
+            {
+                esperaConsumidores.acordar();
+                return true;
+            }
+            esperaProdutores.esperar([this] {
+                return fechada.load(memory_order_acquire) || tamanho() < capacidade;
+            });
+        }
+    }
+
+    // tenta desempilhar sem esperar; devolve false se não houver item pronto
+    bool tentarDesempilhar(T& destino)
+    {
+        if (!reservarLeitura(destino)) return false;
+        esperaProdutores.acordar();
+        return true;
+    }
+
+    // espera o próximo item; devolve false quando a fila foi fechada e esvaziada
+    bool desempilhar(T& destino)
+    {
+        while (true)
+        {
+            if (reservarLeitura(destino))
+            {
+                esperaProdutores.acordar();
+                return true;
+            }
+            // fechada e sem posições reservadas por produtores: acabou
+            if (fechada.load(memory_order_acquire) && tamanho() == 0) return false;
+
+            esperaConsumidores.esperar([this] {
+                return tamanho() > 0 || fechada.load(memory_order_acquire);
+            });
+        }
+    }
+
+    // fim de stream: nenhum item novo é aceito, os já empilhados continuam disponíveis
+    void fechar()
+    {
+        fechada.store(true, memory_order_release);
+        esperaConsumidores.acordar();
+        esperaProdutores.acordar();
+    }
+
+    bool estaFechada() const { return fechada.load(memory_order_acquire); }
+
+    // número aproximado de itens (exato quando não há operações em andamento)
+    size_t tamanho() const
+    {
+        size_t escrita = posEscrita.load(memory_order_acquire);
+        size_t leitura = posLeitura.load(memory_order_acquire);
+        return escrita > leitura ? escrita - leitura : 0;
+    }
+
+    size_t getCapacidade() const { return capacidade; }
+
+    // maior número de itens observado desde a criação/reinício (high-water mark)
+    size_t picoTamanho() const { return pico.load(memory_order_relaxed); }
+
+    // descarta o conteúdo e reabre a fila; só pode ser chamada sem produtores/consumidores ativos
+    void reiniciar(size_t novaCapacidade)
+    {
+        liberar();
+        alocar(novaCapacidade);
+        fechada.store(false, memory_order_release);
+    }
+
+private:
+    struct Celula
+    {
+        atomic<size_t> sequencia;
+        alignas(T) unsigned char dados[sizeof(T)];
+
+        T* valor() { return reinterpret_cast<T*>(dados); }
+    };
+
+    void alocar(size_t capacidadeMinima)
+    {
+        // potência de 2 para trocar o módulo por máscara
+        capacidade = 1;
+        while (capacidade < capacidadeMinima) capacidade <<= 1;
+        mascara = capacidade - 1;
+
+        celulas.reset(new Celula[capacidade]);
+        for (size_t i = 0; i < capacidade; ++i)
+            celulas[i].sequencia.store(i, memory_order_relaxed);
+        posEscrita.store(0, memory_order_relaxed);
+        posLeitura.store(0, memory_order_relaxed);
+        pico.store(0, memory_order_relaxed);
+    }
+
+    void liberar()
+    {
+        if (!celulas) return;
+
+        // destrói os itens que ficaram na fila
+        size_t fim = posEscrita.load(memory_order_acquire);
+        for (size_t pos = posLeitura.load(memory_order_acquire); pos < fim; ++pos)
+        {
+            Celula& celula = celulas[pos & mascara];
+            if (celula.sequencia.load(memory_order_acquire) == pos + 1)
+                celula.valor()->~T();
+        }
+        celulas.reset();
+    }
+
+    // ocupação após escrever a posição fimEscrita - 1
+    void atualizarPico(size_t fimEscrita)
+    {
+        size_t leitura = posLeitura.load(memory_order_relaxed);
+        size_t ocupacao = fimEscrita > leitura ? fimEscrita - leitura : 0;
+        size_t atual = pico.load(memory_order_relaxed);
+        while (ocupacao > atual && !pico.compare_exchange_weak(atual, ocupacao, memory_order_relaxed)) {}
+    }
+
+    bool reservarEscrita(T& valor)
+    {
+        size_t pos = posEscrita.load(memory_order_relaxed);
+        while (true)
+        {
+            Celula& celula = celulas[pos & mascara];
+            size_t seq = celula.sequencia.load(memory_order_acquire);
+            intptr_t diferenca = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+            if (diferenca == 0)
+            {
+                // célula livre para esta posição: tenta reservar
+                if (posEscrita.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                {
+                    new (celula.dados) T(move(valor));
+                    celula.sequencia.store(pos + 1, memory_order_release);
+                    atualizarPico(pos + 1);
+                    return true;
+                }
+            }
+            else if (diferenca < 0)
+            {
+                // a célula ainda guarda um item de uma volta anterior: fila cheia
+                return false;
+            }
+            else
+            {
+                pos = posEscrita.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    bool reservarLeitura(T& destino)
+    {
+        size_t pos = posLeitura.load(memory_order_relaxed);
+        while (true)
+        {
+            Celula& celula = celulas[pos & mascara];
+            size_t seq = celula.sequencia.load(memory_order_acquire);
+            intptr_t diferenca = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+
+            if (diferenca == 0)
+            {
+                // item publicado nesta posição: tenta reservar a leitura
+                if (posLeitura.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                {
+                    destino = move(*celula.valor());
+                    celula.valor()->~T();
+                    celula.sequencia.store(pos + mascara + 1, memory_order_release);
+                    return true;
+                }
+            }
+            else if (diferenca < 0)
+            {
+                // vazia (ou item ainda sendo escrito)
+                return false;
+            }
+            else
+            {
+                pos = posLeitura.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    unique_ptr<Celula[]> celulas;
+    size_t capacidade = 0;
+    size_t mascara = 0;
+
+    alignas(64) atomic<size_t> posEscrita{0};
+    alignas(64) atomic<size_t> posLeitura{0};
+    alignas(64) atomic<bool> fechada{false};
+    atomic<size_t> pico{0};
+
+    Espera esperaProdutores;
+    Espera esperaConsumidores;
+};
+
+#endif // FILA_HPP
@@ -0,0 +1,80 @@
+#include "grafo.hpp"
+#include "../etl/trace.hpp"
+#include <thread>
+#include <iostream>
+#include <stdexcept>
+
+void GrafoEstagios::adicionar(const string& nome, int numWorkers, function<void(int)> corpo,
+    const vector<string>& antecessores, function<void()> fecharEntrada)
+{
+    if (indices.count(nome))
+        throw invalid_argument("Estágio repetido no grafo: " + nome);
+
+    auto estagio = make_unique<Estagio>();
+    estagio->nome = nome;
+    estagio->numWorkers = max(numWorkers, 1);
+    estagio->corpo = move(corpo);
+    estagio->fecharEntrada = move(fecharEntrada);
+    estagio->antecessoresPendentes = static_cast<int>(antecessores.size());
+
+    size_t indice = estagios.size();
+    for (const auto& antecessor : antecessores)
+    {
+        auto it = indices.find(antecessor);
+        if (it == indices.end())
+            throw invalid_argument("Antecessor desconhecido para " + nome + ": " + antecessor);
+        estagios[it->second]->sucessores.push_back(indice);
+    }
+
+    indices[nome] = indice;
+    estagios.push_back(move(estagio));
+}
+
+void GrafoEstagios::terminarWorker(Estagio& estagio)
+{
+    if (--estagio.workersAtivos != 0) return;
+
+    // último worker do estágio: fim de stream para os sucessores cujos antecessores acabaram
+    chrono::duration<double> decorrido = chrono::high_resolution_clock::now() - inicio;
+    estagio.fim = decorrido.count();
+    for (size_t s : estagio.sucessores)
+    {
+        Estagio& sucessor = *estagios[s];
+        if (--sucessor.antecessoresPendentes == 0 && sucessor.fecharEntrada)
+            sucessor.fecharEntrada();
+    }
+}
+
+void GrafoEstagios::executar()
+{
+    inicio = chrono::high_resolution_clock::now();
+
+    for (auto& estagio : estagios)
+        estagio->workersAtivos = estagio->numWorkers;
+
+    vector<thread> workers;
+    for (auto& estagio : estagios)
+    {
+        for (int i = 0; i < estagio->numWorkers; ++i)
+        {
+            workers.emplace_back([this, e = estagio.get(), id = i + 1] {
+                TRACE_NOMEAR_THREAD(e->nome + "-" + to_string(id));
+                try {
+                    TRACE_ESCOPO(Trace::internar(e->nome), "estagio");
+                    e->corpo(id);
+                } catch (const exception& ex) {
+                    cerr << "[Erro Estágio " << e->nome << " " << id << "] " << ex.what() << endl;
+                }
+                terminarWorker(*e);
+            });
+        }
+    }
+
+    for (auto& t : workers) t.join();
+}
+
+double GrafoEstagios::fimEstagio(const string& nome) const
+{
+    auto it = indices.find(nome);
+    return it == indices.end() ? 0.0 : estagios[it->second]->fim;
+}
@@ -0,0 +1,54 @@
+#ifndef GRAFO_HPP
+#define GRAFO_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+// Grafo (DAG) de estágios do pipeline. Cada estágio tem seus workers, que drenam a fila de entrada;
+// as arestas dizem quem alimenta quem. Todos os estágios começam juntos e, quando o último worker
+// de todos os antecessores de um estágio termina, a entrada dele é fechada (fim de stream).
+// Ramos independentes (ex.: tratamento e merge) rodam ao mesmo tempo.
+class GrafoEstagios
+{
+public:
+    // adiciona um estágio com numWorkers threads rodando corpo(id), id em 1..numWorkers.
+    // Os antecessores precisam já ter sido adicionados (ordem topológica); fecharEntrada é
+    // chamado uma vez, quando todos eles terminarem.
+    void adicionar(const string& nome, int numWorkers, function<void(int)> corpo,
+        const vector<string>& antecessores = {}, function<void()> fecharEntrada = nullptr);
+
+    // roda todos os estágios e espera o último worker terminar
+    void executar();
+
+    // segundos entre o início de executar() e o fim do último worker do estágio
+    double fimEstagio(const string& nome) const;
+
+private:
+    struct Estagio
+    {
+        string nome;
+        int numWorkers;
+        function<void(int)> corpo;
+        function<void()> fecharEntrada;
+        vector<size_t> sucessores;
+        atomic<int> antecessoresPendentes{0};
+        atomic<int> workersAtivos{0};
+        double fim = 0;
+    };
+
+    // chamado por cada worker ao sair do corpo
+    void terminarWorker(Estagio& estagio);
+
+    vector<unique_ptr<Estagio>> estagios;
+    map<string, size_t> indices;
+    chrono::time_point<chrono::high_resolution_clock> inicio;
+};
+
+#endif // GRAFO_HPP
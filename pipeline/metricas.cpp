@@ -0,0 +1,362 @@
+#include "metricas.hpp"
+#include "../json.hpp"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstdio>
+#include <iostream>
+
+using Json = nlohmann::json;
+
+int64_t relogioNs()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ---------------- Histograma ----------------
+
+int HistogramaLatencia::faixa(uint64_t valor)
+{
+    if (valor < NUM_SUB) return static_cast<int>(valor);
+
+    // expoente do bit mais alto e os BITS_SUB bits seguintes definem a faixa
+    int expoente = 63 - __builtin_clzll(valor);
+    int deslocamento = expoente - BITS_SUB;
+    int sub = static_cast<int>((valor >> deslocamento) & (NUM_SUB - 1));
+    return (deslocamento + 1) * NUM_SUB + sub;
+}
+
+uint64_t HistogramaLatencia::limiteSuperior(int f)
+{
+    if (f < NUM_SUB) return static_cast<uint64_t>(f);
+
+    int deslocamento = f / NUM_SUB - 1;
+    uint64_t sub = static_cast<uint64_t>(f % NUM_SUB);
+    // menor valor da próxima faixa menos 1
+    return (((NUM_SUB + sub + 1) << deslocamento) - 1);
+}
+
+void HistogramaLatencia::registrar(uint64_t valor)
+{
+    contagens[faixa(valor)].fetch_add(1, memory_order_relaxed);
+    total.fetch_add(1, memory_order_relaxed);
+    somaValores.fetch_add(valor, memory_order_relaxed);
+
+    uint64_t atual = maior.load(memory_order_relaxed);
+    while (valor > atual && !maior.compare_exchange_weak(atual, valor, memory_order_relaxed)) {}
+}
+
+void HistogramaLatencia::acumular(const HistogramaLatencia& outro)
+{
+    for (int f = 0; f < NUM_FAIXAS; ++f)
+        contagens[f].fetch_add(outro.contagens[f].load(memory_order_relaxed), memory_order_relaxed);
+    total.fetch_add(outro.contagem(), memory_order_relaxed);
+    somaValores.fetch_add(outro.soma(), memory_order_relaxed);
+    if (outro.maximo() > maximo()) maior.store(outro.maximo(), memory_order_relaxed);
+}
+
+uint64_t HistogramaLatencia::percentil(double p) const
+{
+    uint64_t n = contagem();
+    if (n == 0) return 0;
+
+    uint64_t alvo = static_cast<uint64_t>(p * n);
+    if (alvo >= n) alvo = n - 1;
+
+    uint64_t acumulado = 0;
+    for (int f = 0; f < NUM_FAIXAS; ++f)
+    {
+        acumulado += contagens[f].load(memory_order_relaxed);
+        if (acumulado > alvo) return min(limiteSuperior(f), maximo());
+    }
+    return maximo();
+}
+
+// ---------------- Workers e estágios ----------------
+
+void MetricasWorker::registrarItem(int64_t latenciaNs, size_t numLinhas, size_t numBytes)
+{
+    itens.fetch_add(1, memory_order_relaxed);
+    linhas.fetch_add(numLinhas, memory_order_relaxed);
+    bytes.fetch_add(numBytes, memory_order_relaxed);
+    ocupadoNs.fetch_add(static_cast<uint64_t>(max<int64_t>(latenciaNs, 0)), memory_order_relaxed);
+    latencias.registrar(static_cast<uint64_t>(max<int64_t>(latenciaNs, 0)));
+}
+
+void MetricasWorker::registrarEspera(int64_t ns)
+{
+    esperaNs.fetch_add(static_cast<uint64_t>(max<int64_t>(ns, 0)), memory_order_relaxed);
+}
+
+MetricasEstagio::MetricasEstagio(const string& nome, int numWorkers) : nome(nome)
+{
+    for (int i = 0; i < max(numWorkers, 1); ++i)
+        workers.push_back(make_unique<MetricasWorker>());
+}
+
+MetricasWorker& MetricasEstagio::worker(int id)
+{
+    if (id < 1 || id > static_cast<int>(workers.size()))
+        throw out_of_range("Worker inexistente no estágio " + nome + ": " + to_string(id));
+    return *workers[id - 1];
+}
+
+// ---------------- Registro ----------------
+
+MetricasEstagio& RegistroMetricas::adicionarEstagio(const string& nome, int numWorkers)
+{
+    auto& estagio = estagios[nome];
+    estagio = make_unique<MetricasEstagio>(nome, numWorkers);
+    return *estagio;
+}
+
+MetricasEstagio& RegistroMetricas::estagio(const string& nome)
+{
+    auto it = estagios.find(nome);
+    if (it == estagios.end())
+        throw out_of_range("Estágio sem métricas: " + nome);
+    return *it->second;
+}
+
+void RegistroMetricas::adicionarFila(const string& nome, size_t capacidade,
+    function<size_t()> tamanho, function<size_t()> pico)
+{
+    filas.push_back({nome, capacidade, move(tamanho), move(pico)});
+}
+
+void RegistroMetricas::limpar()
+{
+    estagios.clear();
+    filas.clear();
+    inicioNs = relogioNs();
+
+    lock_guard<mutex> lock(rejeicoesMtx);
+    rejeicoes.clear();
+    podadas.clear();
+}
+
+void RegistroMetricas::registrarRejeicoes(const string& fonte, const map<string, uint64_t>& porMotivo)
+{
+    lock_guard<mutex> lock(rejeicoesMtx);
+    for (const auto& [motivo, linhas] : porMotivo) rejeicoes[fonte][motivo] += linhas;
+}
+
+map<string, map<string, uint64_t>> RegistroMetricas::getRejeicoes() const
+{
+    lock_guard<mutex> lock(rejeicoesMtx);
+    return rejeicoes;
+}
+
+void RegistroMetricas::registrarPodadas(const string& fonte, const string& etapa, uint64_t linhas)
+{
+    if (linhas == 0) return;
+    lock_guard<mutex> lock(rejeicoesMtx);
+    podadas[fonte][etapa] += linhas;
+}
+
+map<string, map<string, uint64_t>> RegistroMetricas::getPodadas() const
+{
+    lock_guard<mutex> lock(rejeicoesMtx);
+    return podadas;
+}
+
+string RegistroMetricas::json() const
+{
+    Json saida;
+    saida["decorrido_s"] = (relogioNs() - inicioNs) / 1e9;
+
+    for (const auto& [nome, estagio] : estagios)
+    {
+        HistogramaLatencia latencias;
+        uint64_t itens = 0, linhas = 0, bytes = 0;
+        Json workers = Json::array();
+
+        for (const auto& w : estagio->getWorkers())
+        {
+            itens += w->itens.load(memory_order_relaxed);
+            linhas += w->linhas.load(memory_order_relaxed);
+            bytes += w->bytes.load(memory_order_relaxed);
+            latencias.acumular(w->latencias);
+            workers.push_back({
+                {"itens", w->itens.load(memory_order_relaxed)},
+                {"ocupado_s", w->ocupadoNs.load(memory_order_relaxed) / 1e9},
+                {"espera_s", w->esperaNs.load(memory_order_relaxed) / 1e9}
+            });
+        }
+
+        saida["estagios"][nome] = {
+            {"itens", itens},
+            {"linhas", linhas},
+            {"bytes", bytes},
+            {"latencia_ms", {
+                {"p50", latencias.percentil(0.50) / 1e6},
+                {"p90", latencias.percentil(0.90) / 1e6},
+                {"p99", latencias.percentil(0.99) / 1e6},
+                {"max", latencias.maximo() / 1e6},
+                {"media", latencias.contagem() ? latencias.soma() / 1e6 / latencias.contagem() : 0.0}
+            }},
+            {"workers", workers}
+        };
+    }
+
+    for (const auto& fila : filas)
+    {
+        saida["filas"][fila.nome] = {
+            {"capacidade", fila.capacidade},
+            {"tamanho", fila.tamanho()},
+            {"pico", fila.pico()}
+        };
+    }
+
+    for (const auto& [fonte, porMotivo] : getRejeicoes())
+        for (const auto& [motivo, linhas] : porMotivo)
+            saida["quarentena"][fonte][motivo] = linhas;
+
+    for (const auto& [fonte, porEtapa] : getPodadas())
+        for (const auto& [etapa, linhas] : porEtapa)
+            saida["poda"][fonte][etapa] = linhas;
+
+    return saida.dump(2);
+}
+
+string RegistroMetricas::prometheus() const
+{
+    ostringstream out;
+
+    // no formato texto as amostras de uma mesma métrica ficam juntas, depois do # TYPE
+    auto familia = [&](const string& metrica, const string& tipo, auto&& amostras) {
+        out << "# TYPE " << metrica << " " << tipo << "\n";
+        amostras();
+    };
+    auto porEstagio = [&](const string& metrica, auto&& valor) {
+        for (const auto& [nome, estagio] : estagios)
+            out << metrica << "{estagio=\"" << nome << "\"} " << valor(*estagio) << "\n";
+    };
+    auto porWorker = [&](const string& metrica, auto&& valor) {
+        for (const auto& [nome, estagio] : estagios)
+        {
+            int id = 1;
+            for (const auto& w : estagio->getWorkers())
+                out << metrica << "{estagio=\"" << nome << "\",worker=\"" << id++ << "\"} " << valor(*w) << "\n";
+        }
+    };
+    auto somar = [](const MetricasEstagio& estagio, atomic<uint64_t> MetricasWorker::* campo) {
+        uint64_t total = 0;
+        for (const auto& w : estagio.getWorkers()) total += ((*w).*campo).load(memory_order_relaxed);
+        return total;
+    };
+
+    familia("etl_estagio_itens_total", "counter", [&] {
+        porEstagio("etl_estagio_itens_total", [&](const MetricasEstagio& e) { return somar(e, &MetricasWorker::itens); });
+    });
+    familia("etl_estagio_linhas_total", "counter", [&] {
+        porEstagio("etl_estagio_linhas_total", [&](const MetricasEstagio& e) { return somar(e, &MetricasWorker::linhas); });
+    });
+    familia("etl_estagio_bytes_total", "counter", [&] {
+        porEstagio("etl_estagio_bytes_total", [&](const MetricasEstagio& e) { return somar(e, &MetricasWorker::bytes); });
+    });
+
+    familia("etl_estagio_latencia_segundos", "summary", [&] {
+        for (const auto& [nome, estagio] : estagios)
+        {
+            HistogramaLatencia latencias;
+            for (const auto& w : estagio->getWorkers()) latencias.acumular(w->latencias);
+
+            for (double q : {0.5, 0.9, 0.99})
+            {
+                out << "etl_estagio_latencia_segundos{estagio=\"" << nome << "\",quantile=\"" << q << "\"} "
+                    << latencias.percentil(q) / 1e9 << "\n";
+            }
+            out << "etl_estagio_latencia_segundos_sum{estagio=\"" << nome << "\"} " << latencias.soma() / 1e9 << "\n";
+            out << "etl_estagio_latencia_segundos_count{estagio=\"" << nome << "\"} " << latencias.contagem() << "\n";
+        }
+    });
+
+    familia("etl_worker_ocupado_segundos_total", "counter", [&] {
+        porWorker("etl_worker_ocupado_segundos_total", [](const MetricasWorker& w) { return w.ocupadoNs.load(memory_order_relaxed) / 1e9; });
+    });
+    familia("etl_worker_espera_segundos_total", "counter", [&] {
+        porWorker("etl_worker_espera_segundos_total", [](const MetricasWorker& w) { return w.esperaNs.load(memory_order_relaxed) / 1e9; });
+    });
+
+    familia("etl_fila_tamanho", "gauge", [&] {
+        for (const auto& fila : filas) out << "etl_fila_tamanho{fila=\"" << fila.nome << "\"} " << fila.tamanho() << "\n";
+    });
+    familia("etl_fila_pico", "gauge", [&] {
+        for (const auto& fila : filas) out << "etl_fila_pico{fila=\"" << fila.nome << "\"} " << fila.pico() << "\n";
+    });
+    familia("etl_fila_capacidade", "gauge", [&] {
+        for (const auto& fila : filas) out << "etl_fila_capacidade{fila=\"" << fila.nome << "\"} " << fila.capacidade << "\n";
+    });
+
+    familia("etl_quarentena_linhas_total", "counter", [&] {
+        for (const auto& [fonte, porMotivo] : getRejeicoes())
+            for (const auto& [motivo, linhas] : porMotivo)
+                out << "etl_quarentena_linhas_total{fonte=\"" << fonte << "\",motivo=\"" << motivo << "\"} " << linhas << "\n";
+    });
+    familia("etl_poda_linhas_total", "counter", [&] {
+        for (const auto& [fonte, porEtapa] : getPodadas())
+            for (const auto& [etapa, linhas] : porEtapa)
+                out << "etl_poda_linhas_total{fonte=\"" << fonte << "\",etapa=\"" << etapa << "\"} " << linhas << "\n";
+    });
+
+    return out.str();
+}
+
+void RegistroMetricas::salvar(const string& caminho) const
+{
+    auto terminaCom = [&](const string& sufixo) {
+        return caminho.size() >= sufixo.size() &&
+            caminho.compare(caminho.size() - sufixo.size(), sufixo.size(), sufixo) == 0;
+    };
+    const string conteudo = (terminaCom(".prom") || terminaCom(".txt")) ? prometheus() : json();
+
+    // grava num temporário e renomeia: quem lê o arquivo nunca vê um snapshot pela metade
+    const string temporario = caminho + ".tmp";
+    {
+        ofstream out(temporario);
+        if (!out.is_open())
+            throw runtime_error("Não foi possível abrir o arquivo de métricas: " + caminho);
+        out << conteudo;
+    }
+    rename(temporario.c_str(), caminho.c_str());
+}
+
+// ---------------- Exportador ----------------
+
+ExportadorMetricas::ExportadorMetricas(const RegistroMetricas& registro, const string& caminho, int intervaloMs)
+    : registro(registro), caminho(caminho)
+{
+    if (caminho.empty() || intervaloMs <= 0) return;
+
+    periodico = thread([this, intervaloMs] {
+        unique_lock<mutex> lock(mtx);
+        while (!condVar.wait_for(lock, chrono::milliseconds(intervaloMs), [this] { return parar; }))
+        {
+            try {
+                this->registro.salvar(this->caminho);
+            } catch (const exception& e) {
+                cerr << "[Métricas] " << e.what() << endl;
+            }
+        }
+    });
+}
+
+ExportadorMetricas::~ExportadorMetricas()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        parar = true;
+    }
+    condVar.notify_all();
+    if (periodico.joinable()) periodico.join();
+
+    if (caminho.empty()) return;
+    try {
+        registro.salvar(caminho);
+    } catch (const exception& e) {
+        cerr << "[Métricas] " << e.what() << endl;
+    }
+}
@@ -0,0 +1,150 @@
+#ifndef METRICAS_HPP
+#define METRICAS_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+using namespace std;
+
+// Métricas por estágio do pipeline: contadores por worker sem locks (cada worker só escreve no
+// próprio slot, leitores somam os slots no snapshot), histogramas de latência log-lineares (estilo
+// HDR) e profundidade/pico das filas. Os snapshots saem em JSON ou no formato texto do Prometheus.
+
+// relógio monotônico em nanossegundos
+int64_t relogioNs();
+
+// Histograma log-linear: 16 sub-faixas por potência de 2 (erro relativo < 6,25%), de 0 a 2^64 ns
+class HistogramaLatencia
+{
+public:
+    static constexpr int BITS_SUB = 4;
+    static constexpr int NUM_SUB = 1 << BITS_SUB;
+    static constexpr int NUM_FAIXAS = (64 - BITS_SUB + 1) * NUM_SUB;
+
+    void registrar(uint64_t valor);
+
+    // soma outro histograma neste (usado no snapshot, fora do caminho quente)
+    void acumular(const HistogramaLatencia& outro);
+
+    uint64_t contagem() const { return total.load(memory_order_relaxed); }
+    uint64_t soma() const { return somaValores.load(memory_order_relaxed); }
+    uint64_t maximo() const { return maior.load(memory_order_relaxed); }
+
+    // valor (limite superior da faixa) abaixo do qual está a fração p dos registros
+    uint64_t percentil(double p) const;
+
+private:
+    static int faixa(uint64_t valor);
+    static uint64_t limiteSuperior(int faixa);
+
+    atomic<uint64_t> contagens[NUM_FAIXAS] = {};
+    atomic<uint64_t> total{0};
+    atomic<uint64_t> somaValores{0};
+    atomic<uint64_t> maior{0};
+};
+
+// Contadores de um worker; só a thread dona escreve (operações relaxed, sem disputa de linha de cache)
+struct alignas(64) MetricasWorker
+{
+    atomic<uint64_t> itens{0};
+    atomic<uint64_t> linhas{0};
+    atomic<uint64_t> bytes{0};
+    atomic<uint64_t> ocupadoNs{0};   // processando itens
+    atomic<uint64_t> esperaNs{0};    // bloqueado esperando a fila de entrada (ou espaço na de saída)
+    HistogramaLatencia latencias;    // latência de processamento por item
+
+    // um item processado em latenciaNs
+    void registrarItem(int64_t latenciaNs, size_t numLinhas, size_t numBytes = 0);
+    void registrarEspera(int64_t ns);
+};
+
+// Métricas de um estágio: um slot por worker (id 1..numWorkers)
+class MetricasEstagio
+{
+public:
+    MetricasEstagio(const string& nome, int numWorkers);
+
+    MetricasWorker& worker(int id);
+
+    const string& getNome() const { return nome; }
+    const vector<unique_ptr<MetricasWorker>>& getWorkers() const { return workers; }
+
+private:
+    string nome;
+    vector<unique_ptr<MetricasWorker>> workers;
+};
+
+// Registro das métricas de uma execução. Estágios e filas são cadastrados antes dos workers
+// começarem; durante a execução só há leituras do registro e escritas nos slots dos workers.
+class RegistroMetricas
+{
+public:
+    MetricasEstagio& adicionarEstagio(const string& nome, int numWorkers);
+    MetricasEstagio& estagio(const string& nome);
+
+    // fila observada pelo snapshot (tamanho atual e pico desde o início)
+    void adicionarFila(const string& nome, size_t capacidade, function<size_t()> tamanho, function<size_t()> pico);
+
+    // descarta estágios, filas e rejeições (antes de uma nova execução)
+    void limpar();
+
+    // linhas mandadas à quarentena por fonte e código de motivo; somadas uma vez por DataFrame (nunca por
+    // linha), então o lock não fica no caminho quente
+    void registrarRejeicoes(const string& fonte, const map<string, uint64_t>& porMotivo);
+    map<string, map<string, uint64_t>> getRejeicoes() const;
+
+    // linhas podadas por fonte e etapa ("bloom" na extração, "exata" nos tratadores); também por DataFrame
+    void registrarPodadas(const string& fonte, const string& etapa, uint64_t linhas);
+    map<string, map<string, uint64_t>> getPodadas() const;
+
+    string json() const;
+    string prometheus() const;
+
+    // grava o snapshot; o formato vem da extensão (.prom/.txt para Prometheus, senão JSON)
+    void salvar(const string& caminho) const;
+
+private:
+    struct FilaObservada {
+        string nome;
+        size_t capacidade;
+        function<size_t()> tamanho;
+        function<size_t()> pico;
+    };
+
+    map<string, unique_ptr<MetricasEstagio>> estagios;
+    vector<FilaObservada> filas;
+    int64_t inicioNs = relogioNs();
+
+    map<string, map<string, uint64_t>> rejeicoes;   // fonte -> motivo -> linhas
+    map<string, map<string, uint64_t>> podadas;     // fonte -> etapa -> linhas
+    mutable mutex rejeicoesMtx;                     // protege rejeições e podadas
+};
+
+// Grava snapshots periódicos durante a execução (intervaloMs > 0) e um snapshot final na destruição
+class ExportadorMetricas
+{
+public:
+    ExportadorMetricas(const RegistroMetricas& registro, const string& caminho, int intervaloMs);
+    ~ExportadorMetricas();
+
+    ExportadorMetricas(const ExportadorMetricas&) = delete;
+    ExportadorMetricas& operator=(const ExportadorMetricas&) = delete;
+
+private:
+    const RegistroMetricas& registro;
+    string caminho;
+    bool parar = false;
+    mutex mtx;
+    condition_variable condVar;
+    thread periodico;
+};
+
+#endif // METRICAS_HPP
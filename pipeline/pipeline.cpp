@@ -2,175 +2,428 @@
 #include "../etl/extrator.hpp"
 #include "../etl/loader.hpp"
 #include "../etl/handlers.hpp"
+#include "canal_shm.hpp"
+#include "fila.hpp"
+#include "grafo.hpp"
+#include "metricas.hpp"
+#include "autoescala.hpp"
+#include "../etl/trace.hpp"
+#include "../etl/topologia.hpp"
+#include "../etl/executor.hpp"
 #include <iostream>
-#include <queue>
 #include <mutex>
-#include <condition_variable>
 #include <thread>
 #include <atomic>
 #include <vector>
 #include <ostream>
+#include <istream>
+#include <map>
+#include <unordered_map>
 
 #include <functional> // Para std::ref
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <stdexcept>
 
 using namespace std;
 
 
-// Fila compartilhada entre fila de arquivos (produtor) e extrator (consumidor)
-queue<string> filaArquivos;
-mutex filaMutex;
-condition_variable condVar;
-atomic<bool> encerrado(false);
+Pipeline::Pipeline(ConfigPipeline config)
+    : config(config),
+      esquemas(EsquemaValidacao::carregarDiretorio(config.diretorioRegras)),
+      filaArquivos(config.capacidadeFilaArquivos),
+      extratorTratadorFila(config.capacidadeFilaExtraidos),
+      extratMergeFila(config.capacidadeFilaExtraidos),
+      tratadorLoaderFila(config.capacidadeFilaLoader)
+{
+}
+
+const EsquemaValidacao* Pipeline::esquemaDe(const string& origem) const
+{
+    for (const auto& esquema : esquemas)
+        if (origem.find(esquema.getFonte()) != string::npos) return &esquema;
+    return nullptr;
+}
+
+// fonte de uma origem (arquivo ou nome do lote) sem diretório e extensão
+static string nomeFonte(const string& origem)
+{
+    return filesystem::path(origem).stem().string();
+}
+
+void Pipeline::prepararSaida()
+{
+    filesystem::create_directories(config.diretorioSaida);
 
-// Fila compartilhada entre extrator(produtor) e tratador(consumidor)
-queue<pair<string, DataFrame>> extratorTratadorFila;
-mutex extTratMutex;
-condition_variable extTratcondVar;
-atomic<bool> extTratencerrado(false);
+    // quarentena é acrescentada durante a execução: começa sem os arquivos da anterior
+    error_code erro;
+    for (const auto& entrada : filesystem::directory_iterator(config.diretorioSaida, erro))
+    {
+        const string nome = entrada.path().filename().string();
+        if (nome.rfind("quarentena_", 0) == 0 && entrada.path().extension() == ".csv")
+            filesystem::remove(entrada.path(), erro);
+    }
+}
 
-// Fila compartilhada entre handler (produtor) e loader (consumidor)
-queue<LoaderItem> tratadorLoaderFila;
-mutex tratLoadMutex;
-condition_variable tratLoadCondVar;
-atomic<bool> tratadorEncerrado(false);
+void Pipeline::entregarQuarentena(const string& origem, Quarentena& quarentena, int id)
+{
+    if (quarentena.empty()) return;
+    const string fonte = nomeFonte(origem);
+    metricas.registrarRejeicoes(fonte, quarentena.contagens());
+    tratadorLoaderFila.empilhar(LoaderItem{quarentena.retirar(), "quarentena_" + fonte + ".csv", id, true});
+}
 
-// variáveis para a pipeline de merge
-queue<DataFrame> extratMergeFila;
-mutex mergeMtx;
-condition_variable condVarMerge;
-condition_variable extTratcondVarMerge;
-condition_variable tratLoadCondVarMerge;
+void Pipeline::guardarQuarentena(const string& origem, Quarentena& quarentena)
+{
+    if (quarentena.empty()) return;
+    const string fonte = nomeFonte(origem);
+    metricas.registrarRejeicoes(fonte, quarentena.contagens());
 
-atomic<bool> encerradoMerge(false);
+    lock_guard<mutex> lock(quarentenaMtx);
+    quarentenasLotes[fonte].acumular(move(quarentena));
+}
 
-// PRODUTOR: adiciona arquivos à fila
-void produtor(const vector<string>& arquivos, bool merge) {
-    for (const auto& arquivo : arquivos) {
-        {
-            lock_guard<mutex> lock(filaMutex);
-            filaArquivos.push(arquivo);
+DeduplicacaoEntreLotes& Pipeline::deduplicacaoDe(const string& origem)
+{
+    lock_guard<mutex> lock(deduplicacaoMtx);
+    auto& deduplicacao = deduplicacaoLotes[nomeFonte(origem)];
+    if (!deduplicacao) deduplicacao = make_unique<DeduplicacaoEntreLotes>();
+    return *deduplicacao;
+}
+
+// resumo da quarentena, da poda e das repetidas entre lotes junto da análise de tempo (só quando houve alguma)
+void Pipeline::exibirQuarentena() const
+{
+    for (const auto& [fonte, porMotivo] : metricas.getRejeicoes())
+    {
+        cout << "Quarentena " << fonte << ":";
+        for (const auto& [motivo, linhas] : porMotivo) cout << " " << motivo << "=" << linhas;
+        cout << " (" << config.diretorioSaida << "/quarentena_" << fonte << ".csv)" << endl;
+    }
+    for (const auto& [fonte, porEtapa] : metricas.getPodadas())
+    {
+        cout << "Poda por ilha " << fonte << ":";
+        for (const auto& [etapa, linhas] : porEtapa) cout << " " << etapa << "=" << linhas;
+        cout << endl;
+    }
+    for (const auto& [fonte, deduplicacao] : deduplicacaoLotes)
+    {
+        if (deduplicacao->repetidas() > 0)
+            cout << "Repetidas entre lotes " << fonte << ": " << deduplicacao->repetidas() << endl;
+    }
+}
+
+// desempilha contabilizando o tempo que o worker ficou parado esperando a fila
+template <typename T>
+static bool desempilharMedindo(FilaLimitada<T>& fila, T& destino, MetricasWorker& metricas)
+{
+    TRACE_ESCOPO("espera_entrada", "fila");
+    int64_t inicio = relogioNs();
+    bool ok = fila.desempilhar(destino);
+    metricas.registrarEspera(relogioNs() - inicio);
+    return ok;
+}
+
+// empilha contabilizando o tempo bloqueado por backpressure
+template <typename T>
+static void empilharMedindo(FilaLimitada<T>& fila, T valor, MetricasWorker& metricas)
+{
+    TRACE_ESCOPO("espera_saida", "fila");
+    int64_t inicio = relogioNs();
+    fila.empilhar(move(valor));
+    metricas.registrarEspera(relogioNs() - inicio);
+}
+
+// tamanho em bytes de um arquivo (0 se não existir)
+static size_t tamanhoArquivo(const string& caminho)
+{
+    error_code erro;
+    auto tamanho = filesystem::file_size(caminho, erro);
+    return erro ? 0 : static_cast<size_t>(tamanho);
+}
+
+// Grava a linha do tempo (Chrome trace_event) da execução quando há um arquivo configurado
+class SessaoTrace
+{
+public:
+    explicit SessaoTrace(const string& caminho) : caminho(caminho)
+    {
+        if (caminho.empty()) return;
+#ifdef ETL_TRACE
+        Trace::ativar();
+#else
+        cerr << "[Trace] instrumentação desligada na compilação (use make TRACE=1)" << endl;
+#endif
+    }
+
+    ~SessaoTrace()
+    {
+#ifdef ETL_TRACE
+        if (caminho.empty()) return;
+        Trace::desativar();
+        try {
+            Trace::salvar(caminho);
+        } catch (const exception& e) {
+            cerr << "[Trace] " << e.what() << endl;
         }
+#endif
+    }
+
+private:
+    string caminho;
+};
+
+// cadastra as filas da instância no registro de métricas
+void Pipeline::observarFilas()
+{
+    metricas.adicionarFila("arquivos", filaArquivos.getCapacidade(),
+        [this] { return filaArquivos.tamanho(); }, [this] { return filaArquivos.picoTamanho(); });
+    metricas.adicionarFila("extraidos", extratorTratadorFila.getCapacidade(),
+        [this] { return extratorTratadorFila.tamanho(); }, [this] { return extratorTratadorFila.picoTamanho(); });
+    metricas.adicionarFila("merge", extratMergeFila.getCapacidade(),
+        [this] { return extratMergeFila.tamanho(); }, [this] { return extratMergeFila.picoTamanho(); });
+    metricas.adicionarFila("loader", tratadorLoaderFila.getCapacidade(),
+        [this] { return tratadorLoaderFila.tamanho(); }, [this] { return tratadorLoaderFila.picoTamanho(); });
+}
+
+bool Pipeline::temVaga(const string& estagio, int id)
+{
+    auto it = vagas.find(estagio);
+    return it == vagas.end() || it->second->aguardar(id);
+}
+
+// índice de cada estágio na escolha do domínio L3
+enum IndiceEstagio { ESTAGIO_EXTRACAO, ESTAGIO_TRATAMENTO, ESTAGIO_MERGE, ESTAGIO_LOADER };
+
+void Pipeline::posicionarWorker(int estagio, int id)
+{
+    const Topologia& topologia = Topologia::sistema();
+    if (!config.fixarCpus || !topologia.valeFixar()) return;
+
+    if (!Topologia::fixarThreadAtual(topologia.cpusDominio(topologia.dominioWorker(estagio, id))))
+        cerr << "[Topologia] não foi possível fixar o worker " << id << " do estágio " << estagio << endl;
+}
 
-        // Avisa os consumidores
-        if (merge){condVarMerge.notify_one();}
-        else{condVar.notify_one();}
+// Leva a thread para o domínio do estágio no socket indicado e a devolve ao seu lugar no fim do escopo
+class MudancaSocket
+{
+public:
+    MudancaSocket(int socket, int estagio, int id) : estagio(estagio), id(id)
+    {
+        const Topologia& topologia = Topologia::sistema();
+        if (socket < 0 || socket == topologia.socketAtual()) return;
+
+        const vector<int>& doSocket = topologia.dominiosSocket(socket);
+        mudou = Topologia::fixarThreadAtual(topologia.cpusDominio(doSocket[estagio % doSocket.size()]));
+    }
+
+    ~MudancaSocket()
+    {
+        if (!mudou) return;
+        const Topologia& topologia = Topologia::sistema();
+        Topologia::fixarThreadAtual(topologia.cpusDominio(topologia.dominioWorker(estagio, id)));
+    }
+
+private:
+    int estagio;
+    int id;
+    bool mudou = false;
+};
+
+// PRODUTOR: adiciona arquivos à fila (o grafo fecha a fila quando o produtor termina)
+void Pipeline::produtor(const vector<string>& arquivos) {
+    for (const auto& arquivo : arquivos) {
+        filaArquivos.empilhar(arquivo);
     }
+}
+
+// versão de um arquivo para o cache das dimensões (vazia se não der para ler os atributos)
+static string versaoArquivo(const string& arquivo)
+{
+    error_code erro;
+    const auto data = filesystem::last_write_time(arquivo, erro);
+    if (erro) return "";
+    const auto tamanho = filesystem::file_size(arquivo, erro);
+    if (erro) return "";
+    return arquivo + "|" + to_string(data.time_since_epoch().count()) + "|" + to_string(tamanho);
+}
+
+// publica o agregado de uma fonte para o ramo de merge (só a primeira publicação vale). Se o arquivo não
+// mudou desde a execução anterior, a tabela de junção dela é reaproveitada sem agregar nem construir de novo
+void Pipeline::publicarDimensao(Dimensao& dimensao, const string& arquivo, const function<DataFrame()>& agregar,
+    int numThreads)
+{
+    lock_guard<mutex> lock(dimensao.cacheMtx);
+    if (dimensao.publicada.load()) return;
 
-    // Sinaliza fim
+    const string versao = versaoArquivo(arquivo);
+    if (versao.empty() || versao != dimensao.versao || !dimensao.tabela)
     {
-        lock_guard<mutex> lock(filaMutex);
-        encerrado = true;
+        Handler handler;
+        dimensao.tabela = make_shared<const TabelaJuncao>(handler.islandDimension(agregar(), "cep", numThreads));
+        dimensao.versao = versao;
     }
-    if (merge){condVarMerge.notify_all();}
-        else{condVar.notify_all();}
+
+    dimensao.publicada = true;
+    dimensao.promessa.set_value(dimensao.tabela);
+}
+
+// fonte que não chegou vira erro para quem espera por ela (merge e poda do hospital)
+void Pipeline::fecharDimensao(Dimensao& dimensao)
+{
+    lock_guard<mutex> lock(dimensao.cacheMtx);
+    if (!dimensao.publicada.exchange(true))
+        dimensao.promessa.set_exception(make_exception_ptr(runtime_error("fonte do merge não foi extraída")));
+}
+
+// fim da extração: nenhuma dimensão fica pendente
+void Pipeline::fecharDimensoes()
+{
+    for (Dimensao* dimensao : {&dimOms, &dimSecretaria}) fecharDimensao(*dimensao);
+}
+
+Pipeline::Dimensao* Pipeline::dimensaoDoArquivo(const string& arquivo)
+{
+    if (arquivo.find("oms") != string::npos) return &dimOms;
+    if (arquivo.find("secretaria") != string::npos) return &dimSecretaria;
+    return nullptr;
 }
 
 // CONSUMIDOR: consome da fila e processa
-void consumidorExtrator(int id, bool merge) {
+// Cada arquivo é extraído uma única vez; OMS e secretaria também alimentam o ramo de merge
+void Pipeline::consumidorExtrator(int id, int numThreads) {
     Extrator extrator;
+    Handler handler;
+    MetricasWorker& m = metricas.estagio("extracao").worker(id);
 
-    while (true) {
-        string arquivo;
+    string arquivo;
+    while (temVaga("extracao", id) && desempilharMedindo(filaArquivos, arquivo, m)) {
+        TRACE_ESCOPO("extrair", "item");
+        int64_t inicio = relogioNs();
 
-        {
-            // esperando ter aruivos para extrair
-            unique_lock<mutex> lock(filaMutex);
-            if (merge)
+        // se a fonte alimenta o merge e não publicar, quem espera por ela é liberado já (sem esperar o fim
+        // da extração, o que travaria o hospital esperando pela poda)
+        Dimensao* dimensao = dimensaoDoArquivo(arquivo);
+        try {
+            // poda por ilha: o hospital espera as dimensões e só lê as linhas das ilhas que estão nelas
+            vector<shared_ptr<const TabelaJuncao>> dimensoesPoda;
+            if (config.podarPorIlha && arquivo.find("hospital") != string::npos)
             {
-                condVarMerge.wait(lock, [] {
-                    return !filaArquivos.empty() || encerrado;
-                });
+                try {
+                    dimensoesPoda = {dimOms.valor.get(), dimSecretaria.valor.get()};
+                    extrator.definirPoda(handler.islandPruning("cep", dimensoesPoda));
+                } catch (const exception&) {
+                    dimensoesPoda.clear();   // sem as dimensões não há contra o que podar
+                }
             }
-            else
+
+            // extrai os arquivos 
+            DataFrame df = extrator.carregar(arquivo);
+
+            // filtro na leitura e, nos tratadores, a conferência exata dos falsos positivos do Bloom
+            if (!dimensoesPoda.empty())
             {
-                condVar.wait(lock, [] {
-                    return !filaArquivos.empty() || encerrado;
-                });
+                extrator.definirPoda(PodaExtracao());
+                metricas.registrarPodadas(nomeFonte(arquivo), "bloom", extrator.retirarPodadas());
+                metricas.registrarPodadas(nomeFonte(arquivo), "exata",
+                    handler.pruneByIslands(df, "cep", dimensoesPoda, numThreads));
             }
 
-            if (filaArquivos.empty() && encerrado)
-                break;
+            // linhas que a extração descartou (tamanho ou tipo)
+            Quarentena rejeitadas = extrator.retirarQuarentena();
+            entregarQuarentena(arquivo, rejeitadas, id);
 
-            if (!filaArquivos.empty()) {
-                arquivo = filaArquivos.front();
-                filaArquivos.pop();
+            // lembra onde o DataFrame foi alocado para tratá-lo no mesmo socket
+            if (config.fixarCpus && Topologia::sistema().numSockets() > 1)
+            {
+                lock_guard<mutex> lock(socketExtracaoMtx);
+                socketExtracao[arquivo] = Topologia::sistema().socketAtual();
             }
-        }
-
-        try {
-            // extrai os arquivos 
-            DataFrame df = extrator.carregar(arquivo);
 
             if (df.empty()) {
                 cerr << "[Consumidor " << id << "] DataFrame VAZIO após extração de " << arquivo << endl;
+                if (dimensao) fecharDimensao(*dimensao);
                 continue;
             } else if (df.getColumnNames().size() != static_cast<size_t>(df.numCols()))
             {
                 cerr << "[Consumidor " << id << "] Inconsistência no DataFrame: " << arquivo << endl;
+                if (dimensao) fecharDimensao(*dimensao);
                 continue;
             }
-            if (merge)
+
+            // agregados usados no merge, calculados sobre a extração bruta antes do tratamento
+            if (dimensao == &dimOms)
             {
-                unique_lock<mutex> lock(extTratMutex);
-                extratMergeFila.push(move(df));
+                publicarDimensao(dimOms, arquivo, [&] { return handler.groupedDf(df, "cep", "num_obitos", numThreads, false); },
+                    numThreads);
             }
-            else
+            else if (dimensao == &dimSecretaria)
             {
-                unique_lock<mutex> lock(extTratMutex);
-                extratorTratadorFila.push({arquivo, move(df)});
+                publicarDimensao(dimSecretaria, arquivo, [&] { return handler.groupedDf(df, "cep", "vacinado", numThreads, true); },
+                    numThreads);
             }
-            // avisa os tratadores
-            extTratcondVar.notify_one();
+
+            m.registrarItem(relogioNs() - inicio, df.size(), tamanhoArquivo(arquivo));
+
+            // espera espaço se os tratadores estiverem atrasados
+            empilharMedindo(extratorTratadorFila, {arquivo, move(df)}, m);
 
         } catch (const exception& e) {
             cerr << "[Erro Consumidor " << id << "] ao processar " << arquivo << ": " << e.what() << endl;
+            extrator.retirarQuarentena();
+            extrator.definirPoda(PodaExtracao());
+            extrator.retirarPodadas();
+            if (dimensao) fecharDimensao(*dimensao);
         }
     }
 }
 
 // CONSUMIDOR TRATADOR: consome da fila extraída e joga para o tratador
-void consumidorTrat(int id, string meanCol, string groupedCol, string aggCol,  int numThreads) 
+void Pipeline::consumidorTrat(int id, string meanCol, string groupedCol, string aggCol,  int numThreads) 
 {
     // int count = 0;
+    MetricasWorker& m = metricas.estagio("tratamento").worker(id);
+
+    pair<string, DataFrame> item("hospital", DataFrame({"ID"}, {}));
 
-    while (true) {
+    while (temVaga("tratamento", id) && desempilharMedindo(extratorTratadorFila, item, m)) {
         // df dummy só para inicializar o objeto
         DataFrame dfExtraido({"ID"}, {});
         DataFrame grouping({"ID"}, {});
 
-        pair<string, DataFrame> item("hospital", DataFrame({"ID"}, {}));
-
-        {
-            // espera ter arquivos extraídos
-            unique_lock<mutex> lock(extTratMutex);
-            extTratcondVar.wait(lock, [] {
-                return !extratorTratadorFila.empty() || extTratencerrado;
-            });
-
-            if (extratorTratadorFila.empty() && extTratencerrado)
-                break;
-
-            if (!extratorTratadorFila.empty()) {
-                item = extratorTratadorFila.front();
-                extratorTratadorFila.pop();
-            } else {
-                continue;
-            }
-        }
-
         // extrai a origem para conseguir fazer tratar diferente arquivos
         string origem = item.first;
-        dfExtraido = item.second;
+        dfExtraido = move(item.second);
 
         Handler handler;
 
-        auto startCall = chrono::high_resolution_clock::now();
+        // trata no socket em que o DataFrame foi extraído (sem efeito sem fixarCpus)
+        int socketOrigem = -1;
+        if (config.fixarCpus)
+        {
+            lock_guard<mutex> lock(socketExtracaoMtx);
+            auto it = socketExtracao.find(origem);
+            if (it != socketExtracao.end()) socketOrigem = it->second;
+        }
+        MudancaSocket mudanca(socketOrigem, ESTAGIO_TRATAMENTO, id);
+
+        TRACE_ESCOPO("tratar", "item");
+        const size_t linhasEntrada = dfExtraido.size();
+        int64_t startCall = relogioNs();
+        Quarentena rejeitadas;
+
+        try {
             
             // se for hospital agrupa
             if (origem.find("hospital") != string::npos) 
             {
                 handler.dataCleaner(dfExtraido);
-                handler.validateDataFrame(dfExtraido, numThreads);
+                handler.validateDataFrame(dfExtraido, esquemaDe(origem), numThreads, &rejeitadas);
+
+                // ramo de merge: reaproveita o hospital já limpo e validado, agregado por ilha
+                extratMergeFila.empilhar(handler.groupedDf(dfExtraido, "cep", aggCol, numThreads, true));
+
                 grouping = handler.groupedDf(dfExtraido, groupedCol, aggCol, numThreads, false);
                 
                 LoaderItem l_item{
@@ -180,17 +433,37 @@ void consumidorTrat(int id, string meanCol, string groupedCol, string aggCol,  i
                     "saida_tratada_hospital.csv", id
             };
             // coloca na fila do loader o df tratado
-            {
-                lock_guard<mutex> lock(tratLoadMutex);
-                tratadorLoaderFila.push(move(l_item));
+            tratadorLoaderFila.empilhar(move(l_item));
+
+            // estatísticas por hospital e CEP (uma passada a mais pelo hospital tratado), só com as colunas que
+            // a limpeza manteve; uma falha aqui perde só este arquivo
+            try {
+                vector<Agregacao> agregacoes = {
+                    {TipoAgregacao::CONTAGEM, "*", "Registros"},
+                    {TipoAgregacao::SOMA, aggCol, ""},
+                    {TipoAgregacao::MEDIA, aggCol, ""}
+                };
+                if (dfExtraido.colIdx("idade") != static_cast<size_t>(-1))
+                {
+                    for (TipoAgregacao tipo : {TipoAgregacao::MEDIA, TipoAgregacao::DESVIO_PADRAO, TipoAgregacao::MINIMO, TipoAgregacao::MAXIMO})
+                        agregacoes.push_back({tipo, "idade", ""});
+                }
+                if (dfExtraido.colIdx("data") != static_cast<size_t>(-1))
+                {
+                    agregacoes.push_back({TipoAgregacao::PRIMEIRO, "data", ""});
+                    agregacoes.push_back({TipoAgregacao::ULTIMO, "data", ""});
+                }
+                DataFrame estatisticas = handler.groupBy(dfExtraido, {groupedCol, "cep"}, agregacoes, numThreads);
+                tratadorLoaderFila.empilhar(LoaderItem{move(estatisticas), "saida_estatisticas_hospital.csv", id});
+            } catch (const exception& e) {
+                cerr << "[Tratador " << id << "] estatísticas do hospital não geradas: " << e.what() << endl;
             }
-            tratLoadCondVar.notify_one();
         }
         // se é oms então agrupa e faz média
         else if (origem.find("oms") != string::npos) 
         {
             handler.dataCleaner(dfExtraido);
-            handler.validateDataFrame(dfExtraido, numThreads);
+            handler.validateDataFrame(dfExtraido, esquemaDe(origem), numThreads, &rejeitadas);
             grouping = handler.groupedDf(dfExtraido, "cep", meanCol, numThreads, false);
             handler.meanAlert(grouping, "Total_" + meanCol, numThreads);
             LoaderItem l_item{
@@ -202,16 +475,12 @@ void consumidorTrat(int id, string meanCol, string groupedCol, string aggCol,  i
             };
 
             // adiciona na fila do loader
-            {
-                lock_guard<mutex> lock(tratLoadMutex);
-                tratadorLoaderFila.push(move(l_item));
-            }
-            tratLoadCondVar.notify_one();
+            tratadorLoaderFila.empilhar(move(l_item));
         }
         else if (origem.find("secretaria") != string::npos) 
         {
             handler.dataCleaner(dfExtraido);
-            handler.validateDataFrame(dfExtraido, numThreads);
+            handler.validateDataFrame(dfExtraido, esquemaDe(origem), numThreads, &rejeitadas);
             grouping = handler.groupedDf(dfExtraido, "cep", "vacinado", numThreads, true);
 
             LoaderItem l_item{
@@ -221,11 +490,7 @@ void consumidorTrat(int id, string meanCol, string groupedCol, string aggCol,  i
                 id
             };
 
-            {
-                lock_guard<mutex> lock(tratLoadMutex);
-                tratadorLoaderFila.push(move(l_item));
-            }
-            tratLoadCondVar.notify_one();
+            tratadorLoaderFila.empilhar(move(l_item));
         }
 
 
@@ -235,57 +500,42 @@ void consumidorTrat(int id, string meanCol, string groupedCol, string aggCol,  i
             continue;
         }
 
-        auto endCall = chrono::high_resolution_clock::now();
-        chrono::duration<double> durFunc = endCall - startCall;        
+        // linhas reprovadas na validação
+        entregarQuarentena(origem, rejeitadas, id);
+        } catch (const exception& e) {
+            cerr << "[Erro Tratador " << id << "] ao processar " << origem << ": " << e.what() << endl;
+            continue;
+        }
+
+        // latência de tratamento do item (limpeza, validação, agregação e entrega ao loader)
+        m.registrarItem(relogioNs() - startCall, linhasEntrada);
     }
+
 }
 
-// consome fazendo o merge
-void consumidorMerge(int id, DataFrame& dfB, DataFrame& dfC, const string& cepColName,
-    const string& colA, const string& colB, const string& colC, int numThreads) 
+// consome fazendo o merge: hospital agregado por ilha com os agregados de OMS e secretaria
+void Pipeline::consumidorMerge(int id, const string& cepColName, const string& colB, const string& colC, int numThreads) 
 {
     Handler handler;
     
-    while (true) {
-        // df dummy só para inicializar o objeto
-        DataFrame dfExtraido({"ID"}, {});
-        
-        {
-            // espera ter arquivos para tratar
-            unique_lock<mutex> lock(mergeMtx);
-            extTratcondVarMerge.wait(lock, [] {
-                return !extratMergeFila.empty() || extTratencerrado;
-            });
-            
-            if (extratMergeFila.empty() && extTratencerrado)
-            break;
-            
-            if (!extratMergeFila.empty()) {
-                dfExtraido = extratMergeFila.front();
-                extratMergeFila.pop();
-            } else {
-                continue;
-            }
-        }
+    // df dummy só para inicializar o objeto
+    DataFrame hospIlha({"ID"}, {});
 
+    MetricasWorker& m = metricas.estagio("merge").worker(id);
 
+    while (temVaga("merge", id) && desempilharMedindo(extratMergeFila, hospIlha, m)) {
+        TRACE_ESCOPO("merge", "item");
+        int64_t inicio = relogioNs();
         try {
-            // processando o dataframe extraído;
-            auto startCall = chrono::high_resolution_clock::now();
-            handler.dataCleaner(dfExtraido);
-            handler.validateDataFrame(dfExtraido, numThreads);
-            dfExtraido =  handler.groupedDf(dfExtraido, cepColName, colA, numThreads, true);
-            
-            // fazendo cópia pois o merge modifica inplace
-            DataFrame copyB = dfB;
-            DataFrame copyC = dfC;
+            // espera as extrações de OMS e secretaria (ramo independente do tratamento); as tabelas são
+            // só lidas, então todos os workers usam as mesmas, sem cópia
+            shared_ptr<const TabelaJuncao> dimB = dimOms.valor.get();
+            shared_ptr<const TabelaJuncao> dimC = dimSecretaria.valor.get();
 
-            auto merged = handler.mergeByCEP(dfExtraido, copyB, copyC, cepColName, colB, colC, numThreads); 
-            auto endCall = chrono::high_resolution_clock::now();
-            chrono::duration<double> durFunc = endCall - startCall;
+            auto merged = handler.mergeByCEP(hospIlha, *dimB, *dimC, cepColName, colB, colC, numThreads);
             int count = 0;
             
-            for (const auto& [nome, dfMerge] : merged) 
+            for (auto& [nome, dfMerge] : merged) 
             {
                 LoaderItem item{
                 std::move(dfMerge),
@@ -293,12 +543,9 @@ void consumidorMerge(int id, DataFrame& dfB, DataFrame& dfC, const string& cepCo
                 id
                 };
                 // colocando na fila do loader
-                {
-                lock_guard<mutex> lock(mergeMtx);
-                tratadorLoaderFila.push(move(item));
-                }
-                tratLoadCondVarMerge.notify_one();
+                tratadorLoaderFila.empilhar(move(item));
             }
+            m.registrarItem(relogioNs() - inicio, hospIlha.size());
 
         } catch (const exception& e) {
             cerr << "[Erro Consumidor " << id << "] ao processar " << e.what() << endl;
@@ -309,44 +556,26 @@ void consumidorMerge(int id, DataFrame& dfB, DataFrame& dfC, const string& cepCo
 
 
 // CONSUMIDOR LOADER: consome da fila tratada e joga para o loader
-void consumidorLoader(int id, bool merge) {
-    while (true) {
-        LoaderItem item = [&] {
-            unique_lock<mutex> lock(tratLoadMutex);
+void Pipeline::consumidorLoader(int id) {
+    LoaderItem item{DataFrame({"ID"}, {}), "", -1};
+    MetricasWorker& m = metricas.estagio("loader").worker(id);
+    TRACE_NOMEAR_THREAD("loader-" + to_string(id));
 
-            // se for loarder de merge olha para a condição de merge
-            if (merge)
+    while (temVaga("loader", id) && desempilharMedindo(tratadorLoaderFila, item, m)) {
+        TRACE_ESCOPO("gravar", "item");
+        int64_t inicio = relogioNs();
+        try {
+            const string caminho = config.diretorioSaida + "/" + item.nomeArquivoOriginal;
+            if (item.acrescentar)
             {
-                tratLoadCondVarMerge.wait(lock, [] {
-                    return !tratadorLoaderFila.empty() || tratadorEncerrado;
-                });
+                lock_guard<mutex> lock(quarentenaMtx);
+                save_as_csv(item.df, caminho, true);
             }
             else
             {
-                tratLoadCondVar.wait(lock, [] {
-                    return !tratadorLoaderFila.empty() || tratadorEncerrado;
-                });
-            }
-
-            if (tratadorLoaderFila.empty() && tratadorEncerrado)
-                return LoaderItem{DataFrame({"ID"}, {}), "", -1};
-
-            if (!tratadorLoaderFila.empty()) {
-                LoaderItem i = move(tratadorLoaderFila.front());
-                tratadorLoaderFila.pop();
-                return i;
+                save_as_csv(item.df, caminho);
             }
-
-            // fallback
-            return LoaderItem{DataFrame({"ID"}, {ColumnType::INTEGER}), "", -1};
-        }();
-
-        // checa se é um item "falso" (fim do loop)
-        if (item.nomeArquivoOriginal == "" && item.threadId == -1)
-            break;
-
-        try {
-            save_as_csv(item.df, "database_loader/" + item.nomeArquivoOriginal);
+            m.registrarItem(relogioNs() - inicio, item.df.size(), tamanhoArquivo(caminho));
             if (item.df.empty()) {
                 cerr << "[Loader " << id << "] AVISO: DataFrame salvo está VAZIO!\n";
             } else {  }
@@ -357,210 +586,466 @@ void consumidorLoader(int id, bool merge) {
     }
 }
 
-// Função que orquestra o pipeline
-void executarPipeline(int numConsumidores, const string& arquivoOmsJson, const string& arquivoSecretariaJson, const string& arquivoHospitalJson) 
+// Função que orquestra o pipeline como um grafo de estágios:
+//   produtor -> extração -> tratamento -> loader
+//                  |            |
+//                  +---------> merge -----^
+// Cada fonte é extraída uma vez; o merge roda junto com o tratamento e não espera os loaders.
+void Pipeline::executar(const string& arquivoOmsJson, const string& arquivoSecretariaJson, const string& arquivoHospitalJson) 
 {
-    // Reinicia estados globais (caso a função seja chamada várias vezes)
-    encerrado = false;
-    extTratencerrado = false;
-    tratadorEncerrado = false;
+    const int numThreads = threadsKernel();
+    prepararSaida();
 
-    // entre fila e extrator
+    // Reinicia o estado da instância (caso seja executada várias vezes)
+    filaArquivos.reiniciar(config.capacidadeFilaArquivos);
+    extratorTratadorFila.reiniciar(config.capacidadeFilaExtraidos);
+    extratMergeFila.reiniciar(config.capacidadeFilaExtraidos);
+    tratadorLoaderFila.reiniciar(config.capacidadeFilaLoader);
+    for (Dimensao* dimensao : {&dimOms, &dimSecretaria})
     {
-        lock_guard<mutex> lock(filaMutex);
-        queue<string> empty;
-        swap(filaArquivos, empty);
+        // a tabela e a versão ficam: são o cache para a próxima execução
+        dimensao->promessa = promise<shared_ptr<const TabelaJuncao>>();
+        dimensao->valor = dimensao->promessa.get_future().share();
+        dimensao->publicada = false;
     }
-    // entre extrator e tratador
+
+    // workers iniciais de cada estágio
+    map<string, int> iniciais = {
+        {"extracao", workers(config.workersExtracao)},
+        {"tratamento", workers(config.workersTratamento)},
+        {"merge", workers(config.workersMerge)},
+        {"loader", workers(config.workersLoader)}
+    };
+
+    // com autoescala cada estágio sobe threads até o que o orçamento permite (os outros estágios
+    // ficam com ao menos um worker); as que passam do limite atual ficam paradas sem vaga
+    map<string, int> numWorkers = iniciais;
+    int orcamento = config.orcamentoNucleos > 0 ? config.orcamentoNucleos
+                                                : static_cast<int>(max(1u, thread::hardware_concurrency()));
+    orcamento = max(orcamento, static_cast<int>(iniciais.size()));
+    if (config.autoescala)
     {
-        lock_guard<mutex> lock(extTratMutex);
-        queue<pair<string, DataFrame>> empty;
-        swap(extratorTratadorFila, empty);
+        for (auto& [nome, n] : numWorkers)
+            n = max(n, orcamento - static_cast<int>(iniciais.size()) + 1);
     }
 
-    // entre tratador e loader
+    metricas.limpar();
+    for (const auto& [nome, n] : numWorkers)
+        metricas.adicionarEstagio(nome, n);
+    observarFilas();
+
+    // afinidade: pool dos tratadores distribuído pelos domínios L3 e workers presos ao domínio do estágio
+    socketExtracao.clear();
+    if (config.fixarCpus)
     {
-        lock_guard<mutex> lock(tratLoadMutex);
-        queue<LoaderItem> empty;
-        swap(tratadorLoaderFila, empty);
-    }  
+        const Topologia& topologia = Topologia::sistema();
+        if (topologia.valeFixar())
+            Executor::global().fixarNaTopologia(topologia);
+        else
+            cerr << "[Topologia] " << topologia.descrever() << ": workers sem afinidade fixa" << endl;
+    }
+
+    vagas.clear();
+    unique_ptr<ControladorWorkers> controlador;
+    if (config.autoescala)
+    {
+        controlador = make_unique<ControladorWorkers>(orcamento, config.intervaloAutoescalaMs);
+        auto cadastrar = [&](const string& nome, auto& filaEntrada) {
+            vagas[nome] = &controlador->adicionarEstagio(nome, iniciais[nome], 1, numWorkers[nome],
+                metricas.estagio(nome),
+                [&filaEntrada] { return filaEntrada.tamanho(); },
+                [&filaEntrada] { return filaEntrada.estaFechada(); });
+        };
+        cadastrar("extracao", filaArquivos);
+        cadastrar("tratamento", extratorTratadorFila);
+        cadastrar("merge", extratMergeFila);
+        cadastrar("loader", tratadorLoaderFila);
+    }
 
     // arquivos
     vector<string> arquivos = {arquivoOmsJson, arquivoHospitalJson, arquivoSecretariaJson};
+    // com poda o hospital espera OMS e secretaria: elas saem antes na fila, então já foram pegas por outro worker
+    if (config.podarPorIlha) arquivos = {arquivoOmsJson, arquivoSecretariaJson, arquivoHospitalJson};
+
+    GrafoEstagios grafo;
+    grafo.adicionar("produtor", 1, [&](int) { produtor(arquivos); });
+
+    grafo.adicionar("extracao", numWorkers["extracao"], [&](int id) {
+        posicionarWorker(ESTAGIO_EXTRACAO, id);
+        consumidorExtrator(id, numThreads);
+    },
+        {"produtor"}, [this] { filaArquivos.fechar(); });
+
+    grafo.adicionar("tratamento", numWorkers["tratamento"],
+        [&](int id) {
+            posicionarWorker(ESTAGIO_TRATAMENTO, id);
+            consumidorTrat(id, "num_obitos", "id_hospital", "internado", numThreads);
+        },
+        {"extracao"}, [this] {
+            extratorTratadorFila.fechar();
+            fecharDimensoes();
+        });
+
+    grafo.adicionar("merge", numWorkers["merge"],
+        [&](int id) {
+            posicionarWorker(ESTAGIO_MERGE, id);
+            consumidorMerge(id, "cep", "Total_num_obitos", "Total_vacinado", numThreads);
+        },
+        {"tratamento"}, [this] { extratMergeFila.fechar(); });
+
+    grafo.adicionar("loader", numWorkers["loader"], [this](int id) {
+        posicionarWorker(ESTAGIO_LOADER, id);
+        consumidorLoader(id);
+    },
+        {"tratamento", "merge"}, [this] { tratadorLoaderFila.fechar(); });
 
     // Variáveis para medição de tempo
-    chrono::time_point<chrono::high_resolution_clock> start, end;
-    chrono::duration<double> tempoTotal, tempoExtracao, tempoTratamento, tempoLoader;
-    
-    // Início do pipeline
-    start = chrono::high_resolution_clock::now();
+    auto start = chrono::high_resolution_clock::now();
+    {
+        // snapshots periódicos durante a execução e um final ao terminar
+        ExportadorMetricas exportador(metricas, config.arquivoMetricas, config.intervaloMetricasMs);
+        SessaoTrace trace(config.arquivoTrace);
+        if (controlador) controlador->iniciar();
+        grafo.executar();
+        if (controlador) controlador->parar();
+    }
+    chrono::duration<double> tempoTotal = chrono::high_resolution_clock::now() - start;
 
-    // ---- Estágio 1: Extração ----
-    auto startExtracao = chrono::high_resolution_clock::now();
-    
-    // Cria produtor e inializa-o
-    thread prod(produtor, arquivos, false);
+    // tempo até cada estágio terminar, contado a partir do início (os estágios se sobrepõem)
+    tempos.extracao = grafo.fimEstagio("extracao");
+    tempos.tratamento = grafo.fimEstagio("tratamento");
+    tempos.merge = grafo.fimEstagio("merge");
+    tempos.loader = grafo.fimEstagio("loader");
+    tempos.total = tempoTotal.count();
+
+    if (!config.exibirTempos) return;
     
-    // Cria consumidores do extrator
-    vector<thread> consumidoresExtrator;
-    for (int i = 0; i < numConsumidores; ++i) {
-        consumidoresExtrator.emplace_back(consumidorExtrator, i + 1, false);
+    // ---- Exibição dos tempos ----
+    cout << "\n=== Análise de Tempo por Estágio (fim de cada estágio desde o início) ===" << endl;
+    cout << "1. Extração:    " << tempos.extracao << " segundos" << endl;
+    cout << "2. Tratamento: " << tempos.tratamento << " segundos" << endl;
+    cout << "3. Merge:      " << tempos.merge << " segundos" << endl;
+    cout << "4. Loader:      " << tempos.loader << " segundos" << endl;
+    cout << "---------------------------------" << endl;
+
+
+    cout << "Tempo Total da pipeline:   " << tempos.total << " segundos\n" << endl;
+    exibirQuarentena();
+
+    if (controlador)
+    {
+        cout << "Autoescala (orçamento " << orcamento << ", " << controlador->getAjustes() << " ajustes), workers ao final:";
+        for (const auto& e : controlador->getEstagios())
+            cout << " " << e->getNome() << "=" << e->getLimite();
+        cout << "\n" << endl;
     }
-    // Aguarda o produtor
-    prod.join();
-    
-    // Aguarda extratores
-    for (auto& t : consumidoresExtrator) t.join();
-    
-    end = chrono::high_resolution_clock::now();
-    tempoExtracao = end - startExtracao;
-    
-    // ---- Estágio 2: Tratamento ----
-    auto startTratamento = chrono::high_resolution_clock::now();
-    
-    // Sinaliza que extração terminou e notifica tratadores
+    vagas.clear();
+}
+
+// soma os totais de um groupedDf parcial (um lote) no acumulador da saída
+void Pipeline::acumularParcial(const string& saida, const DataFrame& parcial)
+{
+    const auto& nomes = parcial.getColumnNames();
+
+    lock_guard<mutex> lock(agregadosMtx);
+    AgregadoParcial& acumulado = agregadosStream[saida];
+    acumulado.colGrupo = nomes[0];
+    acumulado.colTotal = nomes[1];
+    for (const auto& row : parcial.getLinhas())
     {
-        lock_guard<mutex> lock(extTratMutex);
-        extTratencerrado = true;
+        acumulado.totais[toString(row[0])] += toDouble(row[1]);
     }
-    extTratcondVar.notify_all();
-    
-    // Cria consumidores dos tratadores
-    vector<thread> consumidoresTratador;
-    for (int i = 0; i < numConsumidores; ++i) 
+}
+
+// transforma o acumulado de uma saída de volta em DataFrame (mesmo formato do groupedDf)
+DataFrame Pipeline::materializarParcial(const AgregadoParcial& acumulado)
+{
+    DataFrame df({acumulado.colGrupo, acumulado.colTotal}, {ColumnType::STRING, ColumnType::DOUBLE});
+    for (const auto& [chave, total] : acumulado.totais)
     {
-        consumidoresTratador.emplace_back(consumidorTrat, i + 1, "num_obitos", "id_hospital", "internado", numConsumidores);
+        df.addRow({chave, total});
     }
+    return df;
+}
 
-    // Aguarda tratadores
-    for (auto& t : consumidoresTratador) t.join();
-    
-    end = chrono::high_resolution_clock::now();
-    tempoTratamento = end - startTratamento;
-    
-    // ---- Estágio 3: Loader ----
-    auto startLoader = chrono::high_resolution_clock::now();
-    
-    // Sinaliza fim do tratamento e notifica loaders
+// PRODUTOR DE LOTES: puxa lotes da fonte e coloca na fila do tratador assim que chegam
+void Pipeline::produtorLotes(FonteLotes proximoLote)
+{
+    int numLote = 0;
+    MetricasWorker& m = metricas.estagio("ingestao").worker(1);
+    TRACE_NOMEAR_THREAD("ingestao");
+
+    while (true)
     {
-        lock_guard<mutex> lock(tratLoadMutex);
-        tratadorEncerrado = true;
+        pair<string, DataFrame> item("", DataFrame({"ID"}, {}));
+        ++numLote;
+
+        // inclui a espera pelo remetente: um produtor lento aparece como latência de ingestão
+        int64_t inicio = relogioNs();
+        try {
+            TRACE_ESCOPO("receber_lote", "item");
+            if (!proximoLote(item)) break;
+        } catch (const exception& e) {
+            cerr << "[Erro Stream] ao processar lote " << numLote << ": " << e.what() << endl;
+            continue;
+        }
+        m.registrarItem(relogioNs() - inicio, item.second.size());
+
+        if (item.second.empty()) continue;
+
+        // controle de fluxo: com a fila cheia a fonte deixa de ser lida,
+        // o pipe/canal do remetente enche e o cliente fica retido até os tratadores liberarem espaço
+        empilharMedindo(extratorTratadorFila, move(item), m);
     }
-    tratLoadCondVar.notify_all();
-    
-    // Cria consumidores finais (loader)
-    vector<thread> consumidoresLoader;
-    for (int i = 0; i < numConsumidores; ++i) {
-        consumidoresLoader.emplace_back(consumidorLoader, i + 1, false);
+
+    // sinaliza fim da entrada
+    extratorTratadorFila.fechar();
+}
+
+// CONSUMIDOR TRATADOR DE STREAM: trata cada lote e acumula os agregados parciais
+void Pipeline::consumidorTratStream(int id, int numThreads)
+{
+    Handler handler;
+    MetricasWorker& m = metricas.estagio("tratamento").worker(id);
+    TRACE_NOMEAR_THREAD("tratamento-" + to_string(id));
+
+    pair<string, DataFrame> item("", DataFrame({"ID"}, {}));
+
+    // a deduplicação entre lotes já cobre as repetidas dentro do lote
+    ConfigLimpeza limpeza;
+    limpeza.removerDuplicatas = false;
+
+    while (desempilharMedindo(extratorTratadorFila, item, m)) {
+        const string& origem = item.first;
+        DataFrame& dfLote = item.second;
+        TRACE_ESCOPO("tratar_lote", "item");
+        const size_t linhasLote = dfLote.size();
+        int64_t inicio = relogioNs();
+
+        try {
+            // lote só com linhas já vistas: nada a tratar
+            if (deduplicacaoDe(origem).removerRepetidas(dfLote, numThreads) == linhasLote)
+            {
+                m.registrarItem(relogioNs() - inicio, linhasLote);
+                continue;
+            }
+
+            Quarentena rejeitadas;
+            handler.dataCleaner(dfLote, limpeza, numThreads);
+            handler.validateDataFrame(dfLote, esquemaDe(origem), numThreads, &rejeitadas);
+            guardarQuarentena(origem, rejeitadas);
+
+            if (origem.find("hospital") != string::npos)
+            {
+                acumularParcial("saida_tratada_hospital.csv",
+                    handler.groupedDf(dfLote, "id_hospital", "internado", numThreads, false));
+                // agregado por ilha usado no merge
+                acumularParcial("merge_hospital",
+                    handler.groupedDf(dfLote, "cep", "internado", numThreads, true));
+            }
+            else if (origem.find("oms") != string::npos)
+            {
+                acumularParcial("saida_tratada_oms.csv",
+                    handler.groupedDf(dfLote, "cep", "num_obitos", numThreads, false));
+            }
+            else if (origem.find("secretaria") != string::npos)
+            {
+                acumularParcial("saida_tratada_secretaria.csv",
+                    handler.groupedDf(dfLote, "cep", "vacinado", numThreads, true));
+            }
+            else
+            {
+                cerr << "[Tratador " << id << "] Origem desconhecida: " << origem << endl;
+            }
+        } catch (const exception& e) {
+            cerr << "[Erro Tratador " << id << "] ao processar lote de " << origem << ": " << e.what() << endl;
+        }
+        m.registrarItem(relogioNs() - inicio, linhasLote);
     }
-    // Aguarda loaders
-    for (auto& t : consumidoresLoader) t.join();
-    end = chrono::high_resolution_clock::now();
-    tempoLoader = end - startLoader;
-    
-    //inicia pipeline do merge
-    
-    // Reinicia estados globais
-    encerrado = false;
-    extTratencerrado = false;
-    tratadorEncerrado = false;  
-    
-    // entre fila e extrator (Merge)
+}
+
+// Orquestra o pipeline alimentado por lotes: os lotes são tratados enquanto chegam
+void Pipeline::executarLotes(FonteLotes proximoLote, const string& nomeFonte)
+{
+    const int numThreads = threadsKernel();
+    const int numTratadores = workers(config.workersTratamento);
+    const int numLoaders = workers(config.workersLoader);
+    prepararSaida();
+    vagas.clear();
+
+    // Reinicia o estado da instância (a fila de lotes é menor: segura o remetente mais cedo)
+    extratorTratadorFila.reiniciar(config.capacidadeLotesStream);
+    tratadorLoaderFila.reiniciar(config.capacidadeFilaLoader);
     {
-        lock_guard<mutex> lock(filaMutex);
-        queue<string> empty;
-        swap(filaArquivos, empty);
+        lock_guard<mutex> lock(agregadosMtx);
+        agregadosStream.clear();
     }
-    // entre extrator e tratador (Merge)
     {
-        lock_guard<mutex> lock(extTratMutex);
-        queue<DataFrame> empty;
-        swap(extratMergeFila, empty);
+        lock_guard<mutex> lock(quarentenaMtx);
+        quarentenasLotes.clear();
     }
-    // entre tratador e loader (Merge)
     {
-        lock_guard<mutex> lock(tratLoadMutex);
-        queue<LoaderItem> empty;
-        swap(tratadorLoaderFila, empty);
-    }  
-    
-    // arquivos variados para o merge
-    vector<string> arquivoMerge = {arquivoHospitalJson};
-    Extrator extra;
+        lock_guard<mutex> lock(deduplicacaoMtx);
+        deduplicacaoLotes.clear();
+    }
+
+    metricas.limpar();
+    metricas.adicionarEstagio("ingestao", 1);
+    metricas.adicionarEstagio("tratamento", numTratadores);
+    metricas.adicionarEstagio("loader", numLoaders);
+    observarFilas();
+    ExportadorMetricas exportador(metricas, config.arquivoMetricas, config.intervaloMetricasMs);
+    SessaoTrace trace(config.arquivoTrace);
+
+    auto start = chrono::high_resolution_clock::now();
+
+    // ---- Estágio 1 e 2: ingestão e tratamento concorrentes ----
+    thread prod(&Pipeline::produtorLotes, this, move(proximoLote));
+
+    vector<thread> consumidoresTratador;
+    for (int i = 0; i < numTratadores; ++i)
+    {
+        consumidoresTratador.emplace_back(&Pipeline::consumidorTratStream, this, i + 1, numThreads);
+    }
+
+    prod.join();
+    for (auto& t : consumidoresTratador) t.join();
+
+    auto end = chrono::high_resolution_clock::now();
+    chrono::duration<double> tempoIngestao = end - start;
+
+    // ---- Finalização dos agregados (os totais só ficam completos no fim do stream) ----
     Handler handler;
+    vector<LoaderItem> itens;
 
-    // arquivos fixos para o merge
-    DataFrame oms = extra.carregar(arquivoOmsJson);
-    // oms.display();
-    DataFrame oms_agrup = handler.groupedDf(oms, "cep" , "num_obitos", 4, false);
-    
-    DataFrame ss = extra.carregar(arquivoSecretariaJson);
-    DataFrame ss_agrup = handler.groupedDf(ss, "cep" , "vacinado", 4, true);
+    auto temSaida = [this](const string& saida) { return agregadosStream.count(saida) > 0; };
 
-    auto startmerge = chrono::high_resolution_clock::now();
-    // Cria produtor e inializa-o
-    thread prodMerge(produtor, arquivoMerge, true);
-    
-    // Cria consumidores do extrator
-    vector<thread> consumidoresExtratorMerge;
-    for (int i = 0; i < numConsumidores; ++i) 
+    if (temSaida("saida_tratada_hospital.csv"))
     {
-        consumidoresExtratorMerge.emplace_back(consumidorExtrator, i + 1, true);
+        itens.push_back({materializarParcial(agregadosStream["saida_tratada_hospital.csv"]), "saida_tratada_hospital.csv", 0});
     }
-    // Aguarda o produtor
-    prodMerge.join();
-    
-    // Aguarda extratores
-    for (auto& t : consumidoresExtratorMerge) t.join();
-    
-    // Sinaliza que extração terminou e notifica tratadores (Merge)
+    if (temSaida("saida_tratada_oms.csv"))
     {
-        lock_guard<mutex> lock(extTratMutex);
-        extTratencerrado = true;
+        DataFrame omsAlerta = materializarParcial(agregadosStream["saida_tratada_oms.csv"]);
+        handler.meanAlert(omsAlerta, "Total_num_obitos", numThreads);
+        itens.push_back({move(omsAlerta), "saida_tratada_oms.csv", 0});
+    }
+    if (temSaida("saida_tratada_secretaria.csv"))
+    {
+        itens.push_back({materializarParcial(agregadosStream["saida_tratada_secretaria.csv"]), "saida_tratada_secretaria.csv", 0});
     }
-    extTratcondVarMerge.notify_all();
 
-    // Cria consumidores dos tratadores
-    vector<thread> consumidoresTratadorMerge;
-    for (int i = 0; i < numConsumidores; ++i) 
+    // merge por ilha com os totais de OMS e secretaria
+    if (temSaida("merge_hospital") && temSaida("saida_tratada_oms.csv") && temSaida("saida_tratada_secretaria.csv"))
     {
-        consumidoresTratadorMerge.emplace_back(consumidorMerge, i + 1, ref(oms_agrup), 
-        ref(ss_agrup), "cep","internado", "num_obitos", "Total_Vacinado", numConsumidores);
+        DataFrame hospIlha = materializarParcial(agregadosStream["merge_hospital"]);
+        DataFrame omsTotais = materializarParcial(agregadosStream["saida_tratada_oms.csv"]);
+        DataFrame ssTotais = materializarParcial(agregadosStream["saida_tratada_secretaria.csv"]);
+
+        try {
+            auto merged = handler.mergeByCEP(hospIlha, omsTotais, ssTotais, "cep",
+                "Total_num_obitos", "Total_vacinado", numThreads);
+            int count = 0;
+            for (auto& [nome, dfMerge] : merged)
+            {
+                itens.push_back({move(dfMerge), "saida_merge_" + to_string(count++) + to_string(numThreads) + ".csv", 0});
+            }
+        } catch (const exception& e) {
+            cerr << "[Erro Merge Stream] " << e.what() << endl;
+        }
     }
-    
-    // Aguarda tratadores
-    for (auto& t : consumidoresTratadorMerge) t.join();
-    
+
+    // linhas rejeitadas ao longo do stream, uma saída por fonte
+    for (auto& [fonte, quarentena] : quarentenasLotes)
     {
-        lock_guard<mutex> lock(tratLoadMutex);
-        tratadorEncerrado = true;
+        itens.push_back({quarentena.retirar(), "quarentena_" + fonte + ".csv", 0});
     }
-    tratLoadCondVarMerge.notify_all();
-    
-    vector<thread> consumidoresLoaderMerge;
-    for (int i = 0; i < numConsumidores; ++i) {
-        consumidoresLoaderMerge.emplace_back(consumidorLoader, i + 1, true);
+
+    // ---- Estágio 3: Loader ----
+    vector<thread> consumidoresLoader;
+    for (int i = 0; i < numLoaders; ++i) {
+        consumidoresLoader.emplace_back(&Pipeline::consumidorLoader, this, i + 1);
     }
-    
-    // Aguarda loaders
-    for (auto& t : consumidoresLoaderMerge) t.join();
-    
+    for (auto& item : itens) tratadorLoaderFila.empilhar(move(item));
+    tratadorLoaderFila.fechar();
+    for (auto& t : consumidoresLoader) t.join();
+
     end = chrono::high_resolution_clock::now();
-    chrono::duration<double> tempomerge;
-    tempomerge = end - startmerge;
-    
-    
-    // Tempo total
-    // tempoTotal = end - start;
-    
-    // ---- Exibição dos tempos ----
-    cout << "\n=== Análise de Tempo por Estágio ===" << endl;
-    cout << "1. Extração:    " << tempoExtracao.count() << " segundos" << endl;
-    cout << "2. Tratamento: " << tempoTratamento.count() << " segundos" << endl;
-    cout << "3. Loader:      " << tempoLoader.count() << " segundos" << endl;
-    cout << "4. Merge:      " << tempomerge.count() << " segundos" << endl;
-    cout << "---------------------------------" << endl;
+    chrono::duration<double> tempoTotal = end - start;
 
+    tempos = TemposPipeline();
+    tempos.tratamento = tempoIngestao.count();
+    tempos.total = tempoTotal.count();
 
+    if (!config.exibirTempos) return;
+
+    cout << "\n=== Análise de Tempo (" << nomeFonte << ") ===" << endl;
+    cout << "1. Ingestão + Tratamento: " << tempoIngestao.count() << " segundos" << endl;
+    cout << "---------------------------------" << endl;
     cout << "Tempo Total da pipeline:   " << tempoTotal.count() << " segundos\n" << endl;
-}
\ No newline at end of file
+    exibirQuarentena();
+}
+
+// Pipeline alimentado por stream: cada linha da entrada é um lote "<origem>\t<lista JSON de objetos>"
+void Pipeline::executarStream(istream& entrada)
+{
+    Extrator extrator;
+
+    executarLotes([&](pair<string, DataFrame>& item)
+    {
+        string linha;
+        if (!getline(entrada, linha)) return false;
+
+        size_t tab = linha.find('\t');
+        if (tab == string::npos)
+            throw runtime_error("lote sem origem");
+
+        item.first = linha.substr(0, tab);
+        linha.erase(0, tab + 1);
+        item.second = extrator.carregarLote(linha);
+
+        Quarentena rejeitadas = extrator.retirarQuarentena();
+        guardarQuarentena(item.first, rejeitadas);
+        return true;
+    }, "stream");
+}
+
+// Pipeline alimentado por produtores locais via memória compartilhada (canal criado aqui)
+void Pipeline::executarShm(const string& nomeCanal)
+{
+    ConsumidorShm canal(nomeCanal);
+
+    executarLotes([&](pair<string, DataFrame>& item)
+    {
+        return canal.receber(item.first, item.second);
+    }, "memória compartilhada");
+}
+
+// Atalhos com uma instância própria por chamada
+void executarPipeline(int numConsumidores, const string& arquivoOmsJson, const string& arquivoSecretariaJson, const string& arquivoHospitalJson)
+{
+    ConfigPipeline config;
+    config.numConsumidores = numConsumidores;
+    Pipeline(config).executar(arquivoOmsJson, arquivoSecretariaJson, arquivoHospitalJson);
+}
+
+void executarPipelineLotes(int numConsumidores, FonteLotes proximoLote, const string& nomeFonte)
+{
+    ConfigPipeline config;
+    config.numConsumidores = numConsumidores;
+    Pipeline(config).executarLotes(move(proximoLote), nomeFonte);
+}
+
+void executarPipelineStream(int numConsumidores, istream& entrada)
+{
+    ConfigPipeline config;
+    config.numConsumidores = numConsumidores;
+    Pipeline(config).executarStream(entrada);
+}
+
+void executarPipelineShm(int numConsumidores, const string& nomeCanal)
+{
+    ConfigPipeline config;
+    config.numConsumidores = numConsumidores;
+    Pipeline(config).executarShm(nomeCanal);
+}
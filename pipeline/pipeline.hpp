@@ -3,13 +3,211 @@
 
 #include <string>
 #include <vector>
+#include <istream>
+#include <functional>
+#include <utility>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include "../etl/dataframe.hpp"
+#include "../etl/juncao.hpp"
+#include "../etl/loader.hpp"
+#include "../etl/validacao.hpp"
+#include "../etl/quarentena.hpp"
+#include "../etl/deduplicacao.hpp"
+#include "fila.hpp"
+#include "metricas.hpp"
+#include "autoescala.hpp"
 
 using std::string;
 
-// Declara as funções utilizadas no pipeline
+// Fonte de lotes já extraídos (origem, dados); devolve false quando não há mais lotes
+using FonteLotes = std::function<bool(std::pair<std::string, DataFrame>&)>;
 
-// Função que será chamada para iniciar o pipeline de extração com threads
-void executarPipeline(int numConsumidores, const string&, const string&, const string&);
+// Configuração de uma instância do pipeline
+struct ConfigPipeline {
+    int numConsumidores = 4;                       // threads por estágio (padrão dos campos abaixo)
+    std::string diretorioSaida = "database_loader"; // onde o loader grava os CSVs
+    bool exibirTempos = true;                       // imprime a análise de tempo ao final
+
+    // workers de cada estágio (0 = numConsumidores)
+    int workersExtracao = 0;
+    int workersTratamento = 0;
+    int workersMerge = 0;
+    int workersLoader = 0;
+    // threads pedidas aos kernels dos tratadores em cada chamada (0 = numConsumidores)
+    int threadsKernel = 0;
+
+    // autoescala (modo por arquivos): os workers por estágio viram o ponto de partida e um controlador
+    // move workers entre extração, tratamento, merge e loader pela fila de entrada e pelo tempo de serviço
+    bool autoescala = false;
+    int orcamentoNucleos = 0;        // soma máxima de workers ativos (0 = núcleos da máquina)
+    int intervaloAutoescalaMs = 20;  // intervalo entre as decisões do controlador
+
+    // fixa os workers e o pool dos tratadores em domínios L3 lidos de /sys/devices/system/cpu (cada
+    // estágio fica num domínio por socket; o DataFrame é tratado no socket que o extraiu). Com um único
+    // domínio (um socket, container) não muda nada
+    bool fixarCpus = false;
+
+    // poda por ilha (modo por arquivos): os filtros de Bloom das chaves de OMS e secretaria vão para a extração
+    // do hospital, que descarta na leitura as linhas de ilhas sem dados em nenhuma das duas, e os tratadores
+    // conferem as que passaram. Muda as saídas (essas linhas deixam de existir em todas), por isso é opcional
+    bool podarPorIlha = false;
+
+    // capacidade das filas entre estágios: com a fila cheia o estágio anterior espera (backpressure)
+    size_t capacidadeFilaArquivos = 64;
+    size_t capacidadeFilaExtraidos = 16;
+    size_t capacidadeFilaLoader = 16;
+    // lotes aguardando tratamento na ingestão por stream (segura o remetente mais cedo)
+    size_t capacidadeLotesStream = 8;
+
+    // snapshot das métricas por estágio (vazio = não grava); .prom/.txt em formato Prometheus, senão JSON
+    std::string arquivoMetricas;
+    // intervalo entre snapshots durante a execução (0 = só o snapshot final)
+    int intervaloMetricasMs = 0;
+
+    // regras de validação por fonte (<fonte>.json, ver etl/validacao.hpp), lidas e compiladas na construção;
+    // fontes sem arquivo de regras usam a inferência por amostra
+    std::string diretorioRegras = "regras";
+
+    // linha do tempo Chrome trace_event da execução (vazio = não grava; exige compilar com make TRACE=1)
+    std::string arquivoTrace;
+};
+
+// Tempos da última execução (segundos)
+struct TemposPipeline {
+    double extracao = 0;
+    double tratamento = 0;
+    double loader = 0;
+    double merge = 0;
+    double total = 0;
+};
+
+// Pipeline ETL com estado próprio (filas, workers e configuração): várias instâncias podem rodar
+// ao mesmo tempo no mesmo processo (regiões ou semanas diferentes), todas usando o mesmo
+// Executor::global() para os kernels dos tratadores. Uma instância executa uma carga por vez.
+class Pipeline {
+public:
+    explicit Pipeline(ConfigPipeline config = ConfigPipeline());
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // Pipeline por arquivos: grafo de estágios com o ramo de merge rodando junto do tratamento
+    void executar(const string& arquivoOmsJson, const string& arquivoSecretariaJson, const string& arquivoHospitalJson);
+
+    // Pipeline genérico alimentado por lotes: trata cada lote assim que chega e finaliza os agregados no fim
+    void executarLotes(FonteLotes proximoLote, const string& nomeFonte);
+
+    // Pipeline alimentado por stream: cada linha da entrada é um lote "<origem>\t<lista JSON de objetos>"
+    void executarStream(std::istream& entrada);
+
+    // Pipeline alimentado por produtores locais via memória compartilhada (ver canal_shm.hpp)
+    void executarShm(const string& nomeCanal);
+
+    const ConfigPipeline& getConfig() const { return config; }
+    const TemposPipeline& getTempos() const { return tempos; }
+    const RegistroMetricas& getMetricas() const { return metricas; }
 
-// Funções produtor e consumidor (podem ser usadas para testes ou extensões)
-void produtor(const std::vector<std::string>& arquivos, bool);
\ No newline at end of file
+private:
+    // totais parciais acumulados entre os lotes de uma mesma saída
+    struct AgregadoParcial {
+        string colGrupo;
+        string colTotal;
+        std::unordered_map<string, double> totais;
+    };
+
+    // agregado de uma fonte consumido pelo ramo de merge, publicado uma vez pela extração já como tabela de
+    // junção imutável, compartilhada (só leitura) por todos os workers de merge
+    struct Dimensao {
+        std::promise<std::shared_ptr<const TabelaJuncao>> promessa;
+        std::shared_future<std::shared_ptr<const TabelaJuncao>> valor;
+        std::atomic<bool> publicada{false};
+
+        // tabela da última execução e a versão do arquivo de que ela saiu (caminho, data e tamanho)
+        std::mutex cacheMtx;
+        std::shared_ptr<const TabelaJuncao> tabela;
+        string versao;
+    };
+
+    // estágios (cada worker roda uma destas funções)
+    void produtor(const std::vector<string>& arquivos);
+    void consumidorExtrator(int id, int numThreads);
+    void consumidorTrat(int id, string meanCol, string groupedCol, string aggCol, int numThreads);
+    void consumidorMerge(int id, const string& cepColName, const string& colB, const string& colC, int numThreads);
+    void consumidorLoader(int id);
+    void produtorLotes(FonteLotes proximoLote);
+    void consumidorTratStream(int id, int numThreads);
+
+    void observarFilas();
+    // número efetivo de workers de um estágio e de threads dos kernels
+    int workers(int porEstagio) const { return porEstagio > 0 ? porEstagio : config.numConsumidores; }
+    int threadsKernel() const { return workers(config.threadsKernel); }
+    // com autoescala, espera o worker id ter vaga no estágio (sempre true sem autoescala)
+    bool temVaga(const string& estagio, int id);
+    // com fixarCpus, prende o worker id do estágio (índice na ordem do grafo) ao seu domínio L3
+    void posicionarWorker(int estagio, int id);
+    void acumularParcial(const string& saida, const DataFrame& parcial);
+    static DataFrame materializarParcial(const AgregadoParcial& acumulado);
+
+    // esquema de validação da origem (primeira fonte contida no nome); nullptr = inferência por amostra
+    const EsquemaValidacao* esquemaDe(const string& origem) const;
+
+    // cria o diretório de saída e apaga as quarentenas da execução anterior
+    void prepararSaida();
+    // linhas rejeitadas de uma origem: contadas nas métricas e gravadas em quarentena_<fonte>.csv. No modo
+    // por arquivos vão direto ao loader (que acrescenta ao arquivo); por lotes ficam guardadas até o fim,
+    // quando os loaders rodam
+    void entregarQuarentena(const string& origem, Quarentena& quarentena, int id);
+    void guardarQuarentena(const string& origem, Quarentena& quarentena);
+    void exibirQuarentena() const;
+
+    ConfigPipeline config;
+    TemposPipeline tempos;
+    std::vector<EsquemaValidacao> esquemas;
+    RegistroMetricas metricas;
+
+    // vagas por estágio da execução atual (vazio sem autoescala)
+    std::map<string, VagasEstagio*> vagas;
+
+    // filas entre estágios
+    FilaLimitada<string> filaArquivos;
+    FilaLimitada<std::pair<string, DataFrame>> extratorTratadorFila;
+    FilaLimitada<DataFrame> extratMergeFila;
+    FilaLimitada<LoaderItem> tratadorLoaderFila;
+
+    // agregados de OMS e secretaria para o merge
+    Dimensao dimOms;
+    Dimensao dimSecretaria;
+    void publicarDimensao(Dimensao& dimensao, const string& arquivo, const std::function<DataFrame()>& agregar, int numThreads);
+    void fecharDimensao(Dimensao& dimensao);
+    void fecharDimensoes();
+    Dimensao* dimensaoDoArquivo(const string& arquivo);
+
+    // socket em que cada arquivo foi extraído (só com fixarCpus e mais de um socket)
+    std::map<string, int> socketExtracao;
+    std::mutex socketExtracaoMtx;
+
+    std::map<string, AgregadoParcial> agregadosStream;
+    std::mutex agregadosMtx;
+
+    // quarentenas por fonte guardadas no modo por lotes; o mutex também serializa os acréscimos do loader
+    std::map<string, Quarentena> quarentenasLotes;
+    std::mutex quarentenaMtx;
+
+    // linhas já vistas por fonte no modo por lotes: uma linha repetida em outro lote (ou um arquivo
+    // reenviado) sai antes do tratamento
+    std::map<string, std::unique_ptr<DeduplicacaoEntreLotes>> deduplicacaoLotes;
+    std::mutex deduplicacaoMtx;
+    DeduplicacaoEntreLotes& deduplicacaoDe(const string& origem);
+};
+
+// Atalhos que rodam uma instância com a configuração padrão e numConsumidores threads por estágio
+void executarPipeline(int numConsumidores, const string&, const string&, const string&);
+void executarPipelineLotes(int numConsumidores, FonteLotes proximoLote, const std::string& nomeFonte);
+void executarPipelineStream(int numConsumidores, std::istream& entrada);
+void executarPipelineShm(int numConsumidores, const std::string& nomeCanal);
@@ -18,6 +18,53 @@ arquivos_recebidos = {}
 lock = threading.Lock()
 inicio_pipeline = None
 
+# Estado da ingestão por stream: um processo do pipeline por rodada, alimentado pela entrada padrão
+processo_stream = None
+origens_concluidas = set()
+lock_stream = threading.Lock()
+inicio_stream = None
+
+def limpar_stream():
+    # Descarta o processo da rodada atual (chamar com lock_stream)
+    global processo_stream, inicio_stream
+    processo_stream = None
+    inicio_stream = None
+    origens_concluidas.clear()
+
+def linha_para_dict(linha):
+    if linha.HasField("linha_oms"):
+        return {
+            "num_obitos": linha.linha_oms.num_obitos,
+            "populacao": linha.linha_oms.populacao,
+            "cep": linha.linha_oms.cep,
+            "num_recuperados": linha.linha_oms.num_recuperados,
+            "num_vacinados": linha.linha_oms.num_vacinados,
+            "data": linha.linha_oms.data
+        }
+    elif linha.HasField("linha_hospital"):
+        return {
+            "id_hospital": linha.linha_hospital.id_hospital,
+            "data": linha.linha_hospital.data,
+            "internado": linha.linha_hospital.internado,
+            "idade": linha.linha_hospital.idade,
+            "sexo": linha.linha_hospital.sexo,
+            "cep": linha.linha_hospital.cep,
+            "sintoma1": int(linha.linha_hospital.sintoma1),
+            "sintoma2": int(linha.linha_hospital.sintoma2),
+            "sintoma3": int(linha.linha_hospital.sintoma3),
+            "sintoma4": int(linha.linha_hospital.sintoma4)
+        }
+    elif linha.HasField("linha_secretaria"):
+        return {
+            "diagnostico": int(linha.linha_secretaria.diagnostico),
+            "vacinado": int(linha.linha_secretaria.vacinado),
+            "cep": linha.linha_secretaria.cep,
+            "escolaridade": linha.linha_secretaria.escolaridade,
+            "populacao": linha.linha_secretaria.populacao,
+            "data": linha.linha_secretaria.data
+        }
+    return None
+
 class PipelineServicer(etl_pb2_grpc.ETLServiceServicer):
     def EnviarDados(self, request, context):
         global inicio_pipeline
@@ -28,40 +75,7 @@ class PipelineServicer(etl_pb2_grpc.ETLServiceServicer):
         if origem not in TIPOS_ESPERADOS:
             return etl_pb2.DadosResponse(mensagem=f"Origem inválida: {origem}")
 
-        linhas_json = []
-
-        for linha in dados:
-            if linha.HasField("linha_oms"):
-                linhas_json.append({
-                    "num_obitos": linha.linha_oms.num_obitos,
-                    "populacao": linha.linha_oms.populacao,
-                    "cep": linha.linha_oms.cep,
-                    "num_recuperados": linha.linha_oms.num_recuperados,
-                    "num_vacinados": linha.linha_oms.num_vacinados,
-                    "data": linha.linha_oms.data
-                })
-            elif linha.HasField("linha_hospital"):
-                linhas_json.append({
-                    "id_hospital": linha.linha_hospital.id_hospital,
-                    "data": linha.linha_hospital.data,
-                    "internado": linha.linha_hospital.internado,
-                    "idade": linha.linha_hospital.idade,
-                    "sexo": linha.linha_hospital.sexo,
-                    "cep": linha.linha_hospital.cep,
-                    "sintoma1": int(linha.linha_hospital.sintoma1),
-                    "sintoma2": int(linha.linha_hospital.sintoma2),
-                    "sintoma3": int(linha.linha_hospital.sintoma3),
-                    "sintoma4": int(linha.linha_hospital.sintoma4)
-                })
-            elif linha.HasField("linha_secretaria"):
-                linhas_json.append({
-                    "diagnostico": int(linha.linha_secretaria.diagnostico),
-                    "vacinado": int(linha.linha_secretaria.vacinado),
-                    "cep": linha.linha_secretaria.cep,
-                    "escolaridade": linha.linha_secretaria.escolaridade,
-                    "populacao": linha.linha_secretaria.populacao,
-                    "data": linha.linha_secretaria.data
-                })
+        linhas_json = [linha_para_dict(linha) for linha in dados]
 
         with lock:
             dados_agrupados[origem].extend(linhas_json)
@@ -114,6 +128,79 @@ class PipelineServicer(etl_pb2_grpc.ETLServiceServicer):
 
         return etl_pb2.DadosResponse(mensagem=mensagem)
 
+    def EnviarDadosStream(self, request_iterator, context):
+        global processo_stream, inicio_stream
+        origens_enviadas = set()
+        total = 0
+        lotes = 0
+        erro = None
+
+        # Cada lote é repassado ao pipeline assim que chega, sem acumular o arquivo em memória
+        for lote in request_iterator:
+            origem = lote.origem.lower()
+            if origem not in TIPOS_ESPERADOS:
+                # os lotes válidos já enviados continuam valendo: a origem deles é concluída abaixo
+                erro = f"Origem inválida: {origem}"
+                break
+
+            linhas_json = [linha_para_dict(linha) for linha in lote.dados]
+
+            with lock_stream:
+                if processo_stream is None:
+                    processo_stream = subprocess.Popen(["./programa.exe", "--stream"], stdin=subprocess.PIPE, text=True)
+                    inicio_stream = time.time()
+
+                # Se o pipeline estiver com a fila cheia, a escrita bloqueia quando o pipe enche,
+                # este stream para de ser lido e o controle de fluxo do gRPC segura o cliente
+                try:
+                    processo_stream.stdin.write(origem + "\t" + json.dumps(linhas_json) + "\n")
+                    processo_stream.stdin.flush()
+                except OSError as e:
+                    # o pipeline morreu: descarta o processo para que o próximo stream comece outro
+                    retorno = processo_stream.wait()
+                    limpar_stream()
+                    return etl_pb2.DadosResponse(
+                        mensagem=f"Pipeline encerrado durante o stream (código {retorno}): {e}")
+
+            origens_enviadas.add(origem)
+            total += len(linhas_json)
+            lotes += 1
+
+        tipos = ", ".join(sorted(origens_enviadas))
+        mensagem = f"Recebido {total} registros do tipo {tipos} em {lotes} lotes." if lotes else "Nenhum lote recebido."
+        if erro:
+            mensagem = f"{erro}. {mensagem}"
+
+        # só conclui origens que tiveram algum lote enviado
+        if not origens_enviadas:
+            return etl_pb2.DadosResponse(mensagem=mensagem)
+
+        with lock_stream:
+            if processo_stream is None:
+                # o processo desta rodada falhou em outro stream e foi descartado
+                return etl_pb2.DadosResponse(mensagem=mensagem + " Pipeline encerrado antes do fim da rodada.")
+
+            origens_concluidas.update(origens_enviadas)
+
+            # Quando todas as origens terminaram, fecha a entrada e espera o pipeline concluir
+            if TIPOS_ESPERADOS <= origens_concluidas:
+                try:
+                    processo_stream.stdin.close()
+                except OSError:
+                    pass
+                retorno = processo_stream.wait()
+                duracao = time.time() - inicio_stream
+                if retorno == 0:
+                    print(f"Tempo de latência dos clientes (stream): {duracao:.2f} segundos.")
+                    mensagem += f" Pipeline executada com sucesso em {duracao:.2f} segundos."
+                else:
+                    mensagem += f" Erro ao executar pipeline: código {retorno}"
+
+                # Limpa estado para próxima rodada
+                limpar_stream()
+
+        return etl_pb2.DadosResponse(mensagem=mensagem)
+
 def serve():
     server = grpc.server(futures.ThreadPoolExecutor(max_workers=10))
     etl_pb2_grpc.add_ETLServiceServicer_to_server(PipelineServicer(), server)
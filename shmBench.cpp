@@ -0,0 +1,163 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "json.hpp"
+#include "etl/extrator.hpp"
+#include "pipeline/canal_shm.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+// Compara a entrega de linhas hospitalares ao estágio de extração por arquivo JSON
+// e pelo canal em memória compartilhada (produtor em outro processo).
+// O canal é medido duas vezes: com o produtor enviando tudo de uma vez (vazão; o anel enche e
+// a latência medida inclui a espera na fila) e com o produtor espaçando os lotes, de modo que o
+// anel nunca acumula e a latência é só a entrega de um lote.
+// Uso: ./shmBench [numLinhas] [intervaloUs]  (intervaloUs padrão: o dobro do tempo por lote da vazão)
+
+static int64_t agoraNs()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// linhas sintéticas com a mesma distribuição do client.py
+vector<LinhaHospitalBin> gerarLinhas(size_t n)
+{
+    mt19937 gerador(42);
+    auto sortear = [&](int a, int b) { return uniform_int_distribution<int>(a, b)(gerador); };
+
+    vector<LinhaHospitalBin> linhas(n);
+    for (auto& l : linhas)
+    {
+        memset(&l, 0, sizeof(l));
+        l.id_hospital = sortear(1, 5);
+        snprintf(l.data, sizeof(l.data), "%02d-05-2025", sortear(1, 7));
+        l.internado = sortear(0, 1);
+        l.idade = sortear(0, 100);
+        l.sexo = sortear(0, 1);
+        l.cep = sortear(11, 30) * 1000 + sortear(1, 5);
+        l.sintoma1 = sortear(0, 1);
+        l.sintoma2 = sortear(0, 1);
+        l.sintoma3 = sortear(0, 1);
+        l.sintoma4 = sortear(0, 1);
+    }
+    return linhas;
+}
+
+// Envia as linhas por um canal novo a partir de um processo filho. Com intervaloUs > 0 o produtor
+// envia um lote por vez e espera entre eles; a latência de cada lote vai para latenciasUs.
+// Devolve o número de linhas recebidas.
+size_t medirCanal(const vector<LinhaHospitalBin>& linhas, int intervaloUs, vector<double>& latenciasUs)
+{
+    const string nomeCanal = "/etl_bench_" + to_string(getpid());
+    ConsumidorShm canal(nomeCanal);
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        try {
+            ProdutorShm produtor(nomeCanal);
+            if (intervaloUs <= 0)
+                produtor.enviar(linhas);
+            else
+            {
+                const size_t porLote = produtor.linhasPorLote(OrigemShm::HOSPITAL);
+                for (size_t i = 0; i < linhas.size(); i += porLote)
+                {
+                    produtor.enviar(vector<LinhaHospitalBin>(linhas.begin() + i,
+                        linhas.begin() + min(linhas.size(), i + porLote)));
+                    this_thread::sleep_for(chrono::microseconds(intervaloUs));
+                }
+            }
+            produtor.fechar();
+        } catch (const exception& e) {
+            cerr << "[Produtor] " << e.what() << endl;
+            _exit(1);
+        }
+        _exit(0);
+    }
+
+    size_t recebidas = 0;
+    string origem;
+    DataFrame lote({"ID"}, {});
+    while (canal.receber(origem, lote))
+    {
+        latenciasUs.push_back((agoraNs() - canal.ultimoEnvioNs()) / 1000.0);
+        recebidas += lote.size();
+    }
+    waitpid(pid, nullptr, 0);
+    sort(latenciasUs.begin(), latenciasUs.end());
+    return recebidas;
+}
+
+// "p50 x | p99 y | máx z" de latências já ordenadas
+string resumoLatencias(const vector<double>& latenciasUs)
+{
+    if (latenciasUs.empty())
+        return "sem lotes";
+    auto percentil = [&](double p) {
+        return latenciasUs[min(latenciasUs.size() - 1, size_t(p * latenciasUs.size()))];
+    };
+    return "p50 " + to_string(percentil(0.50)) + " | p99 " + to_string(percentil(0.99))
+         + " | máx " + to_string(latenciasUs.back());
+}
+
+int main(int argc, char* argv[])
+{
+    size_t numLinhas = argc > 1 ? stoul(argv[1]) : 200000;
+    vector<LinhaHospitalBin> linhas = gerarLinhas(numLinhas);
+
+    // ---- Caminho por arquivo: o produtor grava o JSON e a extração lê o arquivo inteiro ----
+    const string arquivo = "bench_hospital.json";
+    auto inicio = chrono::steady_clock::now();
+    {
+        json j = json::array();
+        for (const auto& l : linhas)
+        {
+            j.push_back({{"id_hospital", l.id_hospital}, {"data", string(l.data)}, {"internado", l.internado},
+                         {"idade", l.idade}, {"sexo", l.sexo}, {"cep", l.cep}, {"sintoma1", l.sintoma1},
+                         {"sintoma2", l.sintoma2}, {"sintoma3", l.sintoma3}, {"sintoma4", l.sintoma4}});
+        }
+        ofstream saida(arquivo);
+        saida << j;
+    }
+    Extrator extrator;
+    DataFrame dfArquivo = extrator.carregar(arquivo);
+    chrono::duration<double> tempoArquivo = chrono::steady_clock::now() - inicio;
+    remove(arquivo.c_str());
+
+    // ---- Canal em memória compartilhada: produtor em outro processo, lotes entregues assim que escritos ----
+    vector<double> latenciasCheio;
+    inicio = chrono::steady_clock::now();
+    size_t recebidas = medirCanal(linhas, 0, latenciasCheio);
+    chrono::duration<double> tempoShm = chrono::steady_clock::now() - inicio;
+
+    // ---- Mesmo canal com o produtor espaçando os lotes: latência de entrega sem fila ----
+    // por padrão o intervalo é o dobro do tempo médio que o consumidor leva por lote, para o anel não acumular
+    int intervaloUs = argc > 2 ? stoi(argv[2])
+        : int(2e6 * tempoShm.count() / max<size_t>(1, latenciasCheio.size()));
+    vector<double> latenciasEspacado;
+    medirCanal(linhas, intervaloUs, latenciasEspacado);
+
+    cout << "\n=== Entrega de " << numLinhas << " linhas ao estágio de extração ===" << endl;
+    cout << "Arquivo JSON:          " << tempoArquivo.count() << " segundos (" << dfArquivo.size()
+         << " linhas; primeiro dado disponível só após o arquivo inteiro)" << endl;
+    cout << "Memória compartilhada: " << tempoShm.count() << " segundos (" << recebidas << " linhas em "
+         << latenciasCheio.size() << " lotes)" << endl;
+    cout << "Latência sob acúmulo (us, anel cheio; inclui a espera na fila): "
+         << resumoLatencias(latenciasCheio) << endl;
+    cout << "Latência de entrega, com a conversão em DataFrame (us, um lote a cada " << intervaloUs << " us): "
+         << resumoLatencias(latenciasEspacado) << endl;
+
+    return 0;
+}
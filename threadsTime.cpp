@@ -1,31 +1,73 @@
 #include <iostream>
 #include <chrono>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <string>
 #include "pipeline/pipeline.hpp"
 #include "etl/dashboard.hpp"
-#include "etl/dashboard.hpp"
 
 
 #include <filesystem>
 
 using namespace std;
 
-int main() {
-    
+// Uso: ./threadsTime [oms.json secretaria.json hospital.json]
+int main(int argc, char* argv[]) {
+    string arquivoOms = argc == 4 ? argv[1] : "oms.json";
+    string arquivoSecretaria = argc == 4 ? argv[2] : "secretaria.json";
+    string arquivoHospital = argc == 4 ? argv[3] : "hospital.json";
+
+    // ---- Tempo da pipeline variando o número de consumidores por estágio ----
     int vezes = 1;
-    for (int n = 1; n <= 12; n += 1) 
+    for (int n = 1; n <= 12; n += 1)
     {   cout << "\n--- Testando com " << n << " consumidor(es) ---\n";
 
         for (int j = 0; j < vezes; j++)
-        {            
-            executarPipeline(n);  // Pipeline com n consumidores
+        {
+            ConfigPipeline config;
+            config.numConsumidores = n;  // Pipeline com n consumidores
+            Pipeline(config).executar(arquivoOms, arquivoSecretaria, arquivoHospital);
         }
     }
 
+    // ---- Várias pipelines independentes (ex.: regiões) em sequência e ao mesmo tempo ----
+    const int numPipelines = 4;
+    vector<unique_ptr<Pipeline>> pipelines;
+    for (int k = 0; k < numPipelines; ++k)
+    {
+        ConfigPipeline config;
+        config.numConsumidores = 2;
+        config.exibirTempos = false;
+        config.diretorioSaida = "database_loader/regiao_" + to_string(k);
+        pipelines.push_back(make_unique<Pipeline>(config));
+    }
+
+    auto inicio = chrono::high_resolution_clock::now();
+    for (auto& p : pipelines) p->executar(arquivoOms, arquivoSecretaria, arquivoHospital);
+    chrono::duration<double> tempoSerial = chrono::high_resolution_clock::now() - inicio;
+
+    inicio = chrono::high_resolution_clock::now();
+    vector<thread> execucoes;
+    for (auto& p : pipelines)
+    {
+        execucoes.emplace_back([&, pipeline = p.get()] {
+            pipeline->executar(arquivoOms, arquivoSecretaria, arquivoHospital);
+        });
+    }
+    for (auto& t : execucoes) t.join();
+    chrono::duration<double> tempoConcorrente = chrono::high_resolution_clock::now() - inicio;
+
+    cout << "\n=== " << numPipelines << " pipelines independentes ===" << endl;
+    cout << "Em sequência:    " << tempoSerial.count() << " segundos" << endl;
+    cout << "Ao mesmo tempo:  " << tempoConcorrente.count() << " segundos" << endl;
+    cout << "Ganho de vazão:  " << tempoSerial.count() / tempoConcorrente.count() << "x" << endl;
+
     cout << "========== DASHBOARD ILHAS ==========\n";
 
     // ANÁLISE 1: Alertas semanais por CEP
     cout << "\n>> Análise 1: Alertas semanais por CEP\n";
-    exibirAlertasTratados("database_loader/saida_tratada_oms04.csv");
+    exibirAlertasTratados("database_loader/saida_tratada_oms.csv");
 
     // ANÁLISE 2: Estatísticas gerais de internados (média e desvio padrão)
     cout << "\n>> Análise 2: Estatísticas gerais dos hospitais\n";
@@ -44,4 +86,4 @@ int main() {
     cout << "\n============ FIM DO DASHBOARD ============\n";
 
     return 0;
-}
\ No newline at end of file
+}